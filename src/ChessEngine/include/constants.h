@@ -9,6 +9,8 @@
 #ifndef CHESS_ENGINE_CONSTANTS_H
 #define CHESS_ENGINE_CONSTANTS_H
 
+#include <cstddef>
+
 namespace luna {
 
 // Search Constants
@@ -22,6 +24,23 @@ constexpr int DRAW_SCORE = 0;                   // Draw score
 constexpr int DEFAULT_SEARCH_TIME_MS = 5000;   // Default search time in milliseconds
 constexpr int MIN_SEARCH_TIME_MS = 100;         // Minimum search time
 constexpr int CHECK_FREQUENCY = 2048;           // Check time every N nodes
+constexpr int MOVE_OVERHEAD_MS = 30;            // Kept back from the clock for communication lag
+constexpr int DEFAULT_MOVES_TO_GO = 30;         // Moves the clock is spread over without movestogo
+constexpr int MAX_MOVES_TO_GO = 50;
+constexpr int INCREMENT_USE_PERCENT = 75;       // Share of the increment spent on each move
+constexpr int HARD_LIMIT_SOFT_MULTIPLE = 4;     // Hard limit is at most this many soft limits...
+constexpr int HARD_LIMIT_MAX_PERCENT = 75;      // ...and at most this share of the clock
+
+// Soft limit scaling, in percent, by completed iterations in a row with
+// the same best move (0 right after it changed)
+constexpr int STABILITY_SCALE_PERCENT[5] = { 140, 110, 90, 80, 70 };
+constexpr int SCORE_DROP_CP_PER_PERCENT = 2;    // Soft limit grows 1% per this many centipawns lost...
+constexpr int MAX_SCORE_DROP_PERCENT = 50;      // ...up to this much
+
+// Next iteration time as a multiple of the last, in percent
+constexpr int DEFAULT_ITERATION_GROWTH_PERCENT = 200;
+constexpr int MIN_ITERATION_GROWTH_PERCENT = 150;
+constexpr int MAX_ITERATION_GROWTH_PERCENT = 400;
 
 
 // Evaluation Constants
@@ -32,6 +51,17 @@ constexpr int ROOK_VALUE = 500;                 // Rook material value
 constexpr int QUEEN_VALUE = 900;                // Queen material value
 constexpr int KING_VALUE = 20000;               // King value (for safety)
 
+// Game phase for tapered evaluation: the sum of these weights over the
+// pieces on the board, MAX_PHASE in the opening and 0 with only pawns left
+constexpr int KNIGHT_PHASE = 1;
+constexpr int BISHOP_PHASE = 1;
+constexpr int ROOK_PHASE = 2;
+constexpr int QUEEN_PHASE = 4;
+constexpr int MAX_PHASE = 24;
+
+// Material values indexed by PieceType
+constexpr int PIECE_VALUES[6] = { PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_VALUE };
+
 // Positional Bonuses/Penalties
 constexpr int DOUBLED_PAWN_PENALTY = 15;        // Penalty for doubled pawns
 constexpr int ISOLATED_PAWN_PENALTY = 25;       // Penalty for isolated pawns
@@ -49,6 +79,7 @@ constexpr int WINNING_CAPTURE_SCORE = 10000;    // Base score for winning captur
 constexpr int PROMOTION_SCORE = 9500;           // Base score for promotions
 constexpr int KILLER_MOVE_1_SCORE = 8000;       // Score for first killer move
 constexpr int KILLER_MOVE_2_SCORE = 7000;       // Score for second killer move
+constexpr int COUNTERMOVE_SCORE = 6000;         // Score for the quiet reply to the previous move
 constexpr int LOSING_CAPTURE_SCORE = -500;      // Score for losing captures
 
 // MVV-LVA (Most Valuable Victim - Least Valuable Attacker) Scores
@@ -66,26 +97,46 @@ constexpr int MVV_LVA_OFFSET[6][6] = {
 // Search Parameters
 constexpr int DEFAULT_SEARCH_DEPTH = 12;        // Default search depth 
 constexpr int MAX_SEARCH_DEPTH = 30;            // Maximum allowed search depth
-constexpr int ENDGAME_MATERIAL_THRESHOLD = 1800; // Material threshold for endgame
+
+// Lazy SMP
+constexpr int DEFAULT_SEARCH_THREADS = 1;       // Search threads unless the Threads option is set
+constexpr int MAX_SEARCH_THREADS = 256;         // Upper bound for the Threads option
+constexpr int SMP_VOTE_BASE = 14;               // Vote weight of the lowest scoring thread, per depth
+
+// Helper thread iteration skipping. Helper i uses entry (i - 1) % 20 and skips
+// depth d when ((d + phase) / size) is odd, so helpers spread over depths.
+constexpr int SMP_SKIP_TABLE_SIZE = 20;
+constexpr int SMP_SKIP_SIZE[SMP_SKIP_TABLE_SIZE]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+constexpr int SMP_SKIP_PHASE[SMP_SKIP_TABLE_SIZE] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
 
 // History Heuristic - Optimized for better move ordering
-constexpr int HISTORY_MAX = 4000;               // Maximum history value
-constexpr int HISTORY_DIVISOR = 2;              // Divisor when history gets too large
+constexpr int HISTORY_MAX = 4000;               // Maximum history value (gravity bound)
+constexpr int HISTORY_DIVISOR = 2;              // History is divided by this between searches
 
 // Transposition Table Constants
 constexpr size_t DEFAULT_HASH_SIZE_MB = 64;         // Default hash table size in MB
 constexpr size_t MIN_HASH_SIZE_MB = 1;              // Minimum hash table size in MB
-constexpr size_t MAX_HASH_SIZE_MB = 1024;           // Maximum hash table size in MB
+constexpr size_t MAX_HASH_SIZE_MB = 65536;          // Maximum hash table size in MB
+constexpr size_t PERFT_HASH_SIZE_MB = 16;           // Perft transposition table size in MB
+constexpr size_t DEFAULT_EVAL_CACHE_MB = 4;         // Evaluation cache size per thread in MB
+constexpr size_t MAX_EVAL_CACHE_MB = 1024;          // Upper bound for the EvalCache option (0 disables)
 constexpr int TT_MOVE_SCORE = 15000;                // Score for TT best move (higher than captures)
 constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY;    // Mate score boundary for TT storage
 
-// Null Move Pruning (for future implementation)
+// Aspiration Windows
+constexpr int ASPIRATION_MIN_DEPTH = 4;         // First depth searched with a window
+constexpr int ASPIRATION_WINDOW = 25;           // Initial half-width around the last score
+
+// Null Move Pruning
 constexpr int NULL_MOVE_REDUCTION = 3;          // Depth reduction for null move
 constexpr int NULL_MOVE_MIN_DEPTH = 2;          // Minimum depth for null move
+constexpr int NULL_MOVE_VERIFY_DEPTH = 8;       // Verify null move cutoffs from this depth
 
-// Late Move Reductions (for future implementation)
+// Late Move Reductions
 constexpr int LMR_MIN_DEPTH = 2;                // Minimum depth for LMR
 constexpr int LMR_MOVE_COUNT_THRESHOLD = 3;     // Apply LMR after N moves
+constexpr double LMR_BASE = 0.75;               // Reduction = base + ln(depth) * ln(moves) / divisor
+constexpr double LMR_DIVISOR = 2.25;
 
 // Debug and Display
 constexpr bool DISPLAY_SEARCH_INFO = true;      // Show search information
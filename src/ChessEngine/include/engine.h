@@ -2,6 +2,13 @@
     Main chess engine interface.
     Coordinates search, evaluation, and time management.
 
+    UPDATE: Runs a Lazy SMP search over a configurable number of threads
+    that share one transposition table.
+    UPDATE: Null move pruning and late move reductions can be toggled.
+    UPDATE: Sizes the per-thread evaluation caches.
+    UPDATE: Loads an NNUE network shared by every thread's evaluator.
+    UPDATE: Searches can be budgeted from a UCI time control.
+
     Author: Nicolas Miller
     Date: 07/09/2025
 */
@@ -12,10 +19,13 @@
 #include "search.h"
 #include "evaluator.h"
 #include "time_manager.h"
+#include "transposition_table.h"
 #include "types.h"
 #include "position.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace luna 
 {
@@ -29,21 +39,75 @@ public:
     // Main interface - returns best move for position
     Move find_best_move(const Position& position, int time_ms = DEFAULT_SEARCH_TIME_MS);
     
+    // Search with the time budgeted from a UCI time control
+    Move find_best_move(const Position& position, const SearchLimits& limits);
+    
     // Configure engine parameters
     void set_max_depth(int depth);
     
-    // Get search information
+    // Set the number of search threads (main thread plus helpers). If
+    // their evaluation caches cannot all be allocated the threads run
+    // without one and std::bad_alloc is thrown.
+    void set_threads(int threads);
+    int threads() const { return static_cast<int>(searches_.size()); }
+    
+    // Resize the transposition table (clamped to the UCI limits). Throws
+    // std::bad_alloc if the memory is not available.
+    void set_hash_size(size_t size_mb);
+    size_t hash_size() const { return tt_->size_mb(); }
+    
+    // Empty the transposition table
+    void clear_hash();
+    
+    // Save the transposition table to a file / replace it with a saved one
+    bool save_hash(const std::string& path) const { return tt_->save(path); }
+    bool load_hash(const std::string& path) { return tt_->load(path, threads()); }
+    
+    // Enable or disable transposition table prefetching (for benchmarks)
+    void set_hash_prefetch(bool enabled) { tt_->set_prefetch(enabled); }
+    
+    // Enable or disable null move pruning / late move reductions on every thread
+    void set_null_move(bool enabled);
+    void set_lmr(bool enabled);
+    
+    // Enable or disable principal variation search and aspiration windows
+    void set_pvs(bool enabled);
+    
+    // Evaluate with the NNUE network in a file, or with the hand-written
+    // evaluation if the path is empty. Returns false and keeps the current
+    // evaluation if the file cannot be loaded.
+    bool set_eval_file(const std::string& path);
+    bool uses_network() const { return network_ != nullptr; }
+    
+    // Resize every thread's evaluation cache (clamped to MAX_EVAL_CACHE_MB; 0 disables).
+    // Throws std::bad_alloc, with every cache disabled, if the memory is not available.
+    void set_eval_cache_size(size_t size_mb);
+    
+    // Get search information for the chosen move, with nodes summed over threads
     const Search::SearchInfo& get_search_info() const;
     
     // Stop the current search
     void stop_search();
     
 private:
-    std::unique_ptr<Search>                 search_;
-    std::unique_ptr<Evaluator>              evaluator_;
-    std::unique_ptr<TimeManager>            time_manager_;
+    // Run the search once the time manager has been started
+    Move search(const Position& position);
+    
+    // Pick the move voted best across threads, weighted by score and depth
+    const Search* pick_best_thread() const;
+    
+    std::unique_ptr<TranspositionTable>         tt_;
+    std::unique_ptr<NnueNetwork>                network_;       // Shared by every evaluator; null for classical
+    std::vector<std::unique_ptr<Evaluator>>     evaluators_;    // One per thread
+    std::vector<std::unique_ptr<Search>>        searches_;      // Index 0 is the main thread
+    std::unique_ptr<TimeManager>                time_manager_;
     
+    Search::SearchInfo info_;
     int max_depth_;
+    bool null_move_;
+    bool lmr_;
+    bool pvs_;
+    size_t eval_cache_mb_;
 };
 
 } // namespace luna
@@ -0,0 +1,72 @@
+/*
+    Evaluation cache. A small direct-mapped table from Zobrist key to the
+    static evaluation, so positions reached again by transposition (most
+    often in quiescence stand-pat) are not evaluated twice. Each search
+    thread owns one through its Evaluator, so entries need no
+    synchronization.
+
+    Author: Nicolas Miller
+    Date: 08/16/2025
+*/
+
+#ifndef CHESS_ENGINE_EVAL_CACHE_H
+#define CHESS_ENGINE_EVAL_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace luna 
+{
+
+struct EvalCacheEntry 
+{
+    uint64_t key = 0;       // Zobrist key of the position
+    int score = 0;          // Static evaluation, side to move's perspective
+};
+
+class EvalCache 
+{
+public:
+    explicit EvalCache(size_t size_mb);
+    
+    // Look up a position. Empty slots have key 0, which no real position
+    // is expected to hash to.
+    bool probe(uint64_t key, int& score) const 
+    {
+        if (table_.empty()) return false;
+        
+        const EvalCacheEntry& entry = table_[key & mask_];
+        if (entry.key != key) return false;
+        score = entry.score;
+        return true;
+    }
+    
+    // Store a score, always replacing the slot
+    void store(uint64_t key, int score) 
+    {
+        if (table_.empty()) return;
+        
+        EvalCacheEntry& entry = table_[key & mask_];
+        entry.key = key;
+        entry.score = score;
+    }
+    
+    // Resize to the largest power-of-two entry count that fits in size_mb.
+    // A size of 0 disables the cache. If the memory cannot be allocated the
+    // cache is left disabled and std::bad_alloc is thrown.
+    void resize(size_t size_mb);
+    
+    void clear();
+    
+    size_t size_mb() const { return size_mb_; }
+    
+private:
+    std::vector<EvalCacheEntry> table_;
+    uint64_t mask_;
+    size_t size_mb_;
+};
+
+} // namespace luna
+
+#endif // CHESS_ENGINE_EVAL_CACHE_H
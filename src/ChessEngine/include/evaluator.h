@@ -3,6 +3,26 @@
     Evaluates chess positions based on material, piece placement, 
     pawn structure, king safety, and mobility.
 
+    UPDATE: Material and piece-square values are now summed incrementally
+    by Position (see psqt.h). evaluate() reads them in O(1) and tapers the
+    king between its middlegame and endgame tables by game phase instead
+    of switching at a material threshold.
+
+    UPDATE: Pawn structure terms are cached in a per-evaluator pawn hash
+    table keyed by Position::pawn_key(), and use precomputed file and
+    passed-pawn-span masks. Passed pawns now also require no enemy pawn
+    ahead on an adjacent file.
+    UPDATE: Whole evaluations are cached by Zobrist key, with hit and miss
+    counters for the search statistics.
+    UPDATE: Can evaluate with an NNUE network instead of the hand-written
+    terms (see nnue.h). The caches and statistics apply to both.
+    UPDATE: evaluate_batch scores many positions at once, computing the
+    mobility terms for several positions per vector instruction (see
+    eval_batch.h).
+    UPDATE: evaluate_batch takes BoardSnapshots. The terms other than
+    mobility are templates over the board type, so the same code scores a
+    Position and a snapshot.
+
     Author: Nicolas Miller
     Date: 07/09/2025
 */
@@ -12,6 +32,12 @@
 
 #include "types.h"
 #include "position.h"
+#include "pawn_hash.h"
+#include "eval_cache.h"
+#include "nnue_evaluator.h"
+#include "eval_batch.h"
+#include <cstdint>
+#include <memory>
 
 namespace luna 
 {
@@ -24,18 +50,30 @@ public:
     // Main evaluation function
     int evaluate(const Position& position);
     
+    // Evaluate count boards into scores, each exactly as evaluate() would
+    // score its position. For position sets such as EPD files and tuning
+    // data: the evaluation cache is neither read nor filled.
+    void evaluate_batch(const BoardSnapshot* boards, size_t count, int* scores);
+    
+    // Evaluate with a network (shared, must outlive the evaluator), or with
+    // the hand-written terms again if null
+    void set_network(const NnueNetwork* network);
+    bool uses_network() const { return nnue_ != nullptr; }
+    
+    // Resize the evaluation cache (0 disables it)
+    void set_cache_size(size_t size_mb) { eval_cache_.resize(size_mb); }
+    
+    // Evaluation cache statistics since the last reset
+    uint64_t cache_hits() const { return cache_hits_; }
+    uint64_t cache_misses() const { return cache_misses_; }
+    void reset_cache_stats() { cache_hits_ = 0; cache_misses_ = 0; }
+    
 private:
-    // Component evaluations
-    int evaluate_material(const Position& pos);
-    int evaluate_piece_squares(const Position& pos);
-    int evaluate_pawn_structure(const Position& pos);
-    int evaluate_king_safety(const Position& pos);
+    // Component evaluations. Board is Position or BoardSnapshot.
+    template <typename Board> int evaluate_pawn_structure(const Board& pos);
+    template <typename Board> int evaluate_king_safety(const Board& pos);
     int evaluate_mobility(const Position& pos);
-    int evaluate_piece_bonuses(const Position& pos);
-    
-    // Helper function for piece-square evaluation
-    void evaluate_piece_type_squares(const Position& pos, Color color, PieceType type,
-                                     const int table[64], int& score);
+    template <typename Board> int evaluate_piece_bonuses(const Board& pos);
     
     // Mobility helper functions
     int count_knight_moves(const Position& pos, Square sq);
@@ -43,16 +81,23 @@ private:
     int count_rook_moves(const Position& pos, Square sq);
     
     // Check if only kings remain (draw)
-    bool is_only_kings(const Position& pos);
-    
-    // Piece-square tables
-    static const int pawn_table[64];
-    static const int knight_table[64];
-    static const int bishop_table[64];
-    static const int rook_table[64];
-    static const int queen_table[64];
-    static const int king_middlegame_table[64];
-    static const int king_endgame_table[64];
+    template <typename Board> bool is_only_kings(const Board& pos);
+    
+    // Fill a pawn hash entry with the pawn structure terms of a position
+    template <typename Board> void compute_pawn_structure(const Board& pos, PawnEntry& entry);
+    
+    // Full evaluation behind the cache
+    int compute(const Position& position);
+    
+    // Hand-written evaluation given the mobility term, from the side to
+    // move's point of view
+    template <typename Board> int classical(const Board& position, int mobility);
+    
+    PawnHashTable pawn_table_;
+    EvalCache eval_cache_;
+    std::unique_ptr<NnueEvaluator> nnue_;
+    uint64_t cache_hits_;
+    uint64_t cache_misses_;
 };
 
 } // namespace luna
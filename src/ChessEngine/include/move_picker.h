@@ -0,0 +1,106 @@
+/*
+    Staged move picker for the search. Hands out moves one at a time so a
+    node that cuts off early never generates or sorts the moves it did not
+    need:
+        1. The transposition table move, checked for legality without
+           generating anything
+        2. Captures and promotions that do not lose material by static
+           exchange evaluation, selected best-first by MVV-LVA
+        3. The two killers and the countermove, if legal here
+        4. Quiet moves, generated and sorted by history only if still needed
+        5. The losing captures put aside in stage 2
+    In check, every evasion is generated at once and selected best-first.
+    Quiescence search uses stage 2 only, so losing captures are pruned.
+
+    Author: Nicolas Miller
+    Date: 08/14/2025
+*/
+
+#ifndef CHESS_ENGINE_MOVE_PICKER_H
+#define CHESS_ENGINE_MOVE_PICKER_H
+
+#include "movelist.h"
+#include "position.h"
+#include "types.h"
+
+namespace luna
+{
+
+// Quiet move history by [from][to] for one side
+using ButterflyHistory = int[64][64];
+
+// History scores by [piece][to square]
+using PieceToHistory = int[static_cast<int>(Piece::NB)][64];
+
+class MovePicker
+{
+public:
+    // Main search. killers points to the two killers for this ply;
+    // continuation may be null (root, or after a null move).
+    MovePicker(const Position& pos, const Move& tt_move, const Move* killers, const Move& countermove,
+               const ButterflyHistory* history, const PieceToHistory* continuation);
+
+    // Quiescence search: captures and promotions that do not lose material
+    explicit MovePicker(const Position& pos);
+
+    // Next legal move to search, or Move() once every move has been returned
+    Move next_move();
+
+private:
+    enum class Stage
+    {
+        TTMove,
+        GenerateCaptures,
+        GoodCaptures,
+        Killer1,
+        Killer2,
+        Countermove,
+        GenerateQuiets,
+        Quiets,
+        BadCaptures,
+        GenerateEvasions,
+        Evasions,
+        Done
+    };
+
+    // Score the generated moves for ordering
+    void score_captures();
+    void score_quiets();
+    void score_evasions();
+
+    int capture_score(const Move& move) const;
+    int quiet_score(const Move& move) const;
+
+    // Swap the best remaining move to the front and return it
+    Move select_best();
+
+    // A killer or countermove that is legal here and not already returned
+    bool is_refutation(const Move& move) const;
+
+    // Whether a move was already returned by an earlier stage
+    bool already_returned(const Move& move) const;
+
+    const Position& pos_;
+    Stage stage_;
+    bool captures_only_;
+
+    Move tt_move_;
+    Move killers_[2];
+    Move countermove_;
+    Move returned_[3];      // Killers and countermove handed out before the quiets
+    int returned_count_;
+
+    const ButterflyHistory* history_;
+    const PieceToHistory* continuation_;
+
+    MoveList moves_;
+    int scores_[MAX_MOVES];
+    size_t current_;
+
+    MoveList bad_captures_;     // Captures that lose material, in MVV-LVA order
+    size_t bad_current_;
+};
+
+} // namespace luna
+
+#endif // CHESS_ENGINE_MOVE_PICKER_H
@@ -0,0 +1,120 @@
+/*
+    Efficiently updatable neural network (NNUE) for position evaluation.
+
+    Architecture (HalfKP, 2x256-32-32-1):
+        - Input features are (own king square, piece, square) triples seen
+          from each side, with the board flipped for black. Kings are not
+          features themselves; they select the feature set.
+        - A feature transformer maps the active features of each side to a
+          256-wide int16 accumulator. Only the pieces a move changes are
+          added or subtracted, so this layer is cheap after the first
+          evaluation (see NnueEvaluator).
+        - The two accumulators, side to move first, are clipped to 0..127
+          and fed through two int8 dense layers of 32 and an int8 output
+          layer.
+
+    The dense layers run on AVX2, SSE4.1 or NEON when the compiler targets
+    them (build with LUNA_NATIVE=ON to target the host CPU) and fall back to
+    scalar code otherwise. The scalar kernels are always built so tests can
+    check the vector ones against them.
+
+    Author: Nicolas Miller
+    Date: 08/17/2025
+*/
+
+#ifndef CHESS_ENGINE_NNUE_H
+#define CHESS_ENGINE_NNUE_H
+
+#include "types.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class Position;
+
+namespace luna
+{
+
+struct BoardSnapshot;
+
+constexpr int NNUE_PIECE_FEATURES = 10 * 64;                        // Non-king pieces x squares
+constexpr int NNUE_INPUTS = 64 * NNUE_PIECE_FEATURES;               // x king squares
+constexpr int NNUE_HALF_DIMS = 256;                                 // Accumulator width per side
+constexpr int NNUE_L1 = 32;
+constexpr int NNUE_L2 = 32;
+constexpr int NNUE_WEIGHT_SHIFT = 6;                                // Dense layer output scaling
+constexpr int NNUE_OUTPUT_SCALE = 16;                               // Output to centipawns
+constexpr uint32_t NNUE_VERSION = 1;
+
+// Feature index of a piece on a square, seen from one side with that
+// side's king on king_sq. Returns -1 for kings.
+int nnue_feature_index(Color perspective, Square king_sq, Piece piece, Square square);
+
+struct alignas(64) NnueAccumulator
+{
+    int16_t values[2][NNUE_HALF_DIMS];  // [perspective]
+};
+
+class NnueNetwork
+{
+public:
+    NnueNetwork();
+
+    // Load a network written by save(). Returns false and leaves the
+    // network unchanged if the file is missing, truncated or does not
+    // match this architecture.
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // Fill the network with small pseudo-random weights. Useless for play,
+    // but exercises every kernel for tests and speed benchmarks.
+    void randomize(uint64_t seed);
+
+    // Accumulator for one side built from scratch
+    void refresh(const Position& pos, Color perspective, int16_t* acc) const;
+    void refresh(const BoardSnapshot& board, Color perspective, int16_t* acc) const;
+
+    // Add or remove one feature's weights from an accumulator
+    void add_feature(int16_t* acc, int feature) const;
+    void remove_feature(int16_t* acc, int feature) const;
+
+    // Score of a position from the side to move's point of view
+    int propagate(const NnueAccumulator& acc, Color side_to_move) const;
+
+private:
+    template <typename Board>
+    void refresh_board(const Board& board, Color perspective, int16_t* acc) const;
+
+    std::unique_ptr<int16_t[]> feature_weights_;    // [feature][NNUE_HALF_DIMS]
+    alignas(64) int16_t feature_biases_[NNUE_HALF_DIMS];
+    alignas(64) int8_t l1_weights_[NNUE_L1][2 * NNUE_HALF_DIMS];
+    alignas(64) int32_t l1_biases_[NNUE_L1];
+    alignas(64) int8_t l2_weights_[NNUE_L2][NNUE_L1];
+    alignas(64) int32_t l2_biases_[NNUE_L2];
+    alignas(64) int8_t output_weights_[NNUE_L2];
+    int32_t output_bias_;
+};
+
+// Vector kernels used by NnueNetwork, exposed for testing
+namespace nnue_kernels
+{
+
+// out[o] = biases[o] + sum(in[i] * weights[o * n_in + i]); n_in is a
+// multiple of 32 and inputs are in 0..127
+void dense(const uint8_t* in, int n_in, const int8_t* weights, const int32_t* biases,
+           int n_out, int32_t* out);
+void dense_scalar(const uint8_t* in, int n_in, const int8_t* weights, const int32_t* biases,
+                  int n_out, int32_t* out);
+
+// out[i] = clamp(in[i], 0, 127); n is a multiple of 32
+void clipped_relu(const int16_t* in, int n, uint8_t* out);
+void clipped_relu_scalar(const int16_t* in, int n, uint8_t* out);
+
+// Name of the instruction set the kernels were built for
+const char* instruction_set();
+
+} // namespace nnue_kernels
+
+} // namespace luna
+
+#endif // CHESS_ENGINE_NNUE_H
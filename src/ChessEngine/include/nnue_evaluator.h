@@ -0,0 +1,57 @@
+/*
+    Per-thread NNUE evaluation state. Keeps one accumulator per ply of the
+    position's undo stack. A position whose accumulator is missing is
+    brought up to date from the nearest ancestor that has one, replaying the
+    pieces each move changed (recorded by Position::make_move); undoing a
+    move needs no work since the parent's accumulator is still in place.
+    A side whose king moved on the way is rebuilt from scratch, since every
+    one of its features depends on the king square.
+
+    Author: Nicolas Miller
+    Date: 08/17/2025
+*/
+
+#ifndef CHESS_ENGINE_NNUE_EVALUATOR_H
+#define CHESS_ENGINE_NNUE_EVALUATOR_H
+
+#include "nnue.h"
+#include "position.h"
+#include <memory>
+
+namespace luna
+{
+
+class NnueEvaluator
+{
+public:
+    // The network is shared between threads and must outlive the evaluator
+    explicit NnueEvaluator(const NnueNetwork* network);
+
+    // Score from the side to move's point of view
+    int evaluate(const Position& pos);
+    
+    // Score of a board without history; both accumulators are built from
+    // scratch
+    int evaluate(const BoardSnapshot& board);
+
+    // Forget every accumulator, so the next evaluation starts from scratch
+    void reset();
+
+private:
+    struct StackEntry
+    {
+        NnueAccumulator acc;
+        uint64_t key = 0;       // Hash key of the position the accumulator is for
+        bool valid = false;
+    };
+
+    // Bring the accumulator for the current position up to date
+    void update(const Position& pos, StackEntry& entry);
+
+    const NnueNetwork* network_;
+    std::unique_ptr<StackEntry[]> stack_;   // [MAX_GAME_PLY + 1], indexed by move_count()
+};
+
+} // namespace luna
+
+#endif // CHESS_ENGINE_NNUE_EVALUATOR_H
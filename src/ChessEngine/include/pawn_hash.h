@@ -0,0 +1,51 @@
+/*
+    Pawn structure cache. Pawn structure changes only on pawn moves and
+    captures of pawns, so the pawn terms of the evaluation are computed
+    once per pawn configuration and looked up by Position::pawn_key() after
+    that. Each search thread owns its own table through its Evaluator, so
+    entries need no synchronization.
+
+    Author: Nicolas Miller
+    Date: 08/16/2025
+*/
+
+#ifndef CHESS_ENGINE_PAWN_HASH_H
+#define CHESS_ENGINE_PAWN_HASH_H
+
+#include "bitboard.h"
+#include "types.h"
+#include <cstdint>
+#include <vector>
+
+namespace luna 
+{
+
+struct PawnEntry 
+{
+    uint64_t key = 0;               // Pawn key of the cached structure
+    int score = 0;                  // Doubled, isolated and passed pawn terms (white minus black)
+    Bitboard passed_pawns[2];       // [color] Passed pawns, for later evaluation terms
+};
+
+class PawnHashTable 
+{
+public:
+    explicit PawnHashTable(size_t entries = PAWN_HASH_ENTRIES);
+    
+    // The slot for a pawn key. The caller checks entry->key and fills the
+    // slot on a miss. Empty slots have key 0, which is also the key of a
+    // position without pawns, and their zero contents are correct for it.
+    PawnEntry* probe(uint64_t key) { return &table_[key & mask_]; }
+    
+    void clear();
+    
+    static constexpr size_t PAWN_HASH_ENTRIES = 16384;     // Must be a power of two
+    
+private:
+    std::vector<PawnEntry> table_;
+    uint64_t mask_;
+};
+
+} // namespace luna
+
+#endif // CHESS_ENGINE_PAWN_HASH_H
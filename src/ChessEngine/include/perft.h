@@ -0,0 +1,74 @@
+/*
+    Perft (performance test) for move generation. Counts the leaf nodes of
+    the legal move tree to a fixed depth, for verifying the move generator
+    and benchmarking its throughput. Supports:
+        - Bulk counting at depth 1 (the size of the legal move list)
+        - An optional transposition table keyed by hash and depth
+        - Splitting the root moves across several threads
+        - Per-move "divide" output and NPS reporting
+
+    Author: Nicolas Miller
+    Date: 06/11/2025
+*/
+
+#ifndef CHESS_ENGINE_PERFT_H
+#define CHESS_ENGINE_PERFT_H
+
+#include "position.h"
+#include "types.h"
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace luna
+{
+
+class Perft
+{
+public:
+    struct Result
+    {
+        uint64_t nodes = 0;
+        int64_t time_ms = 0;
+        uint64_t nps = 0;
+        std::vector<std::pair<Move, uint64_t>> divide;  // Leaf count below each root move
+    };
+
+    // hash_mb of 0 disables the perft transposition table
+    explicit Perft(size_t hash_mb = 0);
+
+    // Count leaf nodes on the calling thread
+    uint64_t count(Position& pos, int depth);
+
+    // Count leaf nodes with the root moves split across threads, keeping
+    // per-move counts and timing
+    Result run(const Position& pos, int depth, int threads = 1);
+
+    // Print divide lines followed by totals and NPS
+    static void print_result(std::ostream& out, const Result& result);
+
+private:
+    // Lockless entry; the key is stored XORed with the data so a torn write
+    // from another thread fails verification instead of returning bad counts
+    struct Entry
+    {
+        std::atomic<uint64_t> key_xor_data{0};
+        std::atomic<uint64_t> data{0};  // nodes << 8 | depth
+    };
+
+    std::unique_ptr<Entry[]> table_;
+    size_t table_size_;
+
+    uint64_t perft(Position& pos, int depth);
+
+    bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+    void store(uint64_t key, int depth, uint64_t nodes);
+};
+
+} // namespace luna
+
+#endif // CHESS_ENGINE_PERFT_H
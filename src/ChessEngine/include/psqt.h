@@ -0,0 +1,60 @@
+/*
+    Piece-square tables combined with material into one middlegame and
+    endgame score per piece and square. Position keeps a running sum of
+    these values and of the game phase, updated as moves are made, so the
+    evaluator reads material and piece placement without scanning the board.
+
+    Author: Nicolas Miller
+    Date: 08/15/2025
+*/
+
+#ifndef CHESS_ENGINE_PSQT_H
+#define CHESS_ENGINE_PSQT_H
+
+#include "types.h"
+
+class Position;
+
+namespace luna 
+{
+
+class PieceSquareTable 
+{
+public:
+    // Build the combined tables (call once at startup)
+    static void initialize();
+    
+    // Material plus placement of a piece on a square: positive for white
+    // pieces, negative for black
+    static Score value(Piece piece, Square square) 
+    { 
+        return table_[static_cast<int>(piece)][static_cast<int>(square)]; 
+    }
+    
+    // Game phase contributed by a piece
+    static int phase(Piece piece) { return phase_[static_cast<int>(piece)]; }
+    
+    // Full recomputation of the running sums, for loading positions and
+    // verifying the incremental updates
+    static Score compute_score(const Position& pos);
+    static int compute_phase(const Position& pos);
+    
+private:
+    // Piece-square tables from white's point of view
+    static const int pawn_table[64];
+    static const int knight_table[64];
+    static const int bishop_table[64];
+    static const int rook_table[64];
+    static const int queen_table[64];
+    static const int king_middlegame_table[64];
+    static const int king_endgame_table[64];
+    
+    static Score table_[12][64];    // [piece][square]
+    static int phase_[12];          // [piece]
+    
+    static bool initialized_;
+};
+
+} // namespace luna
+
+#endif // CHESS_ENGINE_PSQT_H
@@ -4,6 +4,12 @@
     move ordering, and quiescence search.
 
     UPDATE 08/13/2025: Added transposition tables to search. 
+    UPDATE: Searches can run as Lazy SMP helpers sharing one table.
+    UPDATE: Principal variation search with aspiration windows.
+    UPDATE: Null move pruning and late move reductions.
+    UPDATE: Quiet move ordering by history, countermove and continuation
+    history; killers are indexed by search ply.
+    UPDATE: Moves are searched in stages from a MovePicker.
 
     Author: Nicolas Miller
     Date: 08/13/2025
@@ -14,47 +20,114 @@
 
 #include "constants.h"
 #include "evaluator.h"
+#include "move_picker.h"
 #include "time_manager.h"
 #include "transposition_table.h"
+#include "movelist.h"
 #include "position.h"
 #include "types.h"
 
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 namespace luna 
 {
 
+class ChessTests;
+
 class Search 
 {
 public:
     struct SearchInfo 
     {
-        int nodes_searched;
+        uint64_t nodes_searched;
         int depth_reached;
         int score;
+        int pvs_researches;         // Null-window searches that had to be repeated
+        int aspiration_researches;  // Root searches repeated after leaving the window
+        int null_move_cutoffs;      // Nodes cut off by a null move search
+        int lmr_researches;         // Reduced searches repeated at full depth
+        uint64_t beta_cutoffs;        // Nodes that failed high
+        uint64_t first_move_cutoffs;  // ...on the first move searched
+        uint64_t eval_cache_hits;     // Evaluations answered by the eval cache
+        uint64_t eval_cache_misses;   // Evaluations computed in full
         std::vector<Move> pv;  // Principal variation
+        
+        // Percentage of beta cutoffs made by the first move searched
+        double first_move_cutoff_rate() const 
+        { 
+            return beta_cutoffs > 0 ? 100.0 * static_cast<double>(first_move_cutoffs) / static_cast<double>(beta_cutoffs) : 0.0; 
+        }
+        
+        // Percentage of evaluations answered by the eval cache
+        double eval_cache_hit_rate() const 
+        { 
+            uint64_t probes = eval_cache_hits + eval_cache_misses;
+            return probes > 0 ? 100.0 * static_cast<double>(eval_cache_hits) / static_cast<double>(probes) : 0.0; 
+        }
     };
     
-    Search(Evaluator* eval);
+    // Thread 0 is the main search; other ids are Lazy SMP helpers that
+    // share the table, skip iterations for depth diversity and stay silent
+    Search(Evaluator* eval, TranspositionTable* tt, int thread_id = 0);
     
-    // Main search function
+    // Main search function. Helpers run with no time manager until stopped.
     Move search_position(Position& position, int max_depth, TimeManager* tm);
     
     // Get search information
     const SearchInfo& get_search_info() const;
     
-    // Set stop flag (for UCI stop command)
+    // Set stop flag (for UCI stop command and for stopping helpers)
     void stop() { stop_search_ = true; }
     
+    // Clear the stop flag before a new search is started
+    void reset_stop() { stop_search_ = false; }
+    
+    // Nodes searched so far in the current search; safe to read from other threads
+    uint64_t nodes() const { return nodes_.load(std::memory_order_relaxed); }
+    
+    // Helper searches whose node counts are included in the main thread's output
+    void set_helpers(const std::vector<const Search*>& helpers) { helpers_ = helpers; }
+    
+    // Turn null move pruning and late move reductions on or off
+    void set_null_move(bool enabled) { use_null_move_ = enabled; }
+    void set_lmr(bool enabled) { use_lmr_ = enabled; }
+    
+    // Turn principal variation search and aspiration windows on or off.
+    // Without them every move is searched with the full window (and no
+    // reductions), which tests compare against.
+    void set_pvs(bool enabled) { use_pvs_ = enabled; }
+    
 private:
+    // Tests drive the move ordering updates directly
+    friend class ChessTests;
+    
     // Core negamax with alpha-beta (now includes ply for TT)
     int negamax(Position& pos, int depth, int alpha, int beta, int ply);
     
-    // Root negamax that tracks the best move (now includes ply for TT)
-    int negamax_root(Position& pos, int depth, int alpha, int beta, Move& best_move, int ply);
+    // Root negamax that tracks the best move, trying previous_best first
+    int negamax_root(Position& pos, int depth, int alpha, int beta, const Move& previous_best,
+                     Move& best_move, int ply);
+    
+    // Reward a quiet move that caused a beta cutoff and penalize the quiet
+    // moves searched before it
+    void update_quiet_stats(const Position& pos, const Move& move, int ply, int depth,
+                            const Move* quiets_tried, int quiet_count);
+    
+    // Quiet move that last refuted the previous move, or Move() if none
+    Move countermove(const Position& pos) const;
+    
+    // Continuation history row for replies to the last move, or null at
+    // the root and after a null move
+    PieceToHistory* continuation_row(const Position& pos);
+    
+    // Move an entry toward +/- HISTORY_MAX by a bonus that shrinks as the
+    // entry saturates
+    static void apply_gravity(int& entry, int bonus);
     
-    // Move ordering for better pruning (now includes TT move)
-    void order_moves(std::vector<Move>& moves, const Position& pos, const Move& tt_move);
+    // Clear killers and age the history tables before a new search
+    void age_history();
     
     // Quiescence search (now includes ply for TT)
     int quiescence(Position& pos, int alpha, int beta, int ply);
@@ -62,20 +135,57 @@ private:
     // Print search information for debugging
     void print_search_info(int depth, int score, int time_ms) const;
     
-    // Helper to get piece value
-    int get_piece_value(PieceType pt) const;
+    // Count a node. Only the owning thread writes, so a relaxed load and
+    // store avoids a locked increment.
+    void count_node() { nodes_.store(nodes_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    
+    // Nodes searched by this search and its helpers
+    uint64_t total_nodes() const;
+    
+    // Whether a helper skips this iteration depth
+    bool skip_iteration(int depth) const;
+    
+    // Whether a side has a piece other than pawns and its king (null
+    // move pruning is unsafe in pawn endings because of zugzwang)
+    bool has_non_pawn_material(const Position& pos, Color color) const;
+    
+    // Fill the late move reduction table (once, shared by all searches)
+    static void init_lmr_table();
     
     Evaluator* evaluator_;
     TimeManager* time_manager_;
     SearchInfo info_;
-    bool stop_search_;  // Flag to indicate when to stop the search
+    std::atomic<bool> stop_search_;  // Flag to indicate when to stop the search
+    std::atomic<uint64_t> nodes_;
+    
+    // Transposition table, shared by every search thread
+    TranspositionTable* tt_;
     
-    // Transposition table
-    TranspositionTable tt_;
+    int thread_id_;
+    std::vector<const Search*> helpers_;
     
-    // Killer moves for move ordering
+    // Pruning switches; null moves are disabled below nmp_min_ply_ while
+    // a null move cutoff is being verified
+    bool use_null_move_;
+    bool use_lmr_;
+    bool use_pvs_;
+    int nmp_min_ply_;
+    
+    // Late move reductions by [depth][moves searched]
+    static int lmr_table_[MAX_PLY][MAX_MOVES];
+    
+    // Killer moves for move ordering, by search ply
     Move killer_moves_[MAX_PLY][2];
     
+    // Butterfly history of quiet moves by [side][from][to]
+    ButterflyHistory history_[static_cast<int>(Color::NB)];
+    
+    // Quiet move that refuted each move, by [moved piece][to]
+    Move countermoves_[static_cast<int>(Piece::NB)][64];
+    
+    // History of quiet replies by [previous piece][previous to][piece][to]
+    PieceToHistory continuation_history_[static_cast<int>(Piece::NB)][64];
+    
     // Time checking optimization
     int nodes_since_time_check_;
     
@@ -64,6 +64,12 @@ public:
     void test_edge_cases();
     void test_regression_bugs();
     void test_position_unmake_move();
+    void test_transposition_table();
+    void test_evaluation_caches();
+    void test_batch_eval();
+    void test_tuner();
+    void test_move_ordering();
+    void test_nnue();
 
     // Run all tests
     void run_all_tests();
@@ -76,11 +82,20 @@ public:
 
 } // namespace luna
 
+// Suppress MSVC's "conditional expression is constant" warning inside the
+// assertion macros; other compilers don't need it.
+#ifdef _MSC_VER
+#define TEST_WARNING_PUSH __pragma(warning(push)) __pragma(warning(disable: 4127))
+#define TEST_WARNING_POP __pragma(warning(pop))
+#else
+#define TEST_WARNING_PUSH
+#define TEST_WARNING_POP
+#endif
+
 // Helper macro for assertions with descriptive messages
 #define TEST_ASSERT(condition, message) \
     do { \
-        __pragma(warning(push)) \
-        __pragma(warning(disable: 4127)) \
+        TEST_WARNING_PUSH \
         if (!(condition)) { \
             std::cerr << RED << "ASSERTION FAILED: " << message << RESET << std::endl; \
             std::cerr << "  File: " << __FILE__ << ", Line: " << __LINE__ << std::endl; \
@@ -89,7 +104,7 @@ public:
         } else { \
             global_results.pass(); \
         } \
-        __pragma(warning(pop)) \
+        TEST_WARNING_POP \
     } while(0)
 
 #define TEST_ASSERT_EQ(actual, expected, message) \
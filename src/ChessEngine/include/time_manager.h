@@ -2,6 +2,13 @@
     Time management for chess engine.
     Checks for timeout.
 
+    UPDATE: Budgets a move from the clock, increment and moves to go. The
+    search may run until a hard limit; between iterations a soft limit
+    decides whether to start another. The soft limit shrinks while the
+    best move stays the same and grows when it changes or the score drops,
+    and no iteration is started that is predicted to overrun the hard
+    limit. A fixed move time keeps the old single deadline.
+
     Author: Nicolas Miller
     Date: 07/09/2025
 */
@@ -9,21 +16,58 @@
 #ifndef CHESS_ENGINE_TIME_MANAGER_H
 #define CHESS_ENGINE_TIME_MANAGER_H
 
+#include "types.h"
 #include <chrono>
 
 namespace luna {
 
+// Time control of a UCI go command, for the side to move
+struct SearchLimits {
+    int time_left_ms = 0;       // Remaining clock time; 0 if not playing on a clock
+    int increment_ms = 0;       // Added after each move
+    int moves_to_go = 0;        // Moves until the next time control; 0 for the rest of the game
+    int move_time_ms = 0;       // Exact time for this move; overrides the clock
+    bool infinite = false;      // Search until stopped
+};
+
 class TimeManager {
 public:
     TimeManager();
-    
+
+    // Search for a fixed time (0 searches until stopped)
     void start_search(int time_ms);
+
+    // Budget this move from a time control
+    void start_search(const SearchLimits& limits);
+
+    // Whether the hard limit has passed; checked during the search
     bool should_stop() const;
+
+    // Called after each completed iteration with its best move and score
+    // and the time elapsed so far. Returns true if another iteration
+    // should not be started.
+    bool stop_after_iteration(const Move& best_move, int score, int elapsed_ms);
+
     int elapsed_ms() const;
 
+    // Current limits; the soft limit moves as iterations complete
+    int soft_limit_ms() const { return soft_limit_ms_; }
+    int hard_limit_ms() const { return hard_limit_ms_; }
+
 private:
     std::chrono::steady_clock::time_point start_time_;
-    int allocated_time_ms_;
+    int hard_limit_ms_;         // 0 for no limit
+    int base_soft_limit_ms_;    // Soft limit before stability and score scaling
+    int soft_limit_ms_;
+    bool adaptive_;             // Budgeted from a clock rather than a fixed time
+
+    // State of the previous iterations
+    Move last_best_move_;
+    int last_score_;
+    int stable_iterations_;     // Iterations in a row with the same best move
+    int iterations_;
+    int last_iteration_end_ms_;
+    int last_iteration_ms_;
 };
 
 } // namespace luna
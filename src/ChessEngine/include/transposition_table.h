@@ -2,6 +2,20 @@
     Transposition table implementation for chess engine.
     Stores position evaluations and best moves for faster search.
 
+    UPDATE: Bucketed, lockless layout for multi-threaded search:
+        - 64-byte clusters of four 16-byte entries, one cache line each
+        - Cluster index from the high half of key * cluster count (no divide)
+        - Each entry packs move, score, depth, bound and age into one word
+          and stores the key XORed with that word, so a torn write from
+          another thread fails verification instead of being read back
+        - Depth/age-aware replacement within the cluster
+        - Large tables are 2 MB aligned and advised to use huge pages, and
+          are cleared in parallel
+        - A prefetch hook so search can start loading a child's cluster
+          before it makes the move
+        - Saving to and loading from a versioned binary file so analysis
+          can resume with a warm table
+
     Author: Nicolas Miller
     Date: 08/12/2025
 */
@@ -10,14 +24,16 @@
 #define CHESS_ENGINE_TRANSPOSITION_TABLE_H
 
 #include "types.h"
+#include <atomic>
 #include <cstdint>
-#include <vector>
+#include <memory>
+#include <string>
 
-namespace luna 
+namespace luna
 {
 
 // Bounds for search algorithm
-enum class BoundType : uint8_t 
+enum class BoundType : uint8_t
 {
     NONE = 0,
     EXACT = 1,          // Exact score (PV node)
@@ -25,59 +41,111 @@ enum class BoundType : uint8_t
     UPPER_BOUND = 3     // Alpha didn't improve (fail-low)
 };
 
-// An entry in the transposition table
-struct TTEntry 
+// An entry in the transposition table. The data word is laid out as
+//     bits  0-15  best move (Move::raw)
+//     bits 16-47  score
+//     bits 48-55  depth
+//     bits 56-57  bound type
+//     bits 58-63  search generation (age)
+// A zero data word marks an empty entry (its bound is NONE).
+struct TTEntry
+{
+    std::atomic<uint64_t> key_xor_data{0};  // Zobrist key ^ data (verification)
+    std::atomic<uint64_t> data{0};          // Packed entry fields
+
+    static uint64_t pack(const Move& move, int score, int depth, BoundType bound, uint8_t age);
+
+    static Move move_of(uint64_t data) { return Move::from_raw(static_cast<uint16_t>(data)); }
+    static int score_of(uint64_t data) { return static_cast<int32_t>(static_cast<uint32_t>(data >> 16)); }
+    static int depth_of(uint64_t data) { return static_cast<int8_t>(static_cast<uint8_t>(data >> 48)); }
+    static BoundType bound_of(uint64_t data) { return static_cast<BoundType>((data >> 56) & 0x3); }
+    static uint8_t age_of(uint64_t data) { return static_cast<uint8_t>(data >> 58); }
+};
+
+constexpr int TT_CLUSTER_SIZE = 4;
+constexpr int TT_AGE_CYCLE = 64;    // Ages are stored in 6 bits
+
+// One cache line of entries sharing an index
+struct alignas(64) TTCluster
+{
+    TTEntry entries[TT_CLUSTER_SIZE];
+};
+
+static_assert(sizeof(TTCluster) == 64, "TT clusters must fill one cache line");
+
+// Frees cluster memory from the aligned large-page allocation
+struct TTMemoryDeleter
 {
-    uint64_t key;           // Zobrist hash key (verification)
-    int16_t score;          // Position evaluation
-    int16_t depth;          // Search depth when stored
-    uint8_t bound_type;     // BoundType enum value
-    uint8_t age;            // Search generation for replacement
-    Move best_move;         // Best move from this position
-    
-    TTEntry() : key(0), score(0), depth(-1), bound_type(0), age(0), best_move() {}
-    
-    // Check if entry is valid
-    bool is_valid() const { return depth >= 0; }
+    void operator()(TTCluster* clusters) const;
 };
 
-class TranspositionTable 
+class TranspositionTable
 {
 public:
-    explicit TranspositionTable(size_t size_mb = 64);
-    
+    explicit TranspositionTable(size_t size_mb = 64, int threads = 1);
+
     ~TranspositionTable() = default;
-    
+
     // Store a position in the hash table
-    void store(uint64_t key, int score, int depth, BoundType bound, 
+    void store(uint64_t key, int score, int depth, BoundType bound,
                const Move& best_move, int ply);
-    
+
     // Probe the hash table for a position
-    bool probe(uint64_t key, int& score, int& depth, BoundType& bound, 
+    bool probe(uint64_t key, int& score, int& depth, BoundType& bound,
                Move& best_move, int ply) const;
-    
-    // Clear the entire hash table
-    void clear();
-    
+
+    // Start loading the cluster for a key into cache
+    void prefetch(uint64_t key) const;
+
+    // Turn prefetching off (for benchmarking its effect)
+    void set_prefetch(bool enabled) { prefetch_enabled_ = enabled; }
+
+    // Clear the entire hash table, splitting the work over threads
+    void clear(int threads = 1);
+
     // Start a new search (increment age)
-    void new_search() { current_age_++; }
-    
-    // Resize the hash table
-    void resize(size_t size_mb);
-    
+    void new_search() { current_age_ = static_cast<uint8_t>((current_age_ + 1) % TT_AGE_CYCLE); }
+
+    // Resize the hash table. If the memory cannot be allocated the table
+    // falls back to MIN_HASH_SIZE_MB (or, if even that fails, a single
+    // cluster kept inside the object) and std::bad_alloc is thrown.
+    void resize(size_t size_mb, int threads = 1);
+
     // Get current size in MB
     size_t size_mb() const;
-    
+
+    // Permille of sampled entries written during the current search (UCI hashfull)
+    int hashfull() const;
+
+    // Write the table to a file: a header recording the format, table size
+    // and Zobrist seed, followed by the raw clusters
+    bool save(const std::string& path) const;
+
+    // Replace the table with one saved by save(), resizing to the saved
+    // size. Returns false and leaves the table unchanged if the file is
+    // missing, truncated or was written with a different format or seed;
+    // throws std::bad_alloc like resize() if the saved size cannot be allocated.
+    bool load(const std::string& path, int threads = 1);
+
 private:
-    std::vector<TTEntry> table_;
-    size_t table_size_;     // Table size
+    std::unique_ptr<TTCluster, TTMemoryDeleter> table_;
+    TTCluster* clusters_;           // table_, or fallback_cluster_ if nothing could be allocated
+    size_t cluster_count_;          // Number of clusters
+    TTCluster fallback_cluster_;
     uint8_t current_age_;   // Current search generation
-    
-    // Get hash table index from key
-    size_t get_index(uint64_t key) const;
-    
-    // Check if we should replace an existing entry
-    bool should_replace(const TTEntry& existing, int new_depth, uint8_t new_age) const;
+    bool prefetch_enabled_;
+
+    // Allocate uninitialized cluster memory, or null on failure
+    static TTCluster* allocate(size_t cluster_count);
+
+    // Reallocate and clear the table with an exact number of clusters
+    void resize_clusters(size_t cluster_count, int threads);
+
+    // Get the cluster for a key
+    TTCluster& cluster_for(uint64_t key) const;
+
+    // Replacement value of an entry; the lowest in a cluster is replaced first
+    int replacement_value(uint64_t data) const;
 };
 
 } // namespace luna
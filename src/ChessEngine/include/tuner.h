@@ -0,0 +1,131 @@
+/*
+    Texel-style tuning of the hand-written evaluation weights (luna-tune).
+
+    The weights that live as constants in constants.h and as tables in
+    psqt.cpp are laid out here as one runtime parameter vector. Every term
+    of the classical evaluation is linear in these weights, so a position
+    reduces to a short list of (parameter, coefficient) features and its
+    evaluation to their dot product with the vector.
+
+    Tuning minimizes the mean squared error between game results and
+    sigmoid(K * eval) over a labeled position file:
+        - Positions are packed into 32 bytes each (occupancy plus a nibble
+          per piece), so millions fit in memory.
+        - K is fitted to the starting weights first, then the weights are
+          trained with Adam on the exact gradient of the error.
+        - Each pass over the positions is split across threads.
+        - The result is written as a header in the layout of constants.h
+          and psqt.cpp, ready to copy over.
+
+    Author: Nicolas Miller
+    Date: 08/24/2025
+*/
+
+#ifndef CHESS_ENGINE_TUNER_H
+#define CHESS_ENGINE_TUNER_H
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Position;
+
+namespace luna
+{
+
+// Parameter vector layout
+constexpr int TUNE_MATERIAL = 0;                            // Pawn to queen values
+constexpr int TUNE_PST = TUNE_MATERIAL + 5;                 // Pawn to queen tables, 64 each
+constexpr int TUNE_KING_MG = TUNE_PST + 5 * 64;             // King middlegame table
+constexpr int TUNE_KING_EG = TUNE_KING_MG + 64;             // King endgame table
+constexpr int TUNE_DOUBLED_PAWN = TUNE_KING_EG + 64;
+constexpr int TUNE_ISOLATED_PAWN = TUNE_DOUBLED_PAWN + 1;
+constexpr int TUNE_PASSED_PAWN = TUNE_ISOLATED_PAWN + 1;
+constexpr int TUNE_BISHOP_PAIR = TUNE_PASSED_PAWN + 1;
+constexpr int TUNE_ROOK_ON_SEVENTH = TUNE_BISHOP_PAIR + 1;
+constexpr int TUNE_ROOK_ON_OPEN_FILE = TUNE_ROOK_ON_SEVENTH + 1;
+constexpr int TUNE_KING_PAWN_SHIELD = TUNE_ROOK_ON_OPEN_FILE + 1;
+constexpr int TUNE_CASTLING_RIGHTS = TUNE_KING_PAWN_SHIELD + 1;
+constexpr int TUNE_MOBILITY = TUNE_CASTLING_RIGHTS + 1;
+constexpr int TUNE_CENTER_CONTROL = TUNE_MOBILITY + 1;
+constexpr int TUNE_PARAM_COUNT = TUNE_CENTER_CONTROL + 1;
+
+// Enough for 32 pieces (two features each) plus the scalar terms
+constexpr int TUNE_MAX_FEATURES = 128;
+
+// A position with its game result, 32 bytes
+struct PackedPosition
+{
+    uint64_t occupied;
+    uint8_t pieces[16];         // Piece of each occupied square, lowest square first, two per byte
+    uint8_t castling_rights;
+    uint8_t result;             // Half points for white: 0, 1 or 2
+};
+
+PackedPosition pack_position(const Position& pos, double result);
+
+// Sparse coefficients of a position's evaluation (white's point of view)
+struct TuneFeatures
+{
+    int count = 0;
+    uint16_t index[TUNE_MAX_FEATURES];
+    double coefficient[TUNE_MAX_FEATURES];
+
+    double evaluate(const std::vector<double>& params) const
+    {
+        double score = 0.0;
+        for (int i = 0; i < count; i++) score += coefficient[i] * params[index[i]];
+        return score;
+    }
+};
+
+void extract_features(const PackedPosition& packed, TuneFeatures& features);
+
+// The weights the engine is built with
+std::vector<double> default_tune_params();
+
+class Tuner
+{
+public:
+    explicit Tuner(int threads = 1);
+
+    // Append the positions of a file with one FEN and result per line. The
+    // result may be 1-0, 0-1 or 1/2-1/2 anywhere after the FEN, or a
+    // number 1.0, 0.5 or 0.0 in brackets ("[0.5]"). Lines without a valid
+    // FEN or result are skipped. Returns the number of positions added, or
+    // -1 if the file cannot be read.
+    long long load(const std::string& path);
+    void add(const Position& pos, double result);
+    size_t size() const { return positions_.size(); }
+
+    // Mean squared error of sigmoid(k * eval) against the results
+    double error(const std::vector<double>& params, double k) const;
+
+    // Scaling constant that minimizes the error for the given weights
+    double fit_k(const std::vector<double>& params) const;
+
+    // One Adam step on the weights; returns the error before the step
+    double train_epoch(std::vector<double>& params, double k, double learning_rate);
+
+    // Write the weights as a C++ header in the layout of constants.h and
+    // psqt.cpp
+    static bool write_header(const std::string& path, const std::vector<double>& params,
+                             const std::string& comment);
+
+private:
+    std::vector<PackedPosition> positions_;
+    int threads_;
+
+    // Adam moment estimates
+    std::vector<double> momentum_;
+    std::vector<double> velocity_;
+    int step_;
+
+    // Sum the error (and gradient, if given) over all positions
+    double accumulate(const std::vector<double>& params, double k, std::vector<double>* gradient) const;
+};
+
+} // namespace luna
+
+#endif // CHESS_ENGINE_TUNER_H
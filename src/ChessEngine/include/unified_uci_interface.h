@@ -53,13 +53,15 @@ private:
     void handle_listvariants();
     void handle_setrule(const std::string& command);
     void handle_listrules();
+    void handle_savehash(const std::string& command);
+    void handle_loadhash(const std::string& command);
     void handle_go_extended(const std::string& command);
     
     // Output functions
     void send_id();
     void send_options();
     void send_bestmove(const Move& move);
-    void send_info(int depth, int score, int nodes, int time_ms, const std::vector<Move>& pv);
+    void send_info(int depth, int score, uint64_t nodes, int time_ms, const std::vector<Move>& pv);
     void send_info_string(const std::string& info);
     
     // UCI+ specific output functions
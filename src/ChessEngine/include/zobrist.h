@@ -20,16 +20,22 @@ namespace luna
 class ZobristHash 
 {
 public:
+    // Seed for the key generator. Saved hash files record it, since their
+    // keys are only meaningful with the same Zobrist keys.
+    static constexpr uint64_t SEED = 0x1234567890ABCDEFULL;
+    
     // Initialize the Zobrist keys (call once at startup)
     static void initialize();
     
     // Generate hash for a complete position
     static uint64_t hash_position(const Position& pos);
     
-    // Update hash incrementally when making a move
-    static uint64_t update_hash_make_move(uint64_t current_hash, const Position& pos, const Move& move);
+    // Generate the pawn-only hash (pawn piece keys alone) used by the pawn
+    // structure cache
+    static uint64_t hash_pawns(const Position& pos);
     
-    // Individual hash components for manual updates
+    // Individual hash components; Position::make_move XORs these in and out
+    // to update its key incrementally
     static uint64_t piece_hash(Piece piece, Square square);
     static uint64_t castling_hash(uint8_t castling_rights);
     static uint64_t en_passant_hash(Square en_passant_square);
@@ -7,9 +7,20 @@
 
 #include "unified_uci_interface.h"
 #include "bitboard.h"
-#include "tests.h"
+#include "perft.h"
+#include "engine.h"
+#include "evaluator.h"
+#include "nnue.h"
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 void print_usage(const char* program_name) 
 {
@@ -17,13 +28,392 @@ void print_usage(const char* program_name)
     std::cout << "Usage: " << program_name << " [options]" << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  (no args)    Start in UCI mode" << std::endl;
-    std::cout << "  --test       Run engine tests" << std::endl;
+    std::cout << "  --perft <depth> [fen|startpos] [threads] [hash_mb]" << std::endl;
+    std::cout << "               Count move generation leaf nodes with per-move divide" << std::endl;
+    std::cout << "  --bench [depth]" << std::endl;
+    std::cout << "               Fixed-depth search of the bench positions (nodes, NPS, re-searches)" << std::endl;
+    std::cout << "  --pruning-bench [depth]" << std::endl;
+    std::cout << "               Compare nodes and time to depth with null move pruning and LMR on/off" << std::endl;
+    std::cout << "  --smp-bench [movetime_ms]" << std::endl;
+    std::cout << "               Report search NPS scaling for 1, 2, 4 and 8 threads" << std::endl;
+    std::cout << "  --tt-bench [hash_mb] [movetime_ms]" << std::endl;
+    std::cout << "               Measure transposition table hit rate, probe latency and" << std::endl;
+    std::cout << "               the search NPS gained by prefetching (default 256 MB)" << std::endl;
+    std::cout << "  --nnue-bench [evalfile]" << std::endl;
+    std::cout << "               Compare evaluations per second of the NNUE and hand-written" << std::endl;
+    std::cout << "               evaluators (a random network if no file is given)" << std::endl;
+    std::cout << "  --batch-bench [positions] [rounds]" << std::endl;
+    std::cout << "               Compare evaluations per second of one-at-a-time and batched" << std::endl;
+    std::cout << "               hand-written evaluation" << std::endl;
     std::cout << "  --help       Show this help message" << std::endl;
     std::cout << std::endl;
     std::cout << "Note: The engine automatically detects UCI vs UCI+ mode based on" << std::endl;
     std::cout << "      the 'uci' or 'uciplus' command sent by the GUI." << std::endl;
 }
 
+// Middlegame positions searched by the benchmarks
+const char* const BENCH_FENS[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+};
+
+// Search each bench position for a fixed time; returns total nodes and NPS
+std::pair<uint64_t, uint64_t> bench_search(luna::Engine& engine, int movetime_ms) 
+{
+    engine.set_max_depth(luna::MAX_SEARCH_DEPTH);
+    
+    uint64_t nodes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const char* fen : BENCH_FENS) 
+    {
+        Position pos;
+        pos.load_fen(fen);
+        engine.clear_hash();
+        engine.find_best_move(pos, movetime_ms);
+        nodes += engine.get_search_info().nodes_searched;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    return { nodes, nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(elapsed, 1)) };
+}
+
+// Totals from a fixed-depth bench run
+struct BenchTotals 
+{
+    uint64_t nodes = 0;
+    int64_t time_ms = 0;
+    int pvs_researches = 0;
+    int aspiration_researches = 0;
+    int null_move_cutoffs = 0;
+    int lmr_researches = 0;
+    uint64_t beta_cutoffs = 0;
+    uint64_t first_move_cutoffs = 0;
+    uint64_t eval_cache_hits = 0;
+    uint64_t eval_cache_misses = 0;
+};
+
+// Search every bench position to a fixed depth with a cleared table, so
+// node counts are reproducible between builds
+BenchTotals bench_fixed_depth(luna::Engine& engine, int depth) 
+{
+    engine.set_max_depth(depth);
+    
+    BenchTotals totals;
+    auto start = std::chrono::steady_clock::now();
+    for (const char* fen : BENCH_FENS) 
+    {
+        Position pos;
+        pos.load_fen(fen);
+        engine.clear_hash();
+        engine.find_best_move(pos, 24 * 60 * 60 * 1000);
+        
+        const luna::Search::SearchInfo& info = engine.get_search_info();
+        totals.nodes += info.nodes_searched;
+        totals.pvs_researches += info.pvs_researches;
+        totals.aspiration_researches += info.aspiration_researches;
+        totals.null_move_cutoffs += info.null_move_cutoffs;
+        totals.lmr_researches += info.lmr_researches;
+        totals.beta_cutoffs += info.beta_cutoffs;
+        totals.first_move_cutoffs += info.first_move_cutoffs;
+        totals.eval_cache_hits += info.eval_cache_hits;
+        totals.eval_cache_misses += info.eval_cache_misses;
+    }
+    totals.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    return totals;
+}
+
+// Fixed-depth bench on one thread with the default search settings
+int run_bench(int depth) 
+{
+    luna::Engine engine;
+    BenchTotals totals = bench_fixed_depth(engine, depth);
+    
+    std::cout << std::endl << "Bench depth " << depth << ":" << std::endl;
+    std::cout << "  Nodes:                  " << totals.nodes << std::endl;
+    std::cout << "  Time:                   " << totals.time_ms << " ms" << std::endl;
+    std::cout << "  NPS:                    " << totals.nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(totals.time_ms, 1)) << std::endl;
+    std::cout << "  PVS re-searches:        " << totals.pvs_researches << std::endl;
+    std::cout << "  Aspiration re-searches: " << totals.aspiration_researches << std::endl;
+    std::cout << "  Null move cutoffs:      " << totals.null_move_cutoffs << std::endl;
+    std::cout << "  LMR re-searches:        " << totals.lmr_researches << std::endl;
+    std::cout << "  First move cutoffs:     " << std::fixed << std::setprecision(1) 
+              << 100.0 * static_cast<double>(totals.first_move_cutoffs) / static_cast<double>(std::max<uint64_t>(totals.beta_cutoffs, 1)) 
+              << "%" << std::endl;
+    std::cout << "  Eval cache hits:        " << std::fixed << std::setprecision(1) 
+              << 100.0 * static_cast<double>(totals.eval_cache_hits) / 
+                 static_cast<double>(std::max<uint64_t>(totals.eval_cache_hits + totals.eval_cache_misses, 1)) 
+              << "%" << std::endl;
+    return 0;
+}
+
+// Fixed-depth bench with null move pruning and late move reductions
+// switched on and off, comparing nodes and time to depth
+int run_pruning_bench(int depth) 
+{
+    struct Config { const char* name; bool null_move; bool lmr; };
+    const Config configs[] = {
+        { "none", false, false },
+        { "null move", true, false },
+        { "LMR", false, true },
+        { "both", true, true }
+    };
+    
+    uint64_t base_nodes = 0;
+    std::ostringstream report;
+    report << std::setw(12) << "Pruning" << std::setw(14) << "Nodes" 
+           << std::setw(10) << "Time ms" << std::setw(10) << "Nodes %" << std::endl;
+    
+    for (const Config& config : configs) 
+    {
+        luna::Engine engine;
+        engine.set_null_move(config.null_move);
+        engine.set_lmr(config.lmr);
+        BenchTotals totals = bench_fixed_depth(engine, depth);
+        
+        if (base_nodes == 0) base_nodes = std::max<uint64_t>(totals.nodes, 1);
+        report << std::setw(12) << config.name << std::setw(14) << totals.nodes 
+               << std::setw(10) << totals.time_ms << std::setw(9) << std::fixed << std::setprecision(1)
+               << 100.0 * static_cast<double>(totals.nodes) / static_cast<double>(base_nodes) << "%" << std::endl;
+    }
+    
+    std::cout << std::endl << "Pruning bench, depth " << depth << ":" << std::endl << report.str();
+    return 0;
+}
+
+// Search the bench positions for a fixed time at each thread count and
+// print the NPS relative to a single thread
+int run_smp_bench(int movetime_ms) 
+{
+    const int thread_counts[] = {1, 2, 4, 8};
+    
+    uint64_t base_nps = 0;
+    std::ostringstream report;
+    report << std::setw(8) << "Threads" << std::setw(14) << "Nodes" 
+           << std::setw(12) << "NPS" << std::setw(10) << "Speedup" << std::endl;
+    
+    for (int threads : thread_counts) 
+    {
+        luna::Engine engine;
+        engine.set_threads(threads);
+        
+        auto [nodes, nps] = bench_search(engine, movetime_ms);
+        if (base_nps == 0) base_nps = std::max<uint64_t>(nps, 1);
+        
+        report << std::setw(8) << threads << std::setw(14) << nodes << std::setw(12) << nps 
+               << std::setw(9) << std::fixed << std::setprecision(2) 
+               << static_cast<double>(nps) / static_cast<double>(base_nps) << "x" << std::endl;
+    }
+    
+    std::cout << std::endl << report.str();
+    return 0;
+}
+
+// Fill a table with as many random positions as it has entries, then time
+// probes of stored keys (hit rate shows what replacement kept) and of
+// fresh keys (all misses). Then compare search NPS with and without
+// prefetching child entries.
+int run_tt_bench(size_t hash_mb, int movetime_ms) 
+{
+    luna::TranspositionTable tt(hash_mb);
+    size_t entry_count = hash_mb * 1024 * 1024 / sizeof(luna::TTEntry);
+    
+    std::mt19937_64 rng(20250812);
+    std::vector<uint64_t> keys(entry_count);
+    for (uint64_t& key : keys) key = rng();
+    
+    tt.new_search();
+    for (size_t i = 0; i < keys.size(); i++) 
+    {
+        tt.store(keys[i], 0, static_cast<int>(i % 16), luna::BoundType::EXACT, Move(), 0);
+    }
+    
+    // Probe in a shuffled order so consecutive probes touch unrelated lines
+    std::vector<uint64_t> probes(keys.begin(), keys.begin() + std::min<size_t>(keys.size(), 4000000));
+    std::shuffle(probes.begin(), probes.end(), rng);
+    
+    auto time_probes = [&](const std::vector<uint64_t>& probe_keys, size_t& hits) {
+        int score, depth;
+        luna::BoundType bound;
+        Move move;
+        hits = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t key : probe_keys) 
+        {
+            if (tt.probe(key, score, depth, bound, move, 0)) hits++;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(elapsed) / static_cast<double>(std::max<size_t>(probe_keys.size(), 1));
+    };
+    
+    size_t stored_hits = 0;
+    double stored_ns = time_probes(probes, stored_hits);
+    
+    for (uint64_t& key : probes) key = rng();
+    size_t fresh_hits = 0;
+    double fresh_ns = time_probes(probes, fresh_hits);
+    
+    std::cout << "Hash: " << tt.size_mb() << " MB, " << entry_count << " entries" << std::endl;
+    std::cout << "Hashfull after filling: " << tt.hashfull() << " permille" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Stored keys: hit rate " << (100.0 * stored_hits / probes.size()) << "%, " 
+              << stored_ns << " ns/probe" << std::endl;
+    std::cout << "Fresh keys:  hit rate " << (100.0 * fresh_hits / probes.size()) << "%, " 
+              << fresh_ns << " ns/probe" << std::endl;
+    
+    luna::Engine engine;
+    engine.set_hash_size(hash_mb);
+    
+    engine.set_hash_prefetch(false);
+    uint64_t plain_nps = bench_search(engine, movetime_ms).second;
+    engine.set_hash_prefetch(true);
+    uint64_t prefetch_nps = bench_search(engine, movetime_ms).second;
+    
+    std::cout << std::endl << "Search at " << engine.hash_size() << " MB hash:" << std::endl;
+    std::cout << "  Without prefetch: " << plain_nps << " nps" << std::endl;
+    std::cout << "  With prefetch:    " << prefetch_nps << " nps (" << std::showpos
+              << (100.0 * (static_cast<double>(prefetch_nps) / std::max<uint64_t>(plain_nps, 1) - 1.0)) 
+              << std::noshowpos << "%)" << std::endl;
+    return 0;
+}
+
+// Walk a perft tree, evaluating every node; returns the number of evaluations
+uint64_t evaluate_tree(Position& pos, int depth, luna::Evaluator& evaluator, int& checksum) 
+{
+    checksum += evaluator.evaluate(pos);
+    if (depth == 0) return 1;
+    
+    MoveList moves;
+    pos.generate_legal_moves(moves);
+    
+    uint64_t evals = 1;
+    for (const Move& move : moves) 
+    {
+        pos.make_move(move);
+        evals += evaluate_tree(pos, depth - 1, evaluator, checksum);
+        pos.undo_move();
+    }
+    return evals;
+}
+
+// Evaluate every node to depth 3 from the bench positions with each
+// evaluator, eval cache off. Making and unmaking the moves is included, as
+// in search, so the NNUE accumulators are updated incrementally.
+int run_nnue_bench(const std::string& eval_file) 
+{
+    luna::NnueNetwork network;
+    if (eval_file.empty()) 
+    {
+        network.randomize(20250817);
+    } 
+    else if (!network.load(eval_file)) 
+    {
+        std::cerr << "Could not load network: " << eval_file << std::endl;
+        return 1;
+    }
+    
+    luna::Evaluator classical;
+    luna::Evaluator nnue;
+    classical.set_cache_size(0);
+    nnue.set_cache_size(0);
+    nnue.set_network(&network);
+    
+    struct Run { const char* name; luna::Evaluator* evaluator; };
+    const Run runs[] = { { "Classical", &classical }, { "NNUE", &nnue } };
+    
+    std::cout << "NNUE kernels: " << luna::nnue_kernels::instruction_set() 
+              << (eval_file.empty() ? ", random network" : ", network " + eval_file) << std::endl;
+    for (const Run& run : runs) 
+    {
+        uint64_t evals = 0;
+        int checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const char* fen : BENCH_FENS) 
+        {
+            Position pos;
+            pos.load_fen(fen);
+            evals += evaluate_tree(pos, 3, *run.evaluator, checksum);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        
+        std::cout << "  " << std::left << std::setw(10) << run.name << std::right 
+                  << std::setw(10) << evals << " evals " << std::setw(8) << elapsed / 1000 << " ms " 
+                  << std::setw(12) << evals * 1000000 / static_cast<uint64_t>(std::max<int64_t>(elapsed, 1)) 
+                  << " evals/s (checksum " << checksum << ")" << std::endl;
+    }
+    return 0;
+}
+
+// Snapshot the positions of a perft tree into out, stopping at limit
+void collect_boards(Position& pos, int depth, std::vector<luna::BoardSnapshot>& out, size_t limit) 
+{
+    if (out.size() >= limit) return;
+    out.push_back(luna::snapshot_position(pos));
+    if (depth == 0) return;
+    
+    MoveList moves;
+    pos.generate_legal_moves(moves);
+    for (const Move& move : moves) 
+    {
+        pos.make_move(move);
+        collect_boards(pos, depth - 1, out, limit);
+        pos.undo_move();
+    }
+}
+
+// Evaluate a set of positions the size of an EPD or tuning file, one board
+// per call and then in batches
+int run_batch_bench(size_t count, int rounds) 
+{
+    std::vector<luna::BoardSnapshot> boards;
+    boards.reserve(count);
+    size_t per_fen = count / (sizeof(BENCH_FENS) / sizeof(BENCH_FENS[0])) + 1;
+    for (const char* fen : BENCH_FENS) 
+    {
+        Position pos;
+        pos.load_fen(fen);
+        collect_boards(pos, 4, boards, std::min(count, boards.size() + per_fen));
+    }
+    
+    luna::Evaluator evaluator;
+    evaluator.set_cache_size(0);
+    std::vector<int> scores(boards.size());
+    
+    auto report = [&](const char* name, const std::function<void()>& run) 
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) run();
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        
+        uint64_t evals = static_cast<uint64_t>(rounds) * boards.size();
+        int64_t checksum = 0;
+        for (int score : scores) checksum += score;
+        std::cout << "  " << std::left << std::setw(10) << name << std::right 
+                  << std::setw(10) << evals << " evals " << std::setw(8) << elapsed / 1000 << " ms " 
+                  << std::setw(12) << evals * 1000000 / static_cast<uint64_t>(std::max<int64_t>(elapsed, 1)) 
+                  << " evals/s (checksum " << checksum << ")" << std::endl;
+    };
+    
+    std::cout << "Batch kernels: " << luna::batch_kernels::instruction_set() << ", " 
+              << boards.size() << " positions (" << boards.size() * sizeof(luna::BoardSnapshot) / 1024 
+              << " KB) x " << rounds << " rounds" << std::endl;
+    report("Single", [&]() 
+    {
+        for (size_t i = 0; i < boards.size(); i++) evaluator.evaluate_batch(&boards[i], 1, &scores[i]);
+    });
+    report("Batched", [&]() 
+    {
+        evaluator.evaluate_batch(boards.data(), boards.size(), scores.data());
+    });
+    return 0;
+}
+
 int main(int argc, char* argv[]) 
 {
     // Initialize attack tables (required for move generation)
@@ -33,13 +423,45 @@ int main(int argc, char* argv[])
     if (argc > 1) {
         std::string arg = argv[1];
         
-        if (arg == "--test") {
-            // Run tests if requested
-            luna::ChessTests tests;
-            tests.set_visualization(true);
-            tests.set_perft_depth(3);
-            tests.run_all_tests();
-            return tests.all_tests_passed() ? 0 : 1;
+        if (arg == "--perft") {
+            if (argc < 3) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            
+            int depth = std::stoi(argv[2]);
+            std::string fen = (argc > 3) ? argv[3] : "startpos";
+            int threads = (argc > 4) ? std::stoi(argv[4]) : 1;
+            size_t hash_mb = (argc > 5) ? static_cast<size_t>(std::stoul(argv[5])) : 0;
+            
+            Position pos;
+            if (fen != "startpos" && !pos.load_fen(fen)) {
+                std::cerr << "Invalid FEN: " << fen << std::endl;
+                return 1;
+            }
+            
+            luna::Perft perft(hash_mb);
+            luna::Perft::print_result(std::cout, perft.run(pos, depth, threads));
+            return 0;
+        } else if (arg == "--bench") {
+            int depth = (argc > 2) ? std::stoi(argv[2]) : 6;
+            return run_bench(depth);
+        } else if (arg == "--pruning-bench") {
+            int depth = (argc > 2) ? std::stoi(argv[2]) : 8;
+            return run_pruning_bench(depth);
+        } else if (arg == "--smp-bench") {
+            int movetime_ms = (argc > 2) ? std::stoi(argv[2]) : 1000;
+            return run_smp_bench(movetime_ms);
+        } else if (arg == "--tt-bench") {
+            size_t hash_mb = (argc > 2) ? static_cast<size_t>(std::stoul(argv[2])) : 256;
+            int movetime_ms = (argc > 3) ? std::stoi(argv[3]) : 1000;
+            return run_tt_bench(hash_mb, movetime_ms);
+        } else if (arg == "--nnue-bench") {
+            return run_nnue_bench(argc > 2 ? argv[2] : "");
+        } else if (arg == "--batch-bench") {
+            size_t count = (argc > 2) ? std::stoul(argv[2]) : 100000;
+            int rounds = (argc > 3) ? std::stoi(argv[3]) : 10;
+            return run_batch_bench(count, rounds);
         } else if (arg == "--help" || arg == "-h") {
             print_usage(argv[0]);
             return 0;
@@ -2,50 +2,113 @@
     Implementation of main chess engine class.
     Coordinates search, evaluation, and time management.
 
+    UPDATE: Lazy SMP. Helper threads search copies of the root position
+    against the shared transposition table; the main thread stops them when
+    it finishes and the reported move is chosen by a vote across threads.
+
     Author: Nicolas Miller
     Date: 07/09/2025
 */
 
 #include "ChessEngine/include/engine.h"
 #include "ChessEngine/include/constants.h"
+#include <algorithm>
 #include <iostream>
+#include <map>
+#include <new>
+#include <thread>
 
 namespace luna 
 {
 
 Engine::Engine() 
-    : max_depth_(DEFAULT_SEARCH_DEPTH)
+    : max_depth_(DEFAULT_SEARCH_DEPTH), null_move_(true), lmr_(true), pvs_(true), 
+      eval_cache_mb_(DEFAULT_EVAL_CACHE_MB)
     {
         // Initialize components
-        evaluator_ = std::make_unique<Evaluator>();
-        search_ = std::make_unique<Search>(evaluator_.get());
+        tt_ = std::make_unique<TranspositionTable>(DEFAULT_HASH_SIZE_MB);
         time_manager_ = std::make_unique<TimeManager>();
+        set_threads(DEFAULT_SEARCH_THREADS);
     }
 
 Engine::~Engine() = default;
 
 Move Engine::find_best_move(const Position& position, int time_ms) 
+{
+    time_manager_->start_search(time_ms);
+    return search(position);
+}
+
+Move Engine::find_best_move(const Position& position, const SearchLimits& limits) 
+{
+    time_manager_->start_search(limits);
+    return search(position);
+}
+
+Move Engine::search(const Position& position) 
 {
     // Make a copy of the position to search
     Position search_position = position;
     
-    // Start time management
-    time_manager_->start_search(time_ms);
+    // One table generation per search, shared by all threads
+    tt_->new_search();
+    for (auto& search : searches_) 
+    {
+        search->reset_stop();
+    }
     
-    // Search for best move
-    Move best_move = search_->search_position(search_position, max_depth_, time_manager_.get());
+    // Launch helpers on their own copies of the position
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < searches_.size(); i++) 
+    {
+        helpers.emplace_back([this, i, &position]() {
+            Position helper_position = position;
+            searches_[i]->search_position(helper_position, max_depth_, nullptr);
+        });
+    }
+    
+    // Search for best move on this thread
+    Move best_move = searches_[0]->search_position(search_position, max_depth_, time_manager_.get());
     
-    // Get search statistics
-    const Search::SearchInfo& info = search_->get_search_info();
+    // The main thread decides when the search ends
+    for (size_t i = 1; i < searches_.size(); i++) 
+    {
+        searches_[i]->stop();
+    }
+    for (std::thread& helper : helpers) 
+    {
+        helper.join();
+    }
+    
+    // Take the voted move, reporting nodes from every thread
+    const Search* best_thread = pick_best_thread();
+    info_ = best_thread->get_search_info();
+    info_.nodes_searched = 0;
+    for (const auto& search : searches_) 
+    {
+        info_.nodes_searched += search->nodes();
+    }
+    info_.eval_cache_hits = 0;
+    info_.eval_cache_misses = 0;
+    for (const auto& evaluator : evaluators_) 
+    {
+        info_.eval_cache_hits += evaluator->cache_hits();
+        info_.eval_cache_misses += evaluator->cache_misses();
+    }
+    if (best_thread != searches_[0].get() && !info_.pv.empty()) 
+    {
+        best_move = info_.pv[0];
+    }
     
     // Print final search summary
-    std::cout << "Engine: Searched " << info.nodes_searched << " nodes"
-              << " to depth " << info.depth_reached
+    std::cout << "Engine: Searched " << info_.nodes_searched << " nodes"
+              << " to depth " << info_.depth_reached
               << " in " << time_manager_->elapsed_ms() << " ms"
-              << " (score: " << info.score << ")" << std::endl;
+              << " with " << searches_.size() << " thread(s)"
+              << " (score: " << info_.score << ")" << std::endl;
     
     // If no move was found (shouldn't happen), return first legal move
-    if (best_move.from_square == Square::None) 
+    if (best_move.is_none()) 
     {
         std::cerr << "Warning: No best move found, returning first legal move" << std::endl;
         std::vector<Move> legal_moves = search_position.generate_legal_moves();
@@ -60,14 +123,175 @@ void Engine::set_max_depth(int depth)
     max_depth_ = std::max(1, std::min(depth, MAX_SEARCH_DEPTH));
 }
 
+void Engine::set_hash_size(size_t size_mb) 
+{
+    size_mb = std::max(MIN_HASH_SIZE_MB, std::min(size_mb, MAX_HASH_SIZE_MB));
+    tt_->resize(size_mb, threads());
+}
+
+void Engine::clear_hash() 
+{
+    tt_->clear(threads());
+}
+
+void Engine::set_threads(int threads) 
+{
+    threads = std::max(1, std::min(threads, MAX_SEARCH_THREADS));
+    
+    // Each thread gets its own evaluator and search state (killers etc.)
+    searches_.clear();
+    evaluators_.clear();
+    bool cache_failed = false;
+    for (int i = 0; i < threads; i++) 
+    {
+        evaluators_.push_back(std::make_unique<Evaluator>());
+        try 
+        {
+            evaluators_.back()->set_cache_size(eval_cache_mb_);
+        } 
+        catch (const std::bad_alloc&) 
+        {
+            cache_failed = true;
+        }
+        evaluators_.back()->set_network(network_.get());
+        searches_.push_back(std::make_unique<Search>(evaluators_.back().get(), tt_.get(), i));
+        searches_.back()->set_null_move(null_move_);
+        searches_.back()->set_lmr(lmr_);
+        searches_.back()->set_pvs(pvs_);
+    }
+    
+    // The main thread reports node counts including its helpers
+    std::vector<const Search*> helpers;
+    for (size_t i = 1; i < searches_.size(); i++) 
+    {
+        helpers.push_back(searches_[i].get());
+    }
+    searches_[0]->set_helpers(helpers);
+    
+    // Every thread exists; without memory for all their caches, run with none
+    if (cache_failed) 
+    {
+        set_eval_cache_size(0);
+        throw std::bad_alloc();
+    }
+}
+
+void Engine::set_null_move(bool enabled) 
+{
+    null_move_ = enabled;
+    for (auto& search : searches_) 
+    {
+        search->set_null_move(enabled);
+    }
+}
+
+void Engine::set_lmr(bool enabled) 
+{
+    lmr_ = enabled;
+    for (auto& search : searches_) 
+    {
+        search->set_lmr(enabled);
+    }
+}
+
+void Engine::set_pvs(bool enabled) 
+{
+    pvs_ = enabled;
+    for (auto& search : searches_) 
+    {
+        search->set_pvs(enabled);
+    }
+}
+
+bool Engine::set_eval_file(const std::string& path) 
+{
+    std::unique_ptr<NnueNetwork> network;
+    if (!path.empty()) 
+    {
+        network = std::make_unique<NnueNetwork>();
+        if (!network->load(path)) return false;
+    }
+    
+    // Point the evaluators away from the old network before freeing it
+    for (auto& evaluator : evaluators_) 
+    {
+        evaluator->set_network(network.get());
+    }
+    network_ = std::move(network);
+    return true;
+}
+
+void Engine::set_eval_cache_size(size_t size_mb) 
+{
+    eval_cache_mb_ = std::min(size_mb, MAX_EVAL_CACHE_MB);
+    try 
+    {
+        for (auto& evaluator : evaluators_) 
+        {
+            evaluator->set_cache_size(eval_cache_mb_);
+        }
+    } 
+    catch (const std::bad_alloc&) 
+    {
+        // Disable every thread's cache rather than leave them uneven
+        eval_cache_mb_ = 0;
+        for (auto& evaluator : evaluators_) 
+        {
+            evaluator->set_cache_size(0);
+        }
+        throw;
+    }
+}
+
 const Search::SearchInfo& Engine::get_search_info() const
 {
-    return search_->get_search_info();
+    return info_;
 }
 
 void Engine::stop_search()
 {
-    search_->stop();
+    for (auto& search : searches_) 
+    {
+        search->stop();
+    }
+}
+
+const Search* Engine::pick_best_thread() const 
+{
+    const Search* best_thread = searches_[0].get();
+    if (searches_.size() == 1) return best_thread;
+    
+    // Each thread votes for its move with a weight that grows with its score
+    // (relative to the worst thread) and with the depth it completed
+    int min_score = INFINITY_SCORE;
+    for (const auto& search : searches_) 
+    {
+        const Search::SearchInfo& info = search->get_search_info();
+        if (!info.pv.empty()) min_score = std::min(min_score, info.score);
+    }
+    
+    std::map<uint16_t, int64_t> votes;
+    for (const auto& search : searches_) 
+    {
+        const Search::SearchInfo& info = search->get_search_info();
+        if (info.pv.empty()) continue;
+        votes[info.pv[0].raw()] += static_cast<int64_t>(info.score - min_score + SMP_VOTE_BASE) * info.depth_reached;
+    }
+    
+    // Ties go to the earliest thread in the list, so the main thread wins them
+    for (const auto& search : searches_) 
+    {
+        const Search::SearchInfo& info = search->get_search_info();
+        if (info.pv.empty()) continue;
+        
+        const Search::SearchInfo& best_info = best_thread->get_search_info();
+        if (best_info.pv.empty() || votes[info.pv[0].raw()] > votes[best_info.pv[0].raw()]) 
+        {
+            best_thread = search.get();
+        }
+    }
+    
+    return best_thread;
 }
 
 } // namespace luna
@@ -0,0 +1,254 @@
+/*
+    Implementation of the batched evaluation layout and kernels.
+
+    Author: Nicolas Miller
+    Date: 08/21/2025
+*/
+
+#include "eval_batch.h"
+#include "constants.h"
+#include "position.h"
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LUNA_BATCH_AVX2 1
+#endif
+
+namespace luna {
+
+namespace {
+
+// D4, E4, D5 and E5
+constexpr uint64_t CENTER_SQUARES = (1ULL << 27) | (1ULL << 28) | (1ULL << 35) | (1ULL << 36);
+
+#if defined(LUNA_BATCH_AVX2)
+
+constexpr uint64_t NOT_FILE_A = ~masks::FILE_A;
+constexpr uint64_t NOT_FILE_AB = ~(masks::FILE_A | (masks::FILE_A << 1));
+constexpr uint64_t NOT_FILE_H = ~(masks::FILE_A << 7);
+constexpr uint64_t NOT_FILE_GH = ~((masks::FILE_A << 6) | (masks::FILE_A << 7));
+
+inline __m256i load(const uint64_t* lanes)
+{
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes));
+}
+
+inline __m256i broadcast(uint64_t bits)
+{
+    return _mm256_set1_epi64x(static_cast<long long>(bits));
+}
+
+// Shift every lane towards higher squares for S > 0, lower for S < 0
+template <int S>
+inline __m256i shift(__m256i b)
+{
+    if constexpr (S > 0) return _mm256_slli_epi64(b, S);
+    else return _mm256_srli_epi64(b, -S);
+}
+
+// Kogge-Stone fill of gen along one direction through empty squares; the
+// result includes the first blocker, like the magic attack tables. wrap
+// drops squares a shift carried across the board edge.
+template <int S>
+inline __m256i slide(__m256i gen, __m256i empty, __m256i wrap)
+{
+    __m256i pro = _mm256_and_si256(empty, wrap);
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift<S>(gen)));
+    pro = _mm256_and_si256(pro, shift<S>(pro));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift<2 * S>(gen)));
+    pro = _mm256_and_si256(pro, shift<2 * S>(pro));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift<4 * S>(gen)));
+    return _mm256_and_si256(shift<S>(gen), wrap);
+}
+
+inline __m256i knight_attacks(__m256i b)
+{
+    __m256i l1 = _mm256_and_si256(_mm256_srli_epi64(b, 1), broadcast(NOT_FILE_H));
+    __m256i l2 = _mm256_and_si256(_mm256_srli_epi64(b, 2), broadcast(NOT_FILE_GH));
+    __m256i r1 = _mm256_and_si256(_mm256_slli_epi64(b, 1), broadcast(NOT_FILE_A));
+    __m256i r2 = _mm256_and_si256(_mm256_slli_epi64(b, 2), broadcast(NOT_FILE_AB));
+    __m256i h1 = _mm256_or_si256(l1, r1);
+    __m256i h2 = _mm256_or_si256(l2, r2);
+    return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi64(h1, 16), _mm256_srli_epi64(h1, 16)),
+                           _mm256_or_si256(_mm256_slli_epi64(h2, 8), _mm256_srli_epi64(h2, 8)));
+}
+
+inline __m256i bishop_attacks(__m256i b, __m256i empty)
+{
+    __m256i not_a = broadcast(NOT_FILE_A);
+    __m256i not_h = broadcast(NOT_FILE_H);
+    return _mm256_or_si256(_mm256_or_si256(slide<9>(b, empty, not_a), slide<7>(b, empty, not_h)),
+                           _mm256_or_si256(slide<-7>(b, empty, not_a), slide<-9>(b, empty, not_h)));
+}
+
+inline __m256i rook_attacks(__m256i b, __m256i empty)
+{
+    __m256i all = _mm256_set1_epi64x(-1);
+    return _mm256_or_si256(_mm256_or_si256(slide<8>(b, empty, all), slide<-8>(b, empty, all)),
+                           _mm256_or_si256(slide<1>(b, empty, broadcast(NOT_FILE_A)),
+                                           slide<-1>(b, empty, broadcast(NOT_FILE_H))));
+}
+
+// Population count of each 64-bit lane: look up each nibble's count, then
+// sum the bytes of a lane
+inline __m256i popcount(__m256i v)
+{
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_and_si256(v, low_nibble);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibble);
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(table, lo), _mm256_shuffle_epi8(table, hi));
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+// Sum over the pieces of each lane of the squares they attack that do not
+// hold their own pieces. The lanes step through their pieces together,
+// lowest first; a lane out of pieces adds nothing.
+template <typename Attacks>
+inline __m256i piece_mobility(__m256i pieces, __m256i not_own, Attacks attacks)
+{
+    __m256i total = _mm256_setzero_si256();
+    while (!_mm256_testz_si256(pieces, pieces))
+    {
+        __m256i piece = _mm256_and_si256(pieces, _mm256_sub_epi64(_mm256_setzero_si256(), pieces));
+        pieces = _mm256_xor_si256(pieces, piece);
+        total = _mm256_add_epi64(total, popcount(_mm256_and_si256(attacks(piece), not_own)));
+    }
+    return total;
+}
+
+#endif
+
+} // namespace
+
+BoardSnapshot snapshot_position(const Position& pos)
+{
+    BoardSnapshot board;
+    for (int c = 0; c < 2; c++)
+    {
+        for (int pt = 0; pt < 6; pt++)
+        {
+            board.piece_bits[c][pt] = pos.pieces(static_cast<Color>(c), static_cast<PieceType>(pt)).value();
+        }
+    }
+    board.pawn_hash = pos.pawn_key();
+    board.psq = pos.psq_score();
+    board.phase = pos.game_phase();
+    board.castling = pos.castling_rights();
+    board.stm = pos.side_to_move();
+    return board;
+}
+
+void load_lanes(const BoardSnapshot* boards, size_t count, BitboardLanes& lanes)
+{
+    std::memset(&lanes, 0, sizeof(lanes));
+
+    for (size_t i = 0; i < count && i < BATCH_LANES; i++)
+    {
+        const BoardSnapshot& board = boards[i];
+        lanes.occupied[i] = board.occupied().value();
+        for (Color c : { Color::White, Color::Black })
+        {
+            int ci = static_cast<int>(c);
+            lanes.own[ci][i] = board.occupied_by_color(c).value();
+            lanes.knights[ci][i] = board.pieces(c, PieceType::Knight).value();
+            lanes.bishops[ci][i] = board.pieces(c, PieceType::Bishop).value();
+            lanes.rooks[ci][i] = board.pieces(c, PieceType::Rook).value();
+        }
+    }
+}
+
+namespace batch_kernels {
+
+void mobility_scalar(const BitboardLanes& lanes, int* out)
+{
+    for (size_t i = 0; i < BATCH_LANES; i++)
+    {
+        Bitboard occupied(lanes.occupied[i]);
+        int mobility[2] = { 0, 0 };
+        int center[2] = { 0, 0 };
+
+        for (int c = 0; c < 2; c++)
+        {
+            Bitboard not_own = ~Bitboard(lanes.own[c][i]);
+
+            Bitboard knights(lanes.knights[c][i]);
+            while (knights.any())
+            {
+                Square sq = static_cast<Square>(knights.pop_lsb());
+                mobility[c] += (Bitboard::knight_attacks(sq) & not_own).count_bits();
+            }
+
+            Bitboard bishops(lanes.bishops[c][i]);
+            while (bishops.any())
+            {
+                Square sq = static_cast<Square>(bishops.pop_lsb());
+                mobility[c] += (Bitboard::bishop_attacks(sq, occupied) & not_own).count_bits();
+            }
+
+            Bitboard rooks(lanes.rooks[c][i]);
+            while (rooks.any())
+            {
+                Square sq = static_cast<Square>(rooks.pop_lsb());
+                mobility[c] += (Bitboard::rook_attacks(sq, occupied) & not_own).count_bits();
+            }
+
+            center[c] = Bitboard(lanes.own[c][i] & CENTER_SQUARES).count_bits();
+        }
+
+        out[i] = (mobility[0] - mobility[1]) * MOBILITY_SCORE_MULTIPLIER +
+                 (center[0] - center[1]) * CENTER_CONTROL_BONUS;
+    }
+}
+
+#if defined(LUNA_BATCH_AVX2)
+
+void mobility(const BitboardLanes& lanes, int* out)
+{
+    __m256i empty = _mm256_xor_si256(load(lanes.occupied), _mm256_set1_epi64x(-1));
+    __m256i mobility[2];
+    __m256i center[2];
+
+    for (int c = 0; c < 2; c++)
+    {
+        __m256i own = load(lanes.own[c]);
+        __m256i not_own = _mm256_andnot_si256(own, _mm256_set1_epi64x(-1));
+
+        mobility[c] = _mm256_add_epi64(
+            piece_mobility(load(lanes.knights[c]), not_own, [](__m256i b) { return knight_attacks(b); }),
+            _mm256_add_epi64(
+                piece_mobility(load(lanes.bishops[c]), not_own, [empty](__m256i b) { return bishop_attacks(b, empty); }),
+                piece_mobility(load(lanes.rooks[c]), not_own, [empty](__m256i b) { return rook_attacks(b, empty); })));
+        center[c] = popcount(_mm256_and_si256(own, broadcast(CENTER_SQUARES)));
+    }
+
+    alignas(32) int64_t mobility_diff[BATCH_LANES];
+    alignas(32) int64_t center_diff[BATCH_LANES];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(mobility_diff), _mm256_sub_epi64(mobility[0], mobility[1]));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(center_diff), _mm256_sub_epi64(center[0], center[1]));
+
+    for (size_t i = 0; i < BATCH_LANES; i++)
+    {
+        out[i] = static_cast<int>(mobility_diff[i]) * MOBILITY_SCORE_MULTIPLIER +
+                 static_cast<int>(center_diff[i]) * CENTER_CONTROL_BONUS;
+    }
+}
+
+const char* instruction_set() { return "AVX2"; }
+
+#else
+
+void mobility(const BitboardLanes& lanes, int* out)
+{
+    mobility_scalar(lanes, out);
+}
+
+const char* instruction_set() { return "scalar"; }
+
+#endif
+
+} // namespace batch_kernels
+
+} // namespace luna
@@ -0,0 +1,46 @@
+/*
+    Implementation of the evaluation cache.
+
+    Author: Nicolas Miller
+    Date: 08/16/2025
+*/
+
+#include "eval_cache.h"
+
+#include <algorithm>
+
+namespace luna {
+
+EvalCache::EvalCache(size_t size_mb)
+    : mask_(0), size_mb_(0)
+{
+    resize(size_mb);
+}
+
+void EvalCache::resize(size_t size_mb)
+{
+    size_t entries = 0;
+    if (size_mb > 0)
+    {
+        size_t max_entries = size_mb * 1024 * 1024 / sizeof(EvalCacheEntry);
+        entries = 1;
+        while (entries * 2 <= max_entries) entries *= 2;
+    }
+    
+    // Release the old table first, so both never have to fit in memory at
+    // once and a failed allocation leaves the cache disabled
+    std::vector<EvalCacheEntry>().swap(table_);
+    mask_ = 0;
+    size_mb_ = 0;
+    
+    table_.resize(entries);
+    mask_ = entries > 0 ? entries - 1 : 0;
+    size_mb_ = size_mb;
+}
+
+void EvalCache::clear()
+{
+    std::fill(table_.begin(), table_.end(), EvalCacheEntry());
+}
+
+} // namespace luna
@@ -7,320 +7,157 @@
 
 #include "evaluator.h"
 #include "constants.h"
+#include "psqt.h"
 #include <algorithm>
 
 namespace luna {
 
-// Piece-square tables (from white's perspective)
-// Positive values are good for the piece, negative are bad
-// Values are mirrored for black pieces.
-//
-// Note: These PSTs are taken from the chess programming wiki and are considered a 
-// starting point; there's a lot of opportunity here for fine tuning
-
-const int Evaluator::pawn_table[64] = 
-{
-     0,  0,  0,  0,  0,  0,  0,  0,
-    50, 50, 50, 50, 50, 50, 50, 50,
-    10, 10, 20, 30, 30, 20, 10, 10,
-     5,  5, 10, 25, 25, 10,  5,  5,
-     0,  0,  0, 20, 20,  0,  0,  0,
-     5, -5,-10,  0,  0,-10, -5,  5,
-     5, 10, 10,-20,-20, 10, 10,  5,
-     0,  0,  0,  0,  0,  0,  0,  0
-};
-
-const int Evaluator::knight_table[64] = 
-{
-    -50,-40,-30,-30,-30,-30,-40,-50,
-    -40,-20,  0,  0,  0,  0,-20,-40,
-    -30,  0, 10, 15, 15, 10,  0,-30,
-    -30,  5, 15, 20, 20, 15,  5,-30,
-    -30,  0, 15, 20, 20, 15,  0,-30,
-    -30,  5, 10, 15, 15, 10,  5,-30,
-    -40,-20,  0,  5,  5,  0,-20,-40,
-    -50,-40,-30,-30,-30,-30,-40,-50
-};
-
-const int Evaluator::bishop_table[64] = 
+Evaluator::Evaluator() 
+    : eval_cache_(DEFAULT_EVAL_CACHE_MB), cache_hits_(0), cache_misses_(0) 
 {
-    -20,-10,-10,-10,-10,-10,-10,-20,
-    -10,  0,  0,  0,  0,  0,  0,-10,
-    -10,  0,  5, 10, 10,  5,  0,-10,
-    -10,  5,  5, 10, 10,  5,  5,-10,
-    -10,  0, 10, 10, 10, 10,  0,-10,
-    -10, 10, 10, 10, 10, 10, 10,-10,
-    -10,  5,  0,  0,  0,  0,  5,-10,
-    -20,-10,-10,-10,-10,-10,-10,-20
-};
-
-const int Evaluator::rook_table[64] = 
-{
-     0,  0,  0,  0,  0,  0,  0,  0,
-     5, 10, 10, 10, 10, 10, 10,  5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-     0,  0,  0,  5,  5,  0,  0,  0
-};
-
-const int Evaluator::queen_table[64] = 
-{
-    -20,-10,-10, -5, -5,-10,-10,-20,
-    -10,  0,  0,  0,  0,  0,  0,-10,
-    -10,  0,  5,  5,  5,  5,  0,-10,
-     -5,  0,  5,  5,  5,  5,  0, -5,
-      0,  0,  5,  5,  5,  5,  0, -5,
-    -10,  5,  5,  5,  5,  5,  0,-10,
-    -10,  0,  5,  0,  0,  0,  0,-10,
-    -20,-10,-10, -5, -5,-10,-10,-20
-};
-
-const int Evaluator::king_middlegame_table[64] = 
-{
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -20,-30,-30,-40,-40,-30,-30,-20,
-    -10,-20,-20,-20,-20,-20,-20,-10,
-     20, 20,  0,  0,  0,  0, 20, 20,
-     20, 30, 10,  0,  0, 10, 30, 20
-};
-
-const int Evaluator::king_endgame_table[64] = 
-{
-    -50,-40,-30,-20,-20,-30,-40,-50,
-    -30,-20,-10,  0,  0,-10,-20,-30,
-    -30,-10, 20, 30, 30, 20,-10,-30,
-    -30,-10, 30, 40, 40, 30,-10,-30,
-    -30,-10, 30, 40, 40, 30,-10,-30,
-    -30,-10, 20, 30, 30, 20,-10,-30,
-    -30,-30,  0,  0,  0,  0,-30,-30,
-    -50,-30,-30,-30,-30,-30,-30,-50
-};
-
-Evaluator::Evaluator() {}
+}
 
 int Evaluator::evaluate(const Position& position) 
 {
-    // Return 0 for drawn positions (only kings)
-    if (is_only_kings(position)) return 0;
-    
-    int score = 0;
-    
-    // Evaluate all components from white's perspective
-    score += evaluate_material(position);
-    score += evaluate_piece_squares(position);
-    score += evaluate_pawn_structure(position);
-    score += evaluate_king_safety(position);
-    score += evaluate_mobility(position);
-    score += evaluate_piece_bonuses(position);
+    int score;
+    if (eval_cache_.probe(position.hash_key(), score)) 
+    {
+        cache_hits_++;
+        return score;
+    }
     
-    // IMPORTANT: Return score from side to move's perspective for negamax
-    return position.side_to_move() == Color::White ? score : -score;
+    cache_misses_++;
+    score = compute(position);
+    eval_cache_.store(position.hash_key(), score);
+    return score;
 }
 
-int Evaluator::evaluate_material(const Position& pos) 
+void Evaluator::set_network(const NnueNetwork* network) 
 {
-    // Initialize material count
-    int white_material = 0;
-    int black_material = 0;
-    
-    // Count material for white
-    white_material += pos.pieces(Color::White, PieceType::Pawn).count_bits() * PAWN_VALUE;
-    white_material += pos.pieces(Color::White, PieceType::Knight).count_bits() * KNIGHT_VALUE;
-    white_material += pos.pieces(Color::White, PieceType::Bishop).count_bits() * BISHOP_VALUE;
-    white_material += pos.pieces(Color::White, PieceType::Rook).count_bits() * ROOK_VALUE;
-    white_material += pos.pieces(Color::White, PieceType::Queen).count_bits() * QUEEN_VALUE;
-    
-    // Count material for black
-    black_material += pos.pieces(Color::Black, PieceType::Pawn).count_bits() * PAWN_VALUE;
-    black_material += pos.pieces(Color::Black, PieceType::Knight).count_bits() * KNIGHT_VALUE;
-    black_material += pos.pieces(Color::Black, PieceType::Bishop).count_bits() * BISHOP_VALUE;
-    black_material += pos.pieces(Color::Black, PieceType::Rook).count_bits() * ROOK_VALUE;
-    black_material += pos.pieces(Color::Black, PieceType::Queen).count_bits() * QUEEN_VALUE;
-    
-    return white_material - black_material;
+    nnue_.reset(network ? new NnueEvaluator(network) : nullptr);
+    
+    // Cached scores came from the other evaluation
+    eval_cache_.clear();
 }
 
-int Evaluator::evaluate_piece_squares(const Position& pos) 
+int Evaluator::compute(const Position& position) 
 {
-    // Initialize scores
-    int white_score = 0;
-    int black_score = 0;
+    // Return 0 for drawn positions (only kings)
+    if (is_only_kings(position)) return 0;
     
-    // Determine game phase. Just using material count right now but could attempt some
-    // other ways of determining phase and see how that impacts engine behavior.
-    int total_material = 0;
-    total_material += (pos.pieces(Color::White, PieceType::Queen).count_bits() + 
-                      pos.pieces(Color::Black, PieceType::Queen).count_bits()) * QUEEN_VALUE;
-    total_material += (pos.pieces(Color::White, PieceType::Rook).count_bits() + 
-                      pos.pieces(Color::Black, PieceType::Rook).count_bits()) * ROOK_VALUE;
-    total_material += (pos.pieces(Color::White, PieceType::Bishop).count_bits() + 
-                      pos.pieces(Color::Black, PieceType::Bishop).count_bits()) * BISHOP_VALUE;
-    total_material += (pos.pieces(Color::White, PieceType::Knight).count_bits() + 
-                      pos.pieces(Color::Black, PieceType::Knight).count_bits()) * KNIGHT_VALUE;
-    
-    // Determine if we're in endgame based on material count vs. threshold 
-    bool is_endgame = total_material < ENDGAME_MATERIAL_THRESHOLD;
-    
-    // Evaluate each piece type for white
-    evaluate_piece_type_squares(pos, Color::White, PieceType::Pawn, pawn_table, white_score);
-    evaluate_piece_type_squares(pos, Color::White, PieceType::Knight, knight_table, white_score);
-    evaluate_piece_type_squares(pos, Color::White, PieceType::Bishop, bishop_table, white_score);
-    evaluate_piece_type_squares(pos, Color::White, PieceType::Rook, rook_table, white_score);
-    evaluate_piece_type_squares(pos, Color::White, PieceType::Queen, queen_table, white_score);
-    
-    // Evaluate each piece type for black
-    evaluate_piece_type_squares(pos, Color::Black, PieceType::Pawn, pawn_table, black_score);
-    evaluate_piece_type_squares(pos, Color::Black, PieceType::Knight, knight_table, black_score);
-    evaluate_piece_type_squares(pos, Color::Black, PieceType::Bishop, bishop_table, black_score);
-    evaluate_piece_type_squares(pos, Color::Black, PieceType::Rook, rook_table, black_score);
-    evaluate_piece_type_squares(pos, Color::Black, PieceType::Queen, queen_table, black_score);
-    
-    // Evaluate kings based on game state
-    const int* king_table = is_endgame ? king_endgame_table : king_middlegame_table;
-    evaluate_piece_type_squares(pos, Color::White, PieceType::King, king_table, white_score);
-    evaluate_piece_type_squares(pos, Color::Black, PieceType::King, king_table, black_score);
+    if (nnue_) return nnue_->evaluate(position);
     
-    return white_score - black_score;
+    return classical(position, evaluate_mobility(position));
 }
 
-void Evaluator::evaluate_piece_type_squares(const Position& pos, Color color, PieceType type,
-                                            const int table[64], int& score) 
+void Evaluator::evaluate_batch(const BoardSnapshot* boards, size_t count, int* scores) 
 {
-    // Get copy of bitboard for colored piece
-    Bitboard pieces = pos.pieces(color, type);
+    // Snapshots have no move history, so network accumulators are built
+    // from scratch one board at a time
+    if (nnue_) 
+    {
+        for (size_t i = 0; i < count; i++) 
+        {
+            scores[i] = is_only_kings(boards[i]) ? 0 : nnue_->evaluate(boards[i]);
+        }
+        return;
+    }
     
-    // Add scores for each piece position on the board
-    while (pieces.count_bits() > 0) 
+    BitboardLanes lanes;
+    int mobility[BATCH_LANES];
+    for (size_t base = 0; base < count; base += BATCH_LANES) 
     {
-        Square sq = static_cast<Square>(pieces.pop_lsb());
-        int table_index = static_cast<int>(sq);
+        size_t lane_count = std::min(BATCH_LANES, count - base);
+        load_lanes(boards + base, lane_count, lanes);
+        batch_kernels::mobility(lanes, mobility);
         
-        // For black pieces, mirror the table vertically
-        if (color == Color::Black) 
+        for (size_t i = 0; i < lane_count; i++) 
         {
-            int rank = table_index / 8;
-            int file = table_index % 8;
-            table_index = (7 - rank) * 8 + file;
+            const BoardSnapshot& board = boards[base + i];
+            scores[base + i] = is_only_kings(board) ? 0 : classical(board, mobility[i]);
         }
-        
-        score += table[table_index];
     }
 }
 
-int Evaluator::evaluate_pawn_structure(const Position& pos) 
+template <typename Board>
+int Evaluator::classical(const Board& position, int mobility) 
 {
-    // Initialize scores
-    int white_score = 0;
-    int black_score = 0;
+    // Material and piece-square terms are kept incrementally by the
+    // position; taper between their middlegame and endgame values by phase
+    Score psq = position.psq_score();
+    int phase = std::min(position.game_phase(), MAX_PHASE);
+    int score = (psq.mg * phase + psq.eg * (MAX_PHASE - phase)) / MAX_PHASE;
     
-    // Evaluate white pawns
-    Bitboard white_pawns = pos.pieces(Color::White, PieceType::Pawn);
-    Bitboard white_pawns_copy = white_pawns;
+    // Evaluate the remaining components from white's perspective
+    score += evaluate_pawn_structure(position);
+    score += evaluate_king_safety(position);
+    score += mobility;
+    score += evaluate_piece_bonuses(position);
     
-    while (white_pawns_copy.count_bits() > 0) {
-        Square pawn_sq = static_cast<Square>(white_pawns_copy.pop_lsb());
-        File pawn_file = file_of(pawn_sq);
-        
-        // Doubled pawns penalty
-        Bitboard file_pawns = white_pawns & Bitboard(pawn_file);
-        if (file_pawns.count_bits() > 1) white_score -= DOUBLED_PAWN_PENALTY;
-        
-        // Isolated pawns penalty
-        bool has_neighbor = false;
-        if (static_cast<int>(pawn_file) > 0) 
-        {
-            File left_file = static_cast<File>(static_cast<int>(pawn_file) - 1);
-            if ((white_pawns & Bitboard(left_file)).count_bits() > 0) 
-                has_neighbor = true;
-        }
-        if (static_cast<int>(pawn_file) < 7) 
-        {
-            File right_file = static_cast<File>(static_cast<int>(pawn_file) + 1);
-            if ((white_pawns & Bitboard(right_file)).count_bits() > 0)
-                has_neighbor = true;
-        }
-        if (!has_neighbor)
-            white_score -= ISOLATED_PAWN_PENALTY;
-        
-        // Passed pawns bonus
-        Rank pawn_rank = rank_of(pawn_sq);
-        bool is_passed = true;
-        for (int r = static_cast<int>(pawn_rank) + 1; r < 8; r++) 
-        {
-            Square check_sq = make_square(pawn_file, static_cast<Rank>(r));
-            if (pos.piece_on(check_sq) != Piece::None && 
-                type_of(pos.piece_on(check_sq)) == PieceType::Pawn &&
-                color_of(pos.piece_on(check_sq)) == Color::Black) 
-                {
-                    is_passed = false;
-                    break;
-                }
-        }
-        if (is_passed) 
-            white_score += PASSED_PAWN_BONUS * static_cast<int>(pawn_rank);
+    // IMPORTANT: Return score from side to move's perspective for negamax
+    return position.side_to_move() == Color::White ? score : -score;
+}
+
+template <typename Board>
+int Evaluator::evaluate_pawn_structure(const Board& pos) 
+{
+    // Pawn terms depend on the pawns alone, so reuse them while the pawn
+    // structure is unchanged
+    PawnEntry* entry = pawn_table_.probe(pos.pawn_key());
+    if (entry->key != pos.pawn_key())
+    {
+        compute_pawn_structure(pos, *entry);
+        entry->key = pos.pawn_key();
     }
     
-    // Evaluate black pawns
-    Bitboard black_pawns = pos.pieces(Color::Black, PieceType::Pawn);
-    Bitboard black_pawns_copy = black_pawns;
+    return entry->score;
+}
+
+template <typename Board>
+void Evaluator::compute_pawn_structure(const Board& pos, PawnEntry& entry) 
+{
+    int scores[2] = { 0, 0 };
     
-    while (black_pawns_copy.count_bits() > 0) 
+    for (Color us : { Color::White, Color::Black }) 
     {
-        Square pawn_sq = static_cast<Square>(black_pawns_copy.pop_lsb());
-        File pawn_file = file_of(pawn_sq);
-        
-        // Doubled pawns penalty
-        Bitboard file_pawns = black_pawns & Bitboard(pawn_file);
-        if (file_pawns.count_bits() > 1) black_score -= DOUBLED_PAWN_PENALTY;
+        Color them = (us == Color::White) ? Color::Black : Color::White;
+        Bitboard our_pawns = pos.pieces(us, PieceType::Pawn);
+        Bitboard their_pawns = pos.pieces(them, PieceType::Pawn);
+        Bitboard passed;
+        int& score = scores[static_cast<int>(us)];
         
-        // Isolated pawns penalty
-        bool has_neighbor = false;
-        if (static_cast<int>(pawn_file) > 0) 
+        Bitboard pawns = our_pawns;
+        while (pawns.any()) 
         {
-            File left_file = static_cast<File>(static_cast<int>(pawn_file) - 1);
-            if ((black_pawns & Bitboard(left_file)).count_bits() > 0) 
-                has_neighbor = true;    
+            Square pawn_sq = static_cast<Square>(pawns.pop_lsb());
+            File pawn_file = file_of(pawn_sq);
+            
+            // Doubled pawns penalty (each pawn sharing its file)
+            if ((our_pawns & Bitboard(pawn_file)).count_bits() > 1) 
+                score -= DOUBLED_PAWN_PENALTY;
+            
+            // Isolated pawns penalty
+            if ((our_pawns & Bitboard::adjacent_files(pawn_file)).empty()) 
+                score -= ISOLATED_PAWN_PENALTY;
+            
+            // Passed pawns bonus: no enemy pawn ahead on this or an adjacent
+            // file. Grows as the pawn nears promotion.
+            if ((their_pawns & Bitboard::passed_pawn_span(us, pawn_sq)).empty()) 
+            {
+                int rank = static_cast<int>(rank_of(pawn_sq));
+                score += PASSED_PAWN_BONUS * (us == Color::White ? rank : 7 - rank);
+                passed.set_bit(pawn_sq);
+            }
         }
-        if (static_cast<int>(pawn_file) < 7) 
-        {
-            File right_file = static_cast<File>(static_cast<int>(pawn_file) + 1);
-            if ((black_pawns & Bitboard(right_file)).count_bits() > 0)
-                has_neighbor = true;
-        }
-        if (!has_neighbor)
-            black_score -= ISOLATED_PAWN_PENALTY;
         
-        // Passed pawns bonus (for black, check ranks below current position)
-        Rank pawn_rank = rank_of(pawn_sq);
-        bool is_passed = true;
-        for (int r = static_cast<int>(pawn_rank) - 1; r >= 0; r--) 
-        {
-            Square check_sq = make_square(pawn_file, static_cast<Rank>(r));
-            if (pos.piece_on(check_sq) != Piece::None && 
-                type_of(pos.piece_on(check_sq)) == PieceType::Pawn &&
-                color_of(pos.piece_on(check_sq)) == Color::White) 
-                {
-                    is_passed = false;
-                    break;
-                }
-        }
-        if (is_passed) 
-        {
-            // For black pawns, bonus increases as they get closer to rank 1 (promotion)
-            black_score += PASSED_PAWN_BONUS * (7 - static_cast<int>(pawn_rank));
-        }
+        entry.passed_pawns[static_cast<int>(us)] = passed;
     }
     
-    return white_score - black_score;
+    entry.score = scores[static_cast<int>(Color::White)] - scores[static_cast<int>(Color::Black)];
 }
 
-int Evaluator::evaluate_king_safety(const Position& pos) 
+template <typename Board>
+int Evaluator::evaluate_king_safety(const Board& pos) 
 {
     // Initialize scores
     int white_score = 0;
@@ -382,13 +219,13 @@ int Evaluator::evaluate_mobility(const Position& pos)
     Bitboard white_knights = pos.pieces(Color::White, PieceType::Knight);
     Bitboard black_knights = pos.pieces(Color::Black, PieceType::Knight);
     
-    while (white_knights.count_bits() > 0) 
+    while (white_knights.any()) 
     {
         Square sq = static_cast<Square>(white_knights.pop_lsb());
         white_mobility += count_knight_moves(pos, sq);
     }
     
-    while (black_knights.count_bits() > 0) 
+    while (black_knights.any()) 
     {
         Square sq = static_cast<Square>(black_knights.pop_lsb());
         black_mobility += count_knight_moves(pos, sq);
@@ -398,13 +235,13 @@ int Evaluator::evaluate_mobility(const Position& pos)
     Bitboard white_bishops = pos.pieces(Color::White, PieceType::Bishop);
     Bitboard black_bishops = pos.pieces(Color::Black, PieceType::Bishop);
     
-    while (white_bishops.count_bits() > 0) 
+    while (white_bishops.any()) 
     {
         Square sq = static_cast<Square>(white_bishops.pop_lsb());
         white_mobility += count_bishop_moves(pos, sq);
     }
     
-    while (black_bishops.count_bits() > 0) 
+    while (black_bishops.any()) 
     {
         Square sq = static_cast<Square>(black_bishops.pop_lsb());
         black_mobility += count_bishop_moves(pos, sq);
@@ -414,13 +251,13 @@ int Evaluator::evaluate_mobility(const Position& pos)
     Bitboard white_rooks = pos.pieces(Color::White, PieceType::Rook);
     Bitboard black_rooks = pos.pieces(Color::Black, PieceType::Rook);
     
-    while (white_rooks.count_bits() > 0) 
+    while (white_rooks.any()) 
     {
         Square sq = static_cast<Square>(white_rooks.pop_lsb());
         white_mobility += count_rook_moves(pos, sq);
     }
     
-    while (black_rooks.count_bits() > 0) 
+    while (black_rooks.any()) 
     {
         Square sq = static_cast<Square>(black_rooks.pop_lsb());
         black_mobility += count_rook_moves(pos, sq);
@@ -444,7 +281,8 @@ int Evaluator::evaluate_mobility(const Position& pos)
     return mobility_score;
 }
 
-int Evaluator::evaluate_piece_bonuses(const Position& pos)
+template <typename Board>
+int Evaluator::evaluate_piece_bonuses(const Board& pos)
 {
     int white_score = 0;
     int black_score = 0;
@@ -457,7 +295,7 @@ int Evaluator::evaluate_piece_bonuses(const Position& pos)
 
     // Rook on seventh rank bonus
     Bitboard white_rooks = pos.pieces(Color::White, PieceType::Rook);
-    while (white_rooks.count_bits() > 0)
+    while (white_rooks.any())
     {
         Square rook_sq = static_cast<Square>(white_rooks.pop_lsb());
         if (rank_of(rook_sq) == Rank::Seven)
@@ -465,7 +303,7 @@ int Evaluator::evaluate_piece_bonuses(const Position& pos)
     }
 
     Bitboard black_rooks = pos.pieces(Color::Black, PieceType::Rook);
-    while (black_rooks.count_bits() > 0)
+    while (black_rooks.any())
     {
         Square rook_sq = static_cast<Square>(black_rooks.pop_lsb());
         if (rank_of(rook_sq) == Rank::Two)
@@ -474,24 +312,24 @@ int Evaluator::evaluate_piece_bonuses(const Position& pos)
 
     // Rook on open file bonus
     white_rooks = pos.pieces(Color::White, PieceType::Rook);
-    while (white_rooks.count_bits() > 0)
+    while (white_rooks.any())
     {
         Square rook_sq = static_cast<Square>(white_rooks.pop_lsb());
         File rook_file = file_of(rook_sq);
-        if ((pos.pieces(Color::White, PieceType::Pawn) & Bitboard(rook_file)).count_bits() == 0 &&
-            (pos.pieces(Color::Black, PieceType::Pawn) & Bitboard(rook_file)).count_bits() == 0)
+        if ((pos.pieces(Color::White, PieceType::Pawn) & Bitboard(rook_file)).empty() &&
+            (pos.pieces(Color::Black, PieceType::Pawn) & Bitboard(rook_file)).empty())
         {
             white_score += ROOK_ON_OPEN_FILE_BONUS;
         }
     }
 
     black_rooks = pos.pieces(Color::Black, PieceType::Rook);
-    while (black_rooks.count_bits() > 0)
+    while (black_rooks.any())
     {
         Square rook_sq = static_cast<Square>(black_rooks.pop_lsb());
         File rook_file = file_of(rook_sq);
-        if ((pos.pieces(Color::White, PieceType::Pawn) & Bitboard(rook_file)).count_bits() == 0 &&
-            (pos.pieces(Color::Black, PieceType::Pawn) & Bitboard(rook_file)).count_bits() == 0)
+        if ((pos.pieces(Color::White, PieceType::Pawn) & Bitboard(rook_file)).empty() &&
+            (pos.pieces(Color::Black, PieceType::Pawn) & Bitboard(rook_file)).empty())
         {
             black_score += ROOK_ON_OPEN_FILE_BONUS;
         }
@@ -500,7 +338,8 @@ int Evaluator::evaluate_piece_bonuses(const Position& pos)
     return white_score - black_score;
 }
 
-bool Evaluator::is_only_kings(const Position& pos) 
+template <typename Board>
+bool Evaluator::is_only_kings(const Board& pos) 
 {
     // Check if there are only two kings on the board
     for (int c = 0; c < static_cast<int>(Color::NB); ++c) 
@@ -508,7 +347,7 @@ bool Evaluator::is_only_kings(const Position& pos)
         for (int pt = 0; pt < static_cast<int>(PieceType::NB); ++pt) 
         {
             if (pt != static_cast<int>(PieceType::King) && 
-                pos.pieces(static_cast<Color>(c), static_cast<PieceType>(pt)).count_bits() > 0) 
+                pos.pieces(static_cast<Color>(c), static_cast<PieceType>(pt)).any()) 
                 {
                     return false;
                 }
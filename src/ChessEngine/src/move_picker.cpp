@@ -0,0 +1,251 @@
+/*
+    Implementation of the staged move picker.
+
+    Author: Nicolas Miller
+    Date: 08/14/2025
+*/
+
+#include "ChessEngine/include/move_picker.h"
+#include "ChessEngine/include/constants.h"
+#include "movegen.h"
+
+#include <utility>
+
+namespace luna {
+
+MovePicker::MovePicker(const Position& pos, const Move& tt_move, const Move* killers, const Move& countermove,
+                       const ButterflyHistory* history, const PieceToHistory* continuation)
+    : pos_(pos), stage_(Stage::TTMove), captures_only_(false), tt_move_(tt_move),
+      countermove_(countermove), returned_count_(0), history_(history), continuation_(continuation),
+      current_(0), bad_current_(0)
+    {
+        killers_[0] = killers[0];
+        killers_[1] = killers[1];
+    }
+
+MovePicker::MovePicker(const Position& pos)
+    : pos_(pos), stage_(Stage::GenerateCaptures), captures_only_(true), returned_count_(0),
+      history_(nullptr), continuation_(nullptr), current_(0), bad_current_(0)
+    {
+    }
+
+Move MovePicker::next_move()
+{
+    while (true)
+    {
+        switch (stage_)
+        {
+            case Stage::TTMove:
+                stage_ = pos_.is_in_check() ? Stage::GenerateEvasions : Stage::GenerateCaptures;
+                if (MoveGenerator::is_pseudo_legal(pos_, tt_move_) && MoveGenerator::is_legal(pos_, tt_move_))
+                {
+                    return tt_move_;
+                }
+
+                // Not playable here, so nothing needs skipping later
+                tt_move_ = Move();
+                break;
+
+            case Stage::GenerateCaptures:
+                moves_.clear();
+                MoveGenerator::generate<GenType::Captures>(pos_, moves_);
+                score_captures();
+                current_ = 0;
+                stage_ = Stage::GoodCaptures;
+                break;
+
+            case Stage::GoodCaptures:
+                while (current_ < moves_.size())
+                {
+                    Move move = select_best();
+                    if (move == tt_move_) continue;
+
+                    // Losing captures wait until after the quiets (or are
+                    // dropped in quiescence)
+                    if (!MoveGenerator::see_ge(pos_, move, 0))
+                    {
+                        if (!captures_only_) bad_captures_.push_back(move);
+                        continue;
+                    }
+                    return move;
+                }
+                stage_ = captures_only_ ? Stage::Done : Stage::Killer1;
+                break;
+
+            case Stage::Killer1:
+            case Stage::Killer2:
+            case Stage::Countermove:
+            {
+                Move move = (stage_ == Stage::Killer1) ? killers_[0] :
+                            (stage_ == Stage::Killer2) ? killers_[1] : countermove_;
+                stage_ = static_cast<Stage>(static_cast<int>(stage_) + 1);
+                if (is_refutation(move))
+                {
+                    returned_[returned_count_++] = move;
+                    return move;
+                }
+                break;
+            }
+
+            case Stage::GenerateQuiets:
+                moves_.clear();
+                MoveGenerator::generate<GenType::Quiets>(pos_, moves_);
+                score_quiets();
+
+                // Insertion sort by score (descending)
+                for (size_t i = 1; i < moves_.size(); i++)
+                {
+                    Move move = moves_[i];
+                    int score = scores_[i];
+                    size_t j = i;
+
+                    while (j > 0 && scores_[j - 1] < score)
+                    {
+                        moves_[j] = moves_[j - 1];
+                        scores_[j] = scores_[j - 1];
+                        j--;
+                    }
+
+                    moves_[j] = move;
+                    scores_[j] = score;
+                }
+
+                current_ = 0;
+                stage_ = Stage::Quiets;
+                break;
+
+            case Stage::Quiets:
+                while (current_ < moves_.size())
+                {
+                    Move move = moves_[current_++];
+                    if (!already_returned(move)) return move;
+                }
+                stage_ = Stage::BadCaptures;
+                break;
+
+            case Stage::BadCaptures:
+                if (bad_current_ < bad_captures_.size()) return bad_captures_[bad_current_++];
+                stage_ = Stage::Done;
+                break;
+
+            case Stage::GenerateEvasions:
+                moves_.clear();
+                MoveGenerator::generate<GenType::Evasions>(pos_, moves_);
+                score_evasions();
+                current_ = 0;
+                stage_ = Stage::Evasions;
+                break;
+
+            case Stage::Evasions:
+                while (current_ < moves_.size())
+                {
+                    Move move = select_best();
+                    if (move != tt_move_) return move;
+                }
+                stage_ = Stage::Done;
+                break;
+
+            case Stage::Done:
+                return Move();
+        }
+    }
+}
+
+void MovePicker::score_captures()
+{
+    for (size_t i = 0; i < moves_.size(); i++)
+    {
+        scores_[i] = capture_score(moves_[i]);
+    }
+}
+
+void MovePicker::score_quiets()
+{
+    for (size_t i = 0; i < moves_.size(); i++)
+    {
+        scores_[i] = quiet_score(moves_[i]);
+    }
+}
+
+void MovePicker::score_evasions()
+{
+    for (size_t i = 0; i < moves_.size(); i++)
+    {
+        const Move& move = moves_[i];
+        bool quiet = move.move_type() == MoveType::Normal || move.move_type() == MoveType::Castle;
+        if (quiet)
+        {
+            scores_[i] = quiet_score(move);
+        }
+        else if (!MoveGenerator::see_ge(pos_, move, 0))
+        {
+            // Losing captures rank with the poorer quiet evasions
+            scores_[i] = LOSING_CAPTURE_SCORE;
+        }
+        else
+        {
+            scores_[i] = capture_score(move);
+        }
+    }
+}
+
+// Captures by MVV-LVA, promotions by the value of the new piece
+int MovePicker::capture_score(const Move& move) const
+{
+    if (move.move_type() == MoveType::Promotion)
+    {
+        return PROMOTION_SCORE + PIECE_VALUES[static_cast<int>(type_of(move.promotion_piece()))];
+    }
+
+    // En passant always captures a pawn
+    PieceType victim = (move.move_type() == MoveType::EnPassant) ? PieceType::Pawn : type_of(pos_.piece_on(move.to_square()));
+    PieceType attacker = type_of(pos_.piece_on(move.from_square()));
+    return WINNING_CAPTURE_SCORE + MVV_LVA_OFFSET[static_cast<int>(attacker)][static_cast<int>(victim)];
+}
+
+// Quiet moves by butterfly and continuation history, averaged
+int MovePicker::quiet_score(const Move& move) const
+{
+    if (!history_) return 0;
+
+    int to = static_cast<int>(move.to_square());
+    int score = (*history_)[static_cast<int>(move.from_square())][to];
+    if (continuation_)
+    {
+        score += (*continuation_)[static_cast<int>(pos_.piece_on(move.from_square()))][to];
+    }
+    return score / 2;
+}
+
+Move MovePicker::select_best()
+{
+    size_t best = current_;
+    for (size_t i = current_ + 1; i < moves_.size(); i++)
+    {
+        if (scores_[i] > scores_[best]) best = i;
+    }
+
+    std::swap(moves_[current_], moves_[best]);
+    std::swap(scores_[current_], scores_[best]);
+    return moves_[current_++];
+}
+
+bool MovePicker::is_refutation(const Move& move) const
+{
+    // Killers and countermoves are quiet, so a capture here is a different move
+    return move.move_type() == MoveType::Normal && move != tt_move_ && !already_returned(move) &&
+           MoveGenerator::is_pseudo_legal(pos_, move) && MoveGenerator::is_legal(pos_, move);
+}
+
+bool MovePicker::already_returned(const Move& move) const
+{
+    if (move == tt_move_) return true;
+
+    for (int i = 0; i < returned_count_; i++)
+    {
+        if (returned_[i] == move) return true;
+    }
+    return false;
+}
+
+} // namespace luna
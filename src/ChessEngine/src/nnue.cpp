@@ -0,0 +1,443 @@
+/*
+    Implementation of the NNUE network: feature indexing, file loading and
+    the quantized layer kernels.
+
+    Author: Nicolas Miller
+    Date: 08/17/2025
+*/
+
+#include "nnue.h"
+#include "eval_batch.h"
+#include "position.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LUNA_NNUE_AVX2 1
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define LUNA_NNUE_SSE41 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LUNA_NNUE_NEON 1
+#endif
+
+namespace luna {
+
+namespace {
+
+// Network file header. The weights follow in the order of the members of
+// NnueNetwork, little-endian as written by the saving machine.
+struct NnueFileHeader
+{
+    char magic[8];              // "LUNANNUE"
+    uint32_t version;           // NNUE_VERSION
+    uint32_t byte_order;        // NNUE_FILE_BYTE_ORDER as written by the saving machine
+    uint32_t inputs;            // NNUE_INPUTS
+    uint32_t half_dims;         // NNUE_HALF_DIMS
+    uint32_t l1;                // NNUE_L1
+    uint32_t l2;                // NNUE_L2
+};
+
+constexpr char NNUE_FILE_MAGIC[8] = { 'L', 'U', 'N', 'A', 'N', 'N', 'U', 'E' };
+constexpr uint32_t NNUE_FILE_BYTE_ORDER = 0x01020304;
+
+bool header_matches_format(const NnueFileHeader& header)
+{
+    return std::memcmp(header.magic, NNUE_FILE_MAGIC, sizeof(NNUE_FILE_MAGIC)) == 0 &&
+           header.version == NNUE_VERSION &&
+           header.byte_order == NNUE_FILE_BYTE_ORDER &&
+           header.inputs == NNUE_INPUTS &&
+           header.half_dims == NNUE_HALF_DIMS &&
+           header.l1 == NNUE_L1 &&
+           header.l2 == NNUE_L2;
+}
+
+// Clamp a dense layer's int32 output back into the 0..127 activation range
+void activate(const int32_t* in, int n, uint8_t* out)
+{
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = static_cast<uint8_t>(std::clamp(in[i] >> NNUE_WEIGHT_SHIFT, 0, 127));
+    }
+}
+
+template <typename T>
+bool read_array(std::ifstream& file, T* data, size_t count)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(data),
+                                       static_cast<std::streamsize>(count * sizeof(T))));
+}
+
+template <typename T>
+void write_array(std::ofstream& file, const T* data, size_t count)
+{
+    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+} // namespace
+
+int nnue_feature_index(Color perspective, Square king_sq, Piece piece, Square square)
+{
+    PieceType type = type_of(piece);
+    if (type == PieceType::King) return -1;
+
+    // Black sees the board flipped, so both sides share one set of weights
+    int flip = (perspective == Color::White) ? 0 : 56;
+    int king = static_cast<int>(king_sq) ^ flip;
+    int sq = static_cast<int>(square) ^ flip;
+
+    // Own pieces first (0-4), then the opponent's (5-9)
+    int piece_index = static_cast<int>(type) + (color_of(piece) == perspective ? 0 : 5);
+    return king * NNUE_PIECE_FEATURES + piece_index * 64 + sq;
+}
+
+NnueNetwork::NnueNetwork()
+    : feature_weights_(new int16_t[static_cast<size_t>(NNUE_INPUTS) * NNUE_HALF_DIMS]()),
+      feature_biases_(), l1_weights_(), l1_biases_(), l2_weights_(), l2_biases_(),
+      output_weights_(), output_bias_(0)
+{
+}
+
+bool NnueNetwork::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    NnueFileHeader header = {};
+    if (!read_array(file, &header, 1) || !header_matches_format(header)) return false;
+
+    // Read into a fresh network so a truncated file leaves this one intact
+    std::unique_ptr<NnueNetwork> loaded(new NnueNetwork());
+    bool ok = read_array(file, loaded->feature_biases_, NNUE_HALF_DIMS) &&
+              read_array(file, loaded->feature_weights_.get(), static_cast<size_t>(NNUE_INPUTS) * NNUE_HALF_DIMS) &&
+              read_array(file, &loaded->l1_weights_[0][0], NNUE_L1 * 2 * NNUE_HALF_DIMS) &&
+              read_array(file, loaded->l1_biases_, NNUE_L1) &&
+              read_array(file, &loaded->l2_weights_[0][0], NNUE_L2 * NNUE_L1) &&
+              read_array(file, loaded->l2_biases_, NNUE_L2) &&
+              read_array(file, loaded->output_weights_, NNUE_L2) &&
+              read_array(file, &loaded->output_bias_, 1);
+
+    // Anything left over means the file was written for another layout
+    if (!ok || file.peek() != std::ifstream::traits_type::eof()) return false;
+
+    *this = std::move(*loaded);
+    return true;
+}
+
+bool NnueNetwork::save(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    NnueFileHeader header = {};
+    std::memcpy(header.magic, NNUE_FILE_MAGIC, sizeof(NNUE_FILE_MAGIC));
+    header.version = NNUE_VERSION;
+    header.byte_order = NNUE_FILE_BYTE_ORDER;
+    header.inputs = NNUE_INPUTS;
+    header.half_dims = NNUE_HALF_DIMS;
+    header.l1 = NNUE_L1;
+    header.l2 = NNUE_L2;
+
+    write_array(file, &header, 1);
+    write_array(file, feature_biases_, NNUE_HALF_DIMS);
+    write_array(file, feature_weights_.get(), static_cast<size_t>(NNUE_INPUTS) * NNUE_HALF_DIMS);
+    write_array(file, &l1_weights_[0][0], NNUE_L1 * 2 * NNUE_HALF_DIMS);
+    write_array(file, l1_biases_, NNUE_L1);
+    write_array(file, &l2_weights_[0][0], NNUE_L2 * NNUE_L1);
+    write_array(file, l2_biases_, NNUE_L2);
+    write_array(file, output_weights_, NNUE_L2);
+    write_array(file, &output_bias_, 1);
+    return static_cast<bool>(file);
+}
+
+void NnueNetwork::randomize(uint64_t seed)
+{
+    // xorshift64; values in [-range, range]
+    auto next = [&seed](int range)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return static_cast<int>(seed % static_cast<uint64_t>(2 * range + 1)) - range;
+    };
+
+    for (size_t i = 0; i < static_cast<size_t>(NNUE_INPUTS) * NNUE_HALF_DIMS; i++)
+    {
+        feature_weights_[i] = static_cast<int16_t>(next(16));
+    }
+    for (int i = 0; i < NNUE_HALF_DIMS; i++) feature_biases_[i] = static_cast<int16_t>(next(64));
+    for (int o = 0; o < NNUE_L1; o++)
+    {
+        for (int i = 0; i < 2 * NNUE_HALF_DIMS; i++) l1_weights_[o][i] = static_cast<int8_t>(next(32));
+        l1_biases_[o] = next(4096);
+    }
+    for (int o = 0; o < NNUE_L2; o++)
+    {
+        for (int i = 0; i < NNUE_L1; i++) l2_weights_[o][i] = static_cast<int8_t>(next(64));
+        l2_biases_[o] = next(4096);
+    }
+    for (int i = 0; i < NNUE_L2; i++) output_weights_[i] = static_cast<int8_t>(next(64));
+    output_bias_ = 0;
+}
+
+void NnueNetwork::refresh(const Position& pos, Color perspective, int16_t* acc) const
+{
+    refresh_board(pos, perspective, acc);
+}
+
+void NnueNetwork::refresh(const BoardSnapshot& board, Color perspective, int16_t* acc) const
+{
+    refresh_board(board, perspective, acc);
+}
+
+template <typename Board>
+void NnueNetwork::refresh_board(const Board& board, Color perspective, int16_t* acc) const
+{
+    std::memcpy(acc, feature_biases_, sizeof(feature_biases_));
+
+    Square king_sq = board.king_square(perspective);
+    Bitboard pieces = board.occupied();
+    while (pieces.any())
+    {
+        Square sq = static_cast<Square>(pieces.pop_lsb());
+        int feature = nnue_feature_index(perspective, king_sq, board.piece_on(sq), sq);
+        if (feature >= 0) add_feature(acc, feature);
+    }
+}
+
+void NnueNetwork::add_feature(int16_t* acc, int feature) const
+{
+    const int16_t* weights = feature_weights_.get() + static_cast<size_t>(feature) * NNUE_HALF_DIMS;
+#if defined(LUNA_NNUE_AVX2)
+    for (int i = 0; i < NNUE_HALF_DIMS; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi16(a, w));
+    }
+#elif defined(LUNA_NNUE_SSE41)
+    for (int i = 0; i < NNUE_HALF_DIMS; i += 8)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_add_epi16(a, w));
+    }
+#elif defined(LUNA_NNUE_NEON)
+    for (int i = 0; i < NNUE_HALF_DIMS; i += 8)
+    {
+        vst1q_s16(acc + i, vaddq_s16(vld1q_s16(acc + i), vld1q_s16(weights + i)));
+    }
+#else
+    for (int i = 0; i < NNUE_HALF_DIMS; i++) acc[i] = static_cast<int16_t>(acc[i] + weights[i]);
+#endif
+}
+
+void NnueNetwork::remove_feature(int16_t* acc, int feature) const
+{
+    const int16_t* weights = feature_weights_.get() + static_cast<size_t>(feature) * NNUE_HALF_DIMS;
+#if defined(LUNA_NNUE_AVX2)
+    for (int i = 0; i < NNUE_HALF_DIMS; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_sub_epi16(a, w));
+    }
+#elif defined(LUNA_NNUE_SSE41)
+    for (int i = 0; i < NNUE_HALF_DIMS; i += 8)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_sub_epi16(a, w));
+    }
+#elif defined(LUNA_NNUE_NEON)
+    for (int i = 0; i < NNUE_HALF_DIMS; i += 8)
+    {
+        vst1q_s16(acc + i, vsubq_s16(vld1q_s16(acc + i), vld1q_s16(weights + i)));
+    }
+#else
+    for (int i = 0; i < NNUE_HALF_DIMS; i++) acc[i] = static_cast<int16_t>(acc[i] - weights[i]);
+#endif
+}
+
+int NnueNetwork::propagate(const NnueAccumulator& acc, Color side_to_move) const
+{
+    alignas(64) uint8_t transformed[2 * NNUE_HALF_DIMS];
+    alignas(64) int32_t l1_out[NNUE_L1];
+    alignas(64) uint8_t l1_act[NNUE_L1];
+    alignas(64) int32_t l2_out[NNUE_L2];
+    alignas(64) uint8_t l2_act[NNUE_L2];
+    int32_t output = 0;
+
+    // Side to move's half first
+    int us = static_cast<int>(side_to_move);
+    nnue_kernels::clipped_relu(acc.values[us], NNUE_HALF_DIMS, transformed);
+    nnue_kernels::clipped_relu(acc.values[us ^ 1], NNUE_HALF_DIMS, transformed + NNUE_HALF_DIMS);
+
+    nnue_kernels::dense(transformed, 2 * NNUE_HALF_DIMS, &l1_weights_[0][0], l1_biases_, NNUE_L1, l1_out);
+    activate(l1_out, NNUE_L1, l1_act);
+
+    nnue_kernels::dense(l1_act, NNUE_L1, &l2_weights_[0][0], l2_biases_, NNUE_L2, l2_out);
+    activate(l2_out, NNUE_L2, l2_act);
+
+    nnue_kernels::dense(l2_act, NNUE_L2, output_weights_, &output_bias_, 1, &output);
+    return output / NNUE_OUTPUT_SCALE;
+}
+
+namespace nnue_kernels {
+
+void dense_scalar(const uint8_t* in, int n_in, const int8_t* weights, const int32_t* biases,
+                  int n_out, int32_t* out)
+{
+    for (int o = 0; o < n_out; o++)
+    {
+        const int8_t* row = weights + static_cast<size_t>(o) * n_in;
+        int32_t sum = biases[o];
+        for (int i = 0; i < n_in; i++) sum += in[i] * row[i];
+        out[o] = sum;
+    }
+}
+
+void clipped_relu_scalar(const int16_t* in, int n, uint8_t* out)
+{
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = static_cast<uint8_t>(std::clamp<int>(in[i], 0, 127));
+    }
+}
+
+#if defined(LUNA_NNUE_AVX2)
+
+// Inputs are at most 127, so the pairwise u8 x s8 products summed by
+// maddubs stay within int16
+void dense(const uint8_t* in, int n_in, const int8_t* weights, const int32_t* biases,
+           int n_out, int32_t* out)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int o = 0; o < n_out; o++)
+    {
+        const int8_t* row = weights + static_cast<size_t>(o) * n_in;
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < n_in; i += 32)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+            __m256i product = _mm256_maddubs_epi16(x, w);
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(product, ones));
+        }
+
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+        out[o] = biases[o] + _mm_cvtsi128_si32(half);
+    }
+}
+
+void clipped_relu(const int16_t* in, int n, uint8_t* out)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 16));
+
+        // Saturate to -128..127, drop negatives, then undo packs' lane interleave
+        __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(a, b), zero);
+        packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+}
+
+const char* instruction_set() { return "AVX2"; }
+
+#elif defined(LUNA_NNUE_SSE41)
+
+void dense(const uint8_t* in, int n_in, const int8_t* weights, const int32_t* biases,
+           int n_out, int32_t* out)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+    for (int o = 0; o < n_out; o++)
+    {
+        const int8_t* row = weights + static_cast<size_t>(o) * n_in;
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < n_in; i += 16)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(x, w), ones));
+        }
+
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        out[o] = biases[o] + _mm_cvtsi128_si32(sum);
+    }
+}
+
+void clipped_relu(const int16_t* in, int n, uint8_t* out)
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < n; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_max_epi8(_mm_packs_epi16(a, b), zero));
+    }
+}
+
+const char* instruction_set() { return "SSE4.1"; }
+
+#elif defined(LUNA_NNUE_NEON)
+
+// Inputs are at most 127, so they can be treated as signed bytes
+void dense(const uint8_t* in, int n_in, const int8_t* weights, const int32_t* biases,
+           int n_out, int32_t* out)
+{
+    for (int o = 0; o < n_out; o++)
+    {
+        const int8_t* row = weights + static_cast<size_t>(o) * n_in;
+        int32x4_t sum = vdupq_n_s32(0);
+        for (int i = 0; i < n_in; i += 16)
+        {
+            int8x16_t x = vreinterpretq_s8_u8(vld1q_u8(in + i));
+            int8x16_t w = vld1q_s8(row + i);
+            sum = vpadalq_s16(sum, vmull_s8(vget_low_s8(x), vget_low_s8(w)));
+            sum = vpadalq_s16(sum, vmull_s8(vget_high_s8(x), vget_high_s8(w)));
+        }
+        out[o] = biases[o] + vaddvq_s32(sum);
+    }
+}
+
+void clipped_relu(const int16_t* in, int n, uint8_t* out)
+{
+    const int8x16_t zero = vdupq_n_s8(0);
+    for (int i = 0; i < n; i += 16)
+    {
+        int8x16_t packed = vcombine_s8(vqmovn_s16(vld1q_s16(in + i)), vqmovn_s16(vld1q_s16(in + i + 8)));
+        vst1q_u8(out + i, vreinterpretq_u8_s8(vmaxq_s8(packed, zero)));
+    }
+}
+
+const char* instruction_set() { return "NEON"; }
+
+#else
+
+void dense(const uint8_t* in, int n_in, const int8_t* weights, const int32_t* biases,
+           int n_out, int32_t* out)
+{
+    dense_scalar(in, n_in, weights, biases, n_out, out);
+}
+
+void clipped_relu(const int16_t* in, int n, uint8_t* out)
+{
+    clipped_relu_scalar(in, n, out);
+}
+
+const char* instruction_set() { return "scalar"; }
+
+#endif
+
+} // namespace nnue_kernels
+
+} // namespace luna
@@ -0,0 +1,128 @@
+/*
+    Implementation of the incrementally updated NNUE accumulators.
+
+    Author: Nicolas Miller
+    Date: 08/17/2025
+*/
+
+#include "nnue_evaluator.h"
+#include "constants.h"
+#include "eval_batch.h"
+#include <algorithm>
+#include <cstring>
+
+namespace luna {
+
+namespace {
+
+// Beyond this many moves, rebuilding costs about as much as replaying
+constexpr size_t NNUE_MAX_REPLAY_PLIES = 8;
+
+}
+
+NnueEvaluator::NnueEvaluator(const NnueNetwork* network)
+    : network_(network), stack_(new StackEntry[MAX_GAME_PLY + 1])
+{
+}
+
+int NnueEvaluator::evaluate(const Position& pos)
+{
+    StackEntry& entry = stack_[pos.move_count()];
+    if (!entry.valid || entry.key != pos.hash_key())
+    {
+        update(pos, entry);
+    }
+
+    // Keep network output out of the mate score range
+    int score = network_->propagate(entry.acc, pos.side_to_move());
+    return std::clamp(score, -MATE_BOUND + 1, MATE_BOUND - 1);
+}
+
+int NnueEvaluator::evaluate(const BoardSnapshot& board)
+{
+    NnueAccumulator acc;
+    network_->refresh(board, Color::White, acc.values[static_cast<int>(Color::White)]);
+    network_->refresh(board, Color::Black, acc.values[static_cast<int>(Color::Black)]);
+
+    int score = network_->propagate(acc, board.side_to_move());
+    return std::clamp(score, -MATE_BOUND + 1, MATE_BOUND - 1);
+}
+
+void NnueEvaluator::reset()
+{
+    for (int i = 0; i <= MAX_GAME_PLY; i++)
+    {
+        stack_[i].valid = false;
+    }
+}
+
+void NnueEvaluator::update(const Position& pos, StackEntry& entry)
+{
+    size_t ply = pos.move_count();
+
+    // Nearest ancestor whose accumulator is still for the position on the
+    // undo stack at that ply
+    size_t limit = ply > NNUE_MAX_REPLAY_PLIES ? ply - NNUE_MAX_REPLAY_PLIES : 0;
+    const StackEntry* ancestor = nullptr;
+    size_t from_ply = ply;
+    while (from_ply > limit)
+    {
+        from_ply--;
+        const StackEntry& candidate = stack_[from_ply];
+        if (candidate.valid && candidate.key == pos.state(from_ply).hash_key)
+        {
+            ancestor = &candidate;
+            break;
+        }
+    }
+
+    for (Color perspective : { Color::White, Color::Black })
+    {
+        int side = static_cast<int>(perspective);
+        int16_t* acc = entry.acc.values[side];
+        Piece king = make_piece(perspective, PieceType::King);
+
+        // Moves from the ancestor, unless one of them moved this side's king
+        bool replay = ancestor != nullptr;
+        for (size_t i = from_ply; replay && i < ply; i++)
+        {
+            const StateInfo& st = pos.state(i);
+            for (int d = 0; d < st.dirty_count; d++)
+            {
+                if (st.dirty[d].piece == king) replay = false;
+            }
+        }
+
+        if (!replay)
+        {
+            network_->refresh(pos, perspective, acc);
+            continue;
+        }
+
+        std::memcpy(acc, ancestor->acc.values[side], sizeof(entry.acc.values[side]));
+        Square king_sq = pos.king_square(perspective);
+        for (size_t i = from_ply; i < ply; i++)
+        {
+            const StateInfo& st = pos.state(i);
+            for (int d = 0; d < st.dirty_count; d++)
+            {
+                const DirtyPiece& dp = st.dirty[d];
+                if (type_of(dp.piece) == PieceType::King) continue;
+
+                if (dp.from != Square::None)
+                {
+                    network_->remove_feature(acc, nnue_feature_index(perspective, king_sq, dp.piece, dp.from));
+                }
+                if (dp.to != Square::None)
+                {
+                    network_->add_feature(acc, nnue_feature_index(perspective, king_sq, dp.piece, dp.to));
+                }
+            }
+        }
+    }
+
+    entry.key = pos.hash_key();
+    entry.valid = true;
+}
+
+} // namespace luna
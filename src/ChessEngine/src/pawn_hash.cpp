@@ -0,0 +1,26 @@
+/*
+    Implementation of the pawn structure cache.
+
+    Author: Nicolas Miller
+    Date: 08/16/2025
+*/
+
+#include "pawn_hash.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace luna {
+
+PawnHashTable::PawnHashTable(size_t entries)
+    : table_(entries), mask_(entries - 1)
+{
+    assert(entries > 0 && (entries & (entries - 1)) == 0);
+}
+
+void PawnHashTable::clear()
+{
+    std::fill(table_.begin(), table_.end(), PawnEntry());
+}
+
+} // namespace luna
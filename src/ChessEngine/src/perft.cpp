@@ -0,0 +1,161 @@
+/*
+    Implementation of the perft move generation test.
+
+    Author: Nicolas Miller
+    Date: 06/11/2025
+*/
+
+#include "ChessEngine/include/perft.h"
+#include "movegen.h"
+#include "movelist.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <thread>
+
+namespace luna {
+
+Perft::Perft(size_t hash_mb)
+    : table_size_(0)
+{
+    if (hash_mb > 0)
+    {
+        table_size_ = (hash_mb * 1024 * 1024) / sizeof(Entry);
+        table_.reset(new Entry[table_size_]);
+    }
+}
+
+uint64_t Perft::count(Position& pos, int depth)
+{
+    if (depth <= 0) return 1;
+    return perft(pos, depth);
+}
+
+Perft::Result Perft::run(const Position& pos, int depth, int threads)
+{
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+
+    MoveList root_moves;
+    MoveGenerator::generate_legal_moves(pos, root_moves);
+
+    std::vector<uint64_t> counts(root_moves.size(), 0);
+
+    if (depth <= 1)
+    {
+        std::fill(counts.begin(), counts.end(), depth == 1 ? 1 : 0);
+    }
+    else
+    {
+        // Threads take root moves one at a time until none are left
+        std::atomic<size_t> next_move{0};
+        auto worker = [&]()
+        {
+            Position local = pos;
+            for (size_t i = next_move++; i < root_moves.size(); i = next_move++)
+            {
+                local.make_move(root_moves[i]);
+                counts[i] = perft(local, depth - 1);
+                local.undo_move();
+            }
+        };
+
+        int thread_count = std::max(1, std::min(threads, static_cast<int>(root_moves.size())));
+        std::vector<std::thread> helpers;
+        for (int t = 1; t < thread_count; t++)
+        {
+            helpers.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& helper : helpers)
+        {
+            helper.join();
+        }
+    }
+
+    for (size_t i = 0; i < root_moves.size(); i++)
+    {
+        result.divide.emplace_back(root_moves[i], counts[i]);
+        result.nodes += counts[i];
+    }
+
+    // Depth 0 is the root itself
+    if (depth <= 0) result.nodes = 1;
+
+    result.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    result.nps = result.nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(result.time_ms, 1));
+
+    return result;
+}
+
+void Perft::print_result(std::ostream& out, const Result& result)
+{
+    for (const auto& entry : result.divide)
+    {
+        out << entry.first.to_string() << ": " << entry.second << "\n";
+    }
+
+    out << "\nNodes searched: " << result.nodes << "\n";
+    out << "Time: " << result.time_ms << " ms\n";
+    out << "NPS: " << result.nps << std::endl;
+}
+
+// Recursive perft. At depth 1 the number of legal moves is the leaf count, so
+// the last ply is never made on the board.
+uint64_t Perft::perft(Position& pos, int depth)
+{
+    uint64_t nodes = 0;
+    if (depth > 1 && probe(pos.hash_key(), depth, nodes))
+    {
+        return nodes;
+    }
+
+    MoveList moves;
+    MoveGenerator::generate_legal_moves(pos, moves);
+
+    if (depth == 1)
+    {
+        return moves.size();
+    }
+
+    for (const Move& move : moves)
+    {
+        pos.make_move(move);
+        nodes += perft(pos, depth - 1);
+        pos.undo_move();
+    }
+
+    store(pos.hash_key(), depth, nodes);
+    return nodes;
+}
+
+bool Perft::probe(uint64_t key, int depth, uint64_t& nodes) const
+{
+    if (table_size_ == 0) return false;
+
+    const Entry& entry = table_[key % table_size_];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t check = entry.key_xor_data.load(std::memory_order_relaxed);
+
+    if ((check ^ data) != key || static_cast<int>(data & 0xFF) != depth)
+    {
+        return false;
+    }
+
+    nodes = data >> 8;
+    return true;
+}
+
+void Perft::store(uint64_t key, int depth, uint64_t nodes)
+{
+    if (table_size_ == 0) return;
+
+    Entry& entry = table_[key % table_size_];
+    uint64_t data = (nodes << 8) | static_cast<uint64_t>(depth & 0xFF);
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.key_xor_data.store(key ^ data, std::memory_order_relaxed);
+}
+
+} // namespace luna
@@ -0,0 +1,162 @@
+/*
+    Implementation of the combined material and piece-square tables.
+
+    Author: Nicolas Miller
+    Date: 08/15/2025
+*/
+
+#include "psqt.h"
+#include "constants.h"
+#include "position.h"
+
+namespace luna {
+
+// Piece-square tables (from white's perspective)
+// Positive values are good for the piece, negative are bad
+// Values are mirrored for black pieces.
+//
+// Note: These PSTs are taken from the chess programming wiki and are considered a 
+// starting point; there's a lot of opportunity here for fine tuning
+
+const int PieceSquareTable::pawn_table[64] = 
+{
+     0,  0,  0,  0,  0,  0,  0,  0,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    10, 10, 20, 30, 30, 20, 10, 10,
+     5,  5, 10, 25, 25, 10,  5,  5,
+     0,  0,  0, 20, 20,  0,  0,  0,
+     5, -5,-10,  0,  0,-10, -5,  5,
+     5, 10, 10,-20,-20, 10, 10,  5,
+     0,  0,  0,  0,  0,  0,  0,  0
+};
+
+const int PieceSquareTable::knight_table[64] = 
+{
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50
+};
+
+const int PieceSquareTable::bishop_table[64] = 
+{
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20
+};
+
+const int PieceSquareTable::rook_table[64] = 
+{
+     0,  0,  0,  0,  0,  0,  0,  0,
+     5, 10, 10, 10, 10, 10, 10,  5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+     0,  0,  0,  5,  5,  0,  0,  0
+};
+
+const int PieceSquareTable::queen_table[64] = 
+{
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20
+};
+
+const int PieceSquareTable::king_middlegame_table[64] = 
+{
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+     20, 20,  0,  0,  0,  0, 20, 20,
+     20, 30, 10,  0,  0, 10, 30, 20
+};
+
+const int PieceSquareTable::king_endgame_table[64] = 
+{
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50
+};
+
+Score PieceSquareTable::table_[12][64];
+int PieceSquareTable::phase_[12];
+bool PieceSquareTable::initialized_ = false;
+
+void PieceSquareTable::initialize() 
+{
+    if (initialized_) return;
+    
+    const int* middlegame[6] = { pawn_table, knight_table, bishop_table, rook_table, queen_table, king_middlegame_table };
+    const int* endgame[6]    = { pawn_table, knight_table, bishop_table, rook_table, queen_table, king_endgame_table };
+    const int phases[6]      = { 0, KNIGHT_PHASE, BISHOP_PHASE, ROOK_PHASE, QUEEN_PHASE, 0 };
+    
+    for (int pt = 0; pt < 6; pt++) 
+    {
+        // Kings are always on the board, so they carry no material
+        int material = (pt == static_cast<int>(PieceType::King)) ? 0 : PIECE_VALUES[pt];
+        
+        for (int sq = 0; sq < 64; sq++) 
+        {
+            // Black uses the tables mirrored vertically
+            int mirrored = (7 - sq / 8) * 8 + sq % 8;
+            
+            Piece white = make_piece(Color::White, static_cast<PieceType>(pt));
+            Piece black = make_piece(Color::Black, static_cast<PieceType>(pt));
+            table_[static_cast<int>(white)][sq] = { material + middlegame[pt][sq], material + endgame[pt][sq] };
+            table_[static_cast<int>(black)][sq] = { -material - middlegame[pt][mirrored], -material - endgame[pt][mirrored] };
+            
+            phase_[static_cast<int>(white)] = phases[pt];
+            phase_[static_cast<int>(black)] = phases[pt];
+        }
+    }
+    
+    initialized_ = true;
+}
+
+Score PieceSquareTable::compute_score(const Position& pos) 
+{
+    Score score;
+    for (int sq = 0; sq < 64; sq++) 
+    {
+        Piece piece = pos.piece_on(static_cast<Square>(sq));
+        if (piece != Piece::None) score += value(piece, static_cast<Square>(sq));
+    }
+    return score;
+}
+
+int PieceSquareTable::compute_phase(const Position& pos) 
+{
+    int phase = 0;
+    for (int sq = 0; sq < 64; sq++) 
+    {
+        Piece piece = pos.piece_on(static_cast<Square>(sq));
+        if (piece != Piece::None) phase += PieceSquareTable::phase(piece);
+    }
+    return phase;
+}
+
+} // namespace luna
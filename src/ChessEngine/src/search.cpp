@@ -4,6 +4,9 @@
     move ordering, and quiescence search.
 
     UPDATE 08/13/2025: Now uses transposition tables.
+    UPDATE: Lazy SMP helpers with a shared table and depth diversification.
+    UPDATE: Principal variation search and aspiration windows.
+    UPDATE: Null move pruning and late move reductions.
 
     Author: Nicolas Miller
     Date: 08/13/2025
@@ -11,35 +14,77 @@
 
 #include "ChessEngine/include/search.h"
 #include "ChessEngine/include/constants.h"
+#include "movegen.h"
 #include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <limits>
 #include <numeric>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <random>
 
 namespace luna {
 
-Search::Search(Evaluator* eval)
-    : evaluator_(eval), stop_search_(false), nodes_since_time_check_(0), tt_(DEFAULT_HASH_SIZE_MB),
-      tt_hits_(0), tt_cutoffs_(0)
+int Search::lmr_table_[MAX_PLY][MAX_MOVES];
+
+// Reductions grow with the log of both the depth and the move number.
+// The table is filled once, on first construction.
+void Search::init_lmr_table()
+{
+    static const bool initialized = []()
+    {
+        for (int depth = 0; depth < MAX_PLY; depth++) 
+        {
+            for (int move = 0; move < MAX_MOVES; move++) 
+            {
+                lmr_table_[depth][move] = (depth == 0 || move == 0) ? 0 :
+                    static_cast<int>(LMR_BASE + std::log(depth) * std::log(move) / LMR_DIVISOR);
+            }
+        }
+        return true;
+    }();
+    (void)initialized;
+}
+
+Search::Search(Evaluator* eval, TranspositionTable* tt, int thread_id)
+    : evaluator_(eval), time_manager_(nullptr), stop_search_(false), nodes_(0), tt_(tt), 
+      thread_id_(thread_id), use_null_move_(true), use_lmr_(true), use_pvs_(true), nmp_min_ply_(0),
+      nodes_since_time_check_(0), tt_hits_(0), tt_cutoffs_(0)
     {
-        // Initialize killer moves
+        init_lmr_table();
+        
+        // Initialize killer moves and history tables
         std::memset(killer_moves_, 0, sizeof(killer_moves_));
+        std::memset(history_, 0, sizeof(history_));
+        std::memset(countermoves_, 0, sizeof(countermoves_));
+        std::memset(continuation_history_, 0, sizeof(continuation_history_));
     }
 
 Move Search::search_position(Position& position, int max_depth, TimeManager* tm) 
 {
     time_manager_ = tm;
-    stop_search_ = false;
     Move best_move;
     
-    // Reset search info and node counter
+    // Reset search info and node counter. The stop flag is cleared by the
+    // caller, so a stop issued while helpers start up is not lost.
+    nodes_ = 0;
     info_.nodes_searched = 0;
     info_.depth_reached = 0;
     info_.score = 0;
+    info_.pvs_researches = 0;
+    info_.aspiration_researches = 0;
+    info_.null_move_cutoffs = 0;
+    info_.lmr_researches = 0;
+    info_.beta_cutoffs = 0;
+    info_.first_move_cutoffs = 0;
+    info_.eval_cache_hits = 0;
+    info_.eval_cache_misses = 0;
     info_.pv.clear();
+    evaluator_->reset_cache_stats();
+    age_history();
+    nmp_min_ply_ = 0;
     nodes_since_time_check_ = 0;
     
     // Reset TT statistics
@@ -49,7 +94,7 @@ Move Search::search_position(Position& position, int max_depth, TimeManager* tm)
     // Simple opening book for when engine plays as white from starting position
     // Check if this is the actual starting position (not just move count 0)
     std::string starting_fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
-    if (position.to_fen() == starting_fen) 
+    if (thread_id_ == 0 && position.to_fen() == starting_fen) 
     {
         std::vector<Move> legal_moves = position.generate_legal_moves();
         std::vector<Move> opening_moves;
@@ -59,22 +104,22 @@ Move Search::search_position(Position& position, int max_depth, TimeManager* tm)
         for (const Move& move : legal_moves) 
         {
             // e2-e4 (King's pawn)
-            if (move.from_square == Square::E2 && move.to_square == Square::E4) 
+            if (move.from_square() == Square::E2 && move.to_square() == Square::E4) 
             {
                 opening_moves.push_back(move);
             }
             // d2-d4 (Queen's pawn)
-            else if (move.from_square == Square::D2 && move.to_square == Square::D4) 
+            else if (move.from_square() == Square::D2 && move.to_square() == Square::D4) 
             {
                 opening_moves.push_back(move);
             }
             // Ng1-f3 (King's knight)
-            else if (move.from_square == Square::G1 && move.to_square == Square::F3) 
+            else if (move.from_square() == Square::G1 && move.to_square() == Square::F3) 
             {
                 opening_moves.push_back(move);
             }
             // c2-c4 (English opening)
-            else if (move.from_square == Square::C2 && move.to_square == Square::C4) 
+            else if (move.from_square() == Square::C2 && move.to_square() == Square::C4) 
             {
                 opening_moves.push_back(move);
             }
@@ -104,29 +149,69 @@ Move Search::search_position(Position& position, int max_depth, TimeManager* tm)
     // Iterative deepening
     for (int depth = 1; depth <= max_depth && !stop_search_; depth++) 
     {
+        // Helpers skip some depths so threads spread over different iterations
+        if (skip_iteration(depth)) continue;
+        
         Move iteration_best_move;
         
-        // Start new search iteration
-        tt_.new_search();
+        // From ASPIRATION_MIN_DEPTH on, search a narrow window around the last
+        // score and widen it on the failing side until the score lands inside
+        int alpha = -INFINITY_SCORE;
+        int beta = INFINITY_SCORE;
+        int delta = ASPIRATION_WINDOW;
+        if (use_pvs_ && depth >= ASPIRATION_MIN_DEPTH && std::abs(info_.score) < MATE_BOUND) 
+        {
+            alpha = std::max(info_.score - delta, -INFINITY_SCORE);
+            beta = std::min(info_.score + delta, INFINITY_SCORE);
+        }
         
-        // Search with the current depth
-        int score = negamax_root(position, depth, -INFINITY_SCORE, INFINITY_SCORE, iteration_best_move, 0);
+        // The previous iteration's best move is searched first; after a fail
+        // high the move that failed high is
+        Move root_move = best_move;
+        int score = 0;
+        while (true) 
+        {
+            iteration_best_move = Move();
+            score = negamax_root(position, depth, alpha, beta, root_move, iteration_best_move, 0);
+            if (stop_search_) break;
+            
+            if (score <= alpha) 
+            {
+                alpha = std::max(score - delta, -INFINITY_SCORE);
+            } 
+            else if (score >= beta) 
+            {
+                beta = std::min(score + delta, INFINITY_SCORE);
+                root_move = iteration_best_move;
+            } 
+            else 
+            {
+                break;
+            }
+            
+            info_.aspiration_researches++;
+            delta += delta / 2;
+        }
         
         if (!stop_search_) 
         {
             info_.depth_reached = depth;
             info_.score = score;
+            info_.nodes_searched = nodes();
+            info_.eval_cache_hits = evaluator_->cache_hits();
+            info_.eval_cache_misses = evaluator_->cache_misses();
             
             // Update best move from this iteration
-            if (iteration_best_move.from_square != Square::None) 
+            if (!iteration_best_move.is_none()) 
             {
                 best_move = iteration_best_move;
                 // Update PV with best move
-                if (info_.pv.empty()) {
-                    info_.pv.push_back(best_move);
-                }
+                info_.pv.assign(1, best_move);
             }
             
+            // Only the main thread reports
+            if (thread_id_ != 0) continue;
+            
             // Print search info for debugging
             print_search_info(depth, score, time_manager_->elapsed_ms());
             
@@ -139,6 +224,22 @@ Move Search::search_position(Position& position, int max_depth, TimeManager* tm)
                 std::cout << " (hit rate: " << hit_rate << "%, cutoff rate: " << cutoff_rate << "%)";
             }
             std::cout << std::endl;
+            
+            // Print re-search statistics
+            std::cout << "[SEARCH STATS] Depth " << depth << ": " << info_.pvs_researches 
+                      << " PVS re-searches, " << info_.aspiration_researches 
+                      << " aspiration re-searches, " << info_.lmr_researches 
+                      << " LMR re-searches, " << info_.null_move_cutoffs 
+                      << " null move cutoffs, " << std::fixed << std::setprecision(1) << info_.first_move_cutoff_rate() 
+                      << "% of cutoffs on the first move, " << info_.eval_cache_hit_rate() 
+                      << "% eval cache hits" << std::endl;
+            
+            // Between iterations the time manager decides whether another
+            // one is worth starting
+            if (time_manager_ && time_manager_->stop_after_iteration(best_move, score, time_manager_->elapsed_ms())) 
+            {
+                break;
+            }
         }
     }
     
@@ -148,7 +249,8 @@ Move Search::search_position(Position& position, int max_depth, TimeManager* tm)
 // Root-level negamax search with alpha-beta pruning.
 // Used for the first search level (tracks best move for iterative deepening)
 // Called only from search_position; handles move tracking and root-specific logic.
-int Search::negamax_root(Position& pos, int depth, int alpha, int beta, Move& best_move, int ply) 
+int Search::negamax_root(Position& pos, int depth, int alpha, int beta, const Move& previous_best,
+                         Move& best_move, int ply) 
 {
     // Check for timeout
     if (should_check_time()) 
@@ -157,40 +259,45 @@ int Search::negamax_root(Position& pos, int depth, int alpha, int beta, Move& be
         return 0;
     }
     
-    info_.nodes_searched++;
-    
-    // Generate and order moves
-    std::vector<Move> legal_moves = pos.generate_legal_moves();
-    if (legal_moves.empty()) 
-    {
-        if (pos.is_in_check()) 
-        {
-            // Checkmate - return negative mate score
-            return -MATE_SCORE + static_cast<int>(pos.move_count());
-        }
-        else 
-        {
-            // Stalemate
-            return 0;
-        }
-    }
+    count_node();
     
-    // Order moves for better pruning (no TT move at root)
-    Move empty_move;
-    order_moves(legal_moves, pos, empty_move);
+    // Moves come from the picker in stages, starting with the previous
+    // iteration's best move in place of a TT move
+    MovePicker picker(pos, previous_best, killer_moves_[std::min(ply, MAX_PLY - 1)], countermove(pos),
+                      &history_[static_cast<int>(pos.side_to_move())], continuation_row(pos));
     
     int best_score = -INFINITY_SCORE;
+    int moves_searched = 0;
+    Move quiets_tried[MAX_MOVES];
+    int quiet_count = 0;
     
     // Search all moves
-    for (const Move& move : legal_moves) 
+    for (Move move = picker.next_move(); !move.is_none(); move = picker.next_move()) 
     {
         if (stop_search_) break;
         
-        // Make move
+        // Start loading the child's table entry, then make the move
+        tt_->prefetch(pos.key_after(move));
         pos.make_move(move);
         
-        // Recursive search with negamax
-        int score = -negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+        // Principal variation search: the first move gets the full window;
+        // later moves only need a null window to show they are no better
+        // than alpha, and are searched again if one turns out to be
+        int score;
+        if (moves_searched == 0 || !use_pvs_) 
+        {
+            score = -negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+        } 
+        else 
+        {
+            score = -negamax(pos, depth - 1, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && score < beta && !stop_search_) 
+            {
+                info_.pvs_researches++;
+                score = -negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+            }
+        }
+        moves_searched++;
         
         // Undo move
         pos.undo_move();
@@ -209,18 +316,26 @@ int Search::negamax_root(Position& pos, int depth, int alpha, int beta, Move& be
             }
         }
         
+        bool quiet = move.move_type() == MoveType::Normal || move.move_type() == MoveType::Castle;
+        
         // Beta cutoff
         if (score >= beta) 
         {
-            // Update killer moves for non-captures
-            if (move.move_type != MoveType::Capture) 
-            {
-                killer_moves_[0][1] = killer_moves_[0][0];
-                killer_moves_[0][0] = move;
-            }
+            info_.beta_cutoffs++;
+            if (moves_searched == 1) info_.first_move_cutoffs++;
+            if (quiet) update_quiet_stats(pos, move, ply, depth, quiets_tried, quiet_count);
             
             return beta;
         }
+        
+        if (quiet) quiets_tried[quiet_count++] = move;
+    }
+    
+    // No legal moves: checkmate or stalemate
+    if (moves_searched == 0) 
+    {
+        if (stop_search_) return 0;
+        return pos.is_in_check() ? -MATE_SCORE + ply : 0;
     }
     
     return best_score;
@@ -238,7 +353,7 @@ int Search::negamax(Position& pos, int depth, int alpha, int beta, int ply)
         return 0;
     }
     
-    info_.nodes_searched++;
+    count_node();
     
     // Store original alpha for TT bound type determination
     int original_alpha = alpha;
@@ -249,7 +364,7 @@ int Search::negamax(Position& pos, int depth, int alpha, int beta, int ply)
     BoundType tt_bound;
     Move tt_move;
     
-    if (tt_.probe(hash_key, tt_score, tt_depth, tt_bound, tt_move, ply)) 
+    if (tt_->probe(hash_key, tt_score, tt_depth, tt_bound, tt_move, ply)) 
     {
         // Use TT result if depth is sufficient
         if (tt_depth >= depth) 
@@ -296,44 +411,120 @@ int Search::negamax(Position& pos, int depth, int alpha, int beta, int ply)
         }
     }
     
-    // Check for game over
-    std::vector<Move> legal_moves = pos.generate_legal_moves();
-    if (legal_moves.empty())
+    bool in_check = pos.is_in_check();
+    
+    // Leaf node - evaluate position. Quiescence only looks at captures, so
+    // checkmate is recognized here first.
+    if (depth == 0) 
     {
-        if (pos.is_in_check()) 
-        {
-            // Checkmate - return negative mate score (bad for side to move)
-            return -MATE_SCORE + static_cast<int>(pos.move_count());
-        }
-        else 
+        if (in_check) 
         {
-            // Stalemate
-            return 0;
+            MoveList evasions;
+            MoveGenerator::generate<GenType::Evasions>(pos, evasions);
+            if (evasions.empty()) return -MATE_SCORE + ply;
         }
+        return quiescence(pos, alpha, beta, ply);
     }
     
-    // Leaf node - evaluate position
-    if (depth == 0) 
+    // Null move pruning: if passing still fails high after a reduced search,
+    // a real move almost certainly would too. Skipped in PV nodes, in check,
+    // right after another null move and without non-pawn material, where
+    // zugzwang makes passing unrealistically good.
+    bool pv_node = beta - alpha > 1;
+    if (use_null_move_ && !pv_node && !in_check && depth >= NULL_MOVE_MIN_DEPTH && 
+        ply >= nmp_min_ply_ && !(pos.move_count() > 0 && pos.last_move().is_none()) &&
+        has_non_pawn_material(pos, pos.side_to_move()) && evaluator_->evaluate(pos) >= beta) 
     {
-        return quiescence(pos, alpha, beta, ply);
+        int reduced_depth = std::max(0, depth - 1 - NULL_MOVE_REDUCTION);
+        
+        pos.make_null_move();
+        int null_score = -negamax(pos, reduced_depth, -beta, -beta + 1, ply + 1);
+        pos.undo_null_move();
+        
+        if (stop_search_) return 0;
+        
+        if (null_score >= beta) 
+        {
+            // Don't trust a mate found by passing
+            if (null_score >= MATE_BOUND) null_score = beta;
+            
+            // At high depth, verify with a normal reduced search that has
+            // null moves disabled for the next plies
+            if (depth < NULL_MOVE_VERIFY_DEPTH) 
+            {
+                info_.null_move_cutoffs++;
+                return null_score;
+            }
+            
+            int saved_min_ply = nmp_min_ply_;
+            nmp_min_ply_ = ply + 3 * reduced_depth / 4;
+            int verify_score = negamax(pos, reduced_depth, beta - 1, beta, ply);
+            nmp_min_ply_ = saved_min_ply;
+            
+            if (verify_score >= beta) 
+            {
+                info_.null_move_cutoffs++;
+                return null_score;
+            }
+        }
     }
     
-    // Order moves for better pruning (use TT move if available)
-    order_moves(legal_moves, pos, tt_move);
+    // Moves come from the picker in stages, starting with the TT move
+    MovePicker picker(pos, tt_move, killer_moves_[std::min(ply, MAX_PLY - 1)], countermove(pos),
+                      &history_[static_cast<int>(pos.side_to_move())], continuation_row(pos));
     
     int best_score = -INFINITY_SCORE;
+    int moves_searched = 0;
     Move best_move;
+    Move quiets_tried[MAX_MOVES];
+    int quiet_count = 0;
     
     // Search all moves
-    for (const Move& move : legal_moves) 
+    for (Move move = picker.next_move(); !move.is_none(); move = picker.next_move()) 
     {
         if (stop_search_) break;
         
-        // Make move
+        bool quiet = move.move_type() == MoveType::Normal || move.move_type() == MoveType::Castle;
+        bool gives_check = quiet && MoveGenerator::gives_check(pos, move);
+        
+        // Start loading the child's table entry, then make the move
+        tt_->prefetch(pos.key_after(move));
         pos.make_move(move);
         
-        // Recursive search with negamax
-        int score = -negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+        // Principal variation search: the first move gets the full window;
+        // later moves only need a null window to show they are no better
+        // than alpha, and are searched again if one turns out to be
+        int score;
+        if (moves_searched == 0 || !use_pvs_) 
+        {
+            score = -negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+        } 
+        else 
+        {
+            // Late move reductions: quiet moves ordered late are searched
+            // shallower first and only get full depth if they beat alpha
+            int reduction = 0;
+            if (use_lmr_ && quiet && !in_check && !gives_check && depth >= LMR_MIN_DEPTH && 
+                moves_searched >= LMR_MOVE_COUNT_THRESHOLD) 
+            {
+                reduction = lmr_table_[std::min(depth, MAX_PLY - 1)][std::min(moves_searched, MAX_MOVES - 1)];
+                if (pv_node) reduction--;
+                reduction = std::max(0, std::min(reduction, depth - 2));
+            }
+            
+            score = -negamax(pos, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+            if (reduction > 0 && score > alpha && !stop_search_) 
+            {
+                info_.lmr_researches++;
+                score = -negamax(pos, depth - 1, -alpha - 1, -alpha, ply + 1);
+            }
+            if (score > alpha && score < beta && !stop_search_) 
+            {
+                info_.pvs_researches++;
+                score = -negamax(pos, depth - 1, -beta, -alpha, ply + 1);
+            }
+        }
+        moves_searched++;
         
         // Undo move
         pos.undo_move();
@@ -355,20 +546,29 @@ int Search::negamax(Position& pos, int depth, int alpha, int beta, int ply)
         // Beta cutoff
         if (score >= beta) 
         {
-            // Update killer moves
-            int killer_ply = std::min(static_cast<int>(pos.move_count()), MAX_PLY - 1);
-            if (move.move_type != MoveType::Capture) 
-            {
-                killer_moves_[killer_ply][1] = killer_moves_[killer_ply][0];
-                killer_moves_[killer_ply][0] = move;
-            }
+            info_.beta_cutoffs++;
+            if (moves_searched == 1) info_.first_move_cutoffs++;
+            if (quiet) update_quiet_stats(pos, move, ply, depth, quiets_tried, quiet_count);
             
             best_score = beta;
             best_move = move;
             break;
         }
+        
+        if (quiet) quiets_tried[quiet_count++] = move;
+    }
+    
+    // No legal moves: checkmate or stalemate
+    if (moves_searched == 0) 
+    {
+        if (stop_search_) return 0;
+        return in_check ? -MATE_SCORE + ply : 0;
     }
     
+    // A stopped search has not seen the remaining moves, so its partial
+    // score is not a bound; leave the table alone
+    if (stop_search_) return 0;
+    
     // Store in transposition table
     BoundType bound_type;
     if (best_score <= original_alpha) 
@@ -384,93 +584,11 @@ int Search::negamax(Position& pos, int depth, int alpha, int beta, int ply)
         bound_type = BoundType::EXACT;        // Exact score
     }
     
-    tt_.store(hash_key, best_score, depth, bound_type, best_move, ply);
+    tt_->store(hash_key, best_score, depth, bound_type, best_move, ply);
     
     return best_score;
 }
 
-void Search::order_moves(std::vector<Move>& moves, const Position& pos, const Move& tt_move) 
-{
-    // Score each move for ordering
-    std::vector<int> scores(moves.size());
-    
-    for (size_t i = 0; i < moves.size(); i++) 
-    {
-        const Move& move = moves[i];
-        int score = 0;
-        
-        // TT move gets highest priority
-        if (tt_move.from_square != Square::None && move == tt_move) 
-        {
-            score = TT_MOVE_SCORE;
-        }
-        // Captures - use MVV-LVA
-        else if (move.move_type == MoveType::Capture || move.move_type == MoveType::EnPassant) 
-        {
-            // Get piece values for MVV-LVA
-            Piece victim = pos.piece_on(move.to_square);
-            if (move.move_type == MoveType::EnPassant) 
-            {
-                // En passant always captures a pawn
-                victim = (pos.side_to_move() == Color::White) ? Piece::BlackPawn : Piece::WhitePawn;
-            }
-            
-            Piece attacker = pos.piece_on(move.from_square);
-            
-            if (attacker != Piece::None && victim != Piece::None) 
-            {
-                // Use MVV-LVA offset table for precise capture scoring
-                int victim_index = static_cast<int>(type_of(victim));
-                int attacker_index = static_cast<int>(type_of(attacker));
-                score = WINNING_CAPTURE_SCORE + MVV_LVA_OFFSET[attacker_index][victim_index];
-            }
-        }
-        // Promotions
-        else if (move.move_type == MoveType::Promotion) 
-        {
-            score = PROMOTION_SCORE + get_piece_value(type_of(move.promotion_piece));
-        }
-        // Killer moves
-        else if (move == killer_moves_[std::min(static_cast<int>(pos.move_count()), MAX_PLY - 1)][0]) 
-        {
-            score = KILLER_MOVE_1_SCORE;
-        }
-        else if (move == killer_moves_[std::min(static_cast<int>(pos.move_count()), MAX_PLY - 1)][1]) 
-        {
-            score = KILLER_MOVE_2_SCORE;
-        }
-        // Other quiet moves get score of 0
-        else 
-        {
-            score = 0;
-        }
-        
-        scores[i] = score;
-    }
-    
-    // Pair moves with their score
-    std::vector<std::pair<Move, int>> move_score_pairs;
-    move_score_pairs.reserve(moves.size());
-    
-    for (size_t i = 0; i < moves.size(); i++) 
-    {
-        move_score_pairs.emplace_back(moves[i], scores[i]);
-    }
-    
-    // Sort by score (descending)
-    std::sort(move_score_pairs.begin(), move_score_pairs.end(), 
-        [](const auto& a, const auto& b) 
-        {
-            return a.second > b.second;  // Compare scores
-        });
-    
-    // Extract sorted moves
-    for (size_t i = 0; i < moves.size(); i++) 
-    {
-        moves[i] = move_score_pairs[i].first;
-    }
-}
-
 int Search::quiescence(Position& pos, int alpha, int beta, int ply) 
 {
     if (should_check_time()) 
@@ -479,7 +597,7 @@ int Search::quiescence(Position& pos, int alpha, int beta, int ply)
         return 0;
     }
     
-    info_.nodes_searched++;
+    count_node();
     
     // Stand pat - evaluate current position from side to move's perspective
     int stand_pat = evaluator_->evaluate(pos);
@@ -494,26 +612,12 @@ int Search::quiescence(Position& pos, int alpha, int beta, int ply)
         alpha = stand_pat;
     }
     
-    // Generate only capture moves and promotions
-    std::vector<Move> captures;
-    std::vector<Move> all_moves = pos.generate_legal_moves();
-    
-    for (const Move& move : all_moves) 
-    {
-        if (move.move_type == MoveType::Capture || 
-            move.move_type == MoveType::EnPassant ||
-            move.move_type == MoveType::Promotion) 
-            {
-                captures.push_back(move);
-            }
-    }
-    
-    // Order captures (no TT move for quiescence)
-    Move empty_move;
-    order_moves(captures, pos, empty_move);
+    // Captures and promotions only, best first. Captures that lose material
+    // by static exchange evaluation are pruned by the picker.
+    MovePicker picker(pos);
     
     // Search captures
-    for (const Move& move : captures) 
+    for (Move move = picker.next_move(); !move.is_none(); move = picker.next_move()) 
     {
         if (stop_search_) break;
         
@@ -537,16 +641,20 @@ int Search::quiescence(Position& pos, int alpha, int beta, int ply)
 
 void Search::print_search_info(int depth, int score, int time_ms) const 
 {
+    uint64_t nodes = total_nodes();
+    
     std::cout << "info depth " << depth 
               << " score cp " << score
-              << " nodes " << info_.nodes_searched
+              << " nodes " << nodes
               << " time " << time_ms;
     
     if (time_ms > 0) 
     {
-        std::cout << " nps " << (info_.nodes_searched * 1000) / time_ms;
+        std::cout << " nps " << (nodes * 1000) / static_cast<uint64_t>(time_ms);
     }
     
+    std::cout << " hashfull " << tt_->hashfull();
+    
     // Print PV if available
     if (!info_.pv.empty()) 
     {
@@ -565,18 +673,117 @@ const Search::SearchInfo& Search::get_search_info() const
     return info_;
 }
 
-int Search::get_piece_value(PieceType pt) const 
+uint64_t Search::total_nodes() const 
+{
+    uint64_t nodes = this->nodes();
+    for (const Search* helper : helpers_) 
+    {
+        nodes += helper->nodes();
+    }
+    return nodes;
+}
+
+bool Search::skip_iteration(int depth) const 
 {
-    switch (pt) 
+    if (thread_id_ == 0) return false;
+    
+    int index = (thread_id_ - 1) % SMP_SKIP_TABLE_SIZE;
+    return ((depth + SMP_SKIP_PHASE[index]) / SMP_SKIP_SIZE[index]) % 2 != 0;
+}
+
+void Search::update_quiet_stats(const Position& pos, const Move& move, int ply, int depth,
+                                const Move* quiets_tried, int quiet_count) 
+{
+    int killer_ply = std::min(ply, MAX_PLY - 1);
+    if (killer_moves_[killer_ply][0] != move) 
+    {
+        killer_moves_[killer_ply][1] = killer_moves_[killer_ply][0];
+        killer_moves_[killer_ply][0] = move;
+    }
+    
+    int side = static_cast<int>(pos.side_to_move());
+    int bonus = std::min(depth * depth, HISTORY_MAX);
+    PieceToHistory* continuation = continuation_row(pos);
+    
+    if (continuation) 
+    {
+        Move last = pos.last_move();
+        countermoves_[static_cast<int>(pos.piece_on(last.to_square()))][static_cast<int>(last.to_square())] = move;
+    }
+    
+    // The cutoff move gains what the moves searched before it lose
+    for (int i = -1; i < quiet_count; i++) 
+    {
+        const Move& quiet = (i < 0) ? move : quiets_tried[i];
+        int delta = (i < 0) ? bonus : -bonus;
+        int from = static_cast<int>(quiet.from_square());
+        int to = static_cast<int>(quiet.to_square());
+        
+        apply_gravity(history_[side][from][to], delta);
+        if (continuation) 
+        {
+            apply_gravity((*continuation)[static_cast<int>(pos.piece_on(quiet.from_square()))][to], delta);
+        }
+    }
+}
+
+Move Search::countermove(const Position& pos) const 
+{
+    Move last = pos.last_move();
+    if (pos.move_count() == 0 || last.is_none()) return Move();
+    
+    Piece moved = pos.piece_on(last.to_square());
+    if (moved == Piece::None) return Move();
+    
+    return countermoves_[static_cast<int>(moved)][static_cast<int>(last.to_square())];
+}
+
+PieceToHistory* Search::continuation_row(const Position& pos) 
+{
+    if (pos.move_count() == 0) return nullptr;
+    
+    Move last = pos.last_move();
+    if (last.is_none()) return nullptr;
+    
+    Piece moved = pos.piece_on(last.to_square());
+    if (moved == Piece::None) return nullptr;
+    
+    return &continuation_history_[static_cast<int>(moved)][static_cast<int>(last.to_square())];
+}
+
+void Search::apply_gravity(int& entry, int bonus) 
+{
+    entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
+
+void Search::age_history() 
+{
+    std::memset(killer_moves_, 0, sizeof(killer_moves_));
+    
+    for (auto& side : history_) 
     {
-        case PieceType::Pawn:   return PAWN_VALUE;
-        case PieceType::Knight: return KNIGHT_VALUE;
-        case PieceType::Bishop: return BISHOP_VALUE;
-        case PieceType::Rook:   return ROOK_VALUE;
-        case PieceType::Queen:  return QUEEN_VALUE;
-        case PieceType::King:   return KING_VALUE;
-        default: return 0;
+        for (auto& from : side) 
+        {
+            for (int& entry : from) entry /= HISTORY_DIVISOR;
+        }
     }
+    
+    for (auto& piece : continuation_history_) 
+    {
+        for (auto& to : piece) 
+        {
+            for (auto& reply_piece : to) 
+            {
+                for (int& entry : reply_piece) entry /= HISTORY_DIVISOR;
+            }
+        }
+    }
+}
+
+bool Search::has_non_pawn_material(const Position& pos, Color color) const 
+{
+    return pos.pieces(color, PieceType::Knight).any() || pos.pieces(color, PieceType::Bishop).any() ||
+           pos.pieces(color, PieceType::Rook).any() || pos.pieces(color, PieceType::Queen).any();
 }
 
 bool Search::should_check_time() 
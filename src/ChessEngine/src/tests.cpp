@@ -10,7 +10,293 @@
 #include <map>
 #include <algorithm>
 #include <functional>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+#include <thread>
 #include "movegen.h"
+#include "movelist.h"
+#include "zobrist.h"
+#include "perft.h"
+#include "engine.h"
+#include "move_picker.h"
+#include "transposition_table.h"
+#include "constants.h"
+#include "psqt.h"
+#include "evaluator.h"
+#include "nnue.h"
+#include "nnue_evaluator.h"
+#include "eval_batch.h"
+#include "tuner.h"
+
+// Count heap allocations so tests can check that hot paths never allocate.
+// Replacing the global operators applies to the whole test binary (only
+// luna_tests links this file). Atomic because searches and the tuner
+// allocate from several threads.
+static std::atomic<size_t> g_allocation_count{0};
+
+void* operator new(std::size_t size)
+{
+    ++g_allocation_count;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    ++g_allocation_count;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// Walk a perft tree and count nodes where the pin-aware generator and the
+// filtering generator disagree
+static int count_generator_mismatches(Position& pos, int depth)
+{
+    MoveList pin_aware;
+    MoveList filtered;
+    MoveGenerator::generate_legal_moves(pos, pin_aware, LegalityMode::PinAware);
+    MoveGenerator::generate_legal_moves(pos, filtered, LegalityMode::Filter);
+    
+    int mismatches = 0;
+    if (pin_aware.size() != filtered.size()) {
+        mismatches++;
+    } else {
+        for (const Move& move : pin_aware) {
+            if (!filtered.contains(move)) {
+                mismatches++;
+                break;
+            }
+        }
+    }
+    
+    if (depth <= 1) return mismatches;
+    
+    for (const Move& move : pin_aware) {
+        pos.make_move(move);
+        mismatches += count_generator_mismatches(pos, depth - 1);
+        pos.undo_move();
+    }
+    
+    return mismatches;
+}
+
+// Walk a perft tree and count nodes where the staged generators disagree with
+// the full legal move list
+static int count_staged_mismatches(Position& pos, int depth)
+{
+    MoveList legal, captures, quiets, evasions, quiet_checks;
+    MoveGenerator::generate_legal_moves(pos, legal, LegalityMode::Filter);
+    MoveGenerator::generate<GenType::Captures>(pos, captures);
+    MoveGenerator::generate<GenType::Quiets>(pos, quiets);
+    MoveGenerator::generate<GenType::Evasions>(pos, evasions);
+    MoveGenerator::generate<GenType::QuietChecks>(pos, quiet_checks);
+    
+    bool ok = captures.size() + quiets.size() == legal.size();
+    for (const Move& move : captures) {
+        ok = ok && legal.contains(move) && move.move_type() != MoveType::Normal && move.move_type() != MoveType::Castle;
+    }
+    for (const Move& move : quiets) {
+        ok = ok && legal.contains(move) && (move.move_type() == MoveType::Normal || move.move_type() == MoveType::Castle);
+    }
+    
+    // Evasions are the full legal list in check and empty otherwise
+    if (pos.is_in_check()) {
+        ok = ok && evasions.size() == legal.size();
+        for (const Move& move : evasions) ok = ok && legal.contains(move);
+    } else {
+        ok = ok && evasions.empty();
+    }
+    
+    // Quiet checks are exactly the quiets that leave the opponent in check
+    size_t checking_quiets = 0;
+    for (const Move& move : quiets) {
+        pos.make_move(move);
+        bool check = pos.is_in_check();
+        pos.undo_move();
+        if (check) {
+            checking_quiets++;
+            ok = ok && quiet_checks.contains(move);
+        }
+    }
+    ok = ok && checking_quiets == quiet_checks.size();
+    
+    int mismatches = ok ? 0 : 1;
+    if (depth <= 1) return mismatches;
+    
+    for (const Move& move : legal) {
+        pos.make_move(move);
+        mismatches += count_staged_mismatches(pos, depth - 1);
+        pos.undo_move();
+    }
+    
+    return mismatches;
+}
+
+// Walk a perft tree and count nodes where some packed move is accepted by
+// is_pseudo_legal + is_legal but not generated, or the reverse (castling
+// is never accepted)
+static int count_pseudo_legal_mismatches(Position& pos, int depth)
+{
+    MoveList legal;
+    MoveGenerator::generate_legal_moves(pos, legal);
+    
+    int mismatches = 0;
+    for (uint32_t raw = 1; raw <= 0xFFFF; raw++) {
+        Move move = Move::from_raw(static_cast<uint16_t>(raw));
+        bool accepted = MoveGenerator::is_pseudo_legal(pos, move) && MoveGenerator::is_legal(pos, move);
+        bool expected = move.move_type() != MoveType::Castle && legal.contains(move);
+        if (accepted != expected) mismatches++;
+    }
+    if (depth <= 1) return mismatches;
+    
+    for (const Move& move : legal) {
+        pos.make_move(move);
+        mismatches += count_pseudo_legal_mismatches(pos, depth - 1);
+        pos.undo_move();
+    }
+    
+    return mismatches;
+}
+
+// Walk a perft tree and count nodes where the incrementally updated hash
+// or pawn hash differs from a full recomputation, before or after undoing a move
+static int count_hash_mismatches(Position& pos, int depth)
+{
+    bool matches = pos.hash_key() == luna::ZobristHash::hash_position(pos) &&
+                   pos.pawn_key() == luna::ZobristHash::hash_pawns(pos);
+    int mismatches = matches ? 0 : 1;
+    if (depth == 0) return mismatches;
+    
+    MoveList moves;
+    pos.generate_legal_moves(moves);
+    
+    for (const Move& move : moves) {
+        uint64_t key_before = pos.hash_key();
+        pos.make_move(move);
+        mismatches += count_hash_mismatches(pos, depth - 1);
+        pos.undo_move();
+        if (pos.hash_key() != key_before) mismatches++;
+    }
+    
+    return mismatches;
+}
+
+// Walk a perft tree and count nodes where the incrementally updated
+// material/piece-square score or game phase differs from a full recomputation
+static int count_psq_mismatches(Position& pos, int depth)
+{
+    bool matches = pos.psq_score() == luna::PieceSquareTable::compute_score(pos) &&
+                   pos.game_phase() == luna::PieceSquareTable::compute_phase(pos);
+    int mismatches = matches ? 0 : 1;
+    if (depth == 0) return mismatches;
+    
+    MoveList moves;
+    pos.generate_legal_moves(moves);
+    
+    for (const Move& move : moves) {
+        pos.make_move(move);
+        mismatches += count_psq_mismatches(pos, depth - 1);
+        pos.undo_move();
+    }
+    
+    return mismatches;
+}
+
+// Walk a perft tree and count nodes where an evaluator whose pawn hash has
+// seen the earlier nodes disagrees with a freshly built one
+static int count_pawn_cache_mismatches(Position& pos, int depth, luna::Evaluator& cached)
+{
+    luna::Evaluator fresh;
+    int mismatches = (cached.evaluate(pos) != fresh.evaluate(pos)) ? 1 : 0;
+    if (depth == 0) return mismatches;
+    
+    MoveList moves;
+    pos.generate_legal_moves(moves);
+    
+    for (const Move& move : moves) {
+        pos.make_move(move);
+        mismatches += count_pawn_cache_mismatches(pos, depth - 1, cached);
+        pos.undo_move();
+    }
+    
+    return mismatches;
+}
+
+// Positions with castling, en passant, promotions and pawn endings, walked
+// by the incremental update and evaluation tests
+static const char* const TEST_FENS[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+};
+
+// Snapshot the positions of a perft tree into boards, with their scores
+// from one-at-a-time evaluation, stopping at limit
+static void collect_boards(Position& pos, int depth, luna::Evaluator& eval, std::vector<luna::BoardSnapshot>& boards,
+                           std::vector<int>& scores, size_t limit)
+{
+    if (boards.size() >= limit) return;
+    boards.push_back(luna::snapshot_position(pos));
+    scores.push_back(eval.evaluate(pos));
+    if (depth == 0) return;
+    
+    MoveList moves;
+    pos.generate_legal_moves(moves);
+    
+    for (const Move& move : moves) {
+        pos.make_move(move);
+        collect_boards(pos, depth - 1, eval, boards, scores, limit);
+        pos.undo_move();
+    }
+}
+
+// Walk a perft tree and count nodes where incrementally updated NNUE
+// accumulators give a different score than ones rebuilt from scratch
+static int count_nnue_mismatches(Position& pos, int depth, luna::NnueEvaluator& incremental,
+                                 luna::NnueEvaluator& refreshed)
+{
+    refreshed.reset();
+    int mismatches = (incremental.evaluate(pos) != refreshed.evaluate(pos)) ? 1 : 0;
+    if (depth == 0) return mismatches;
+    
+    MoveList moves;
+    pos.generate_legal_moves(moves);
+    
+    for (const Move& move : moves) {
+        pos.make_move(move);
+        mismatches += count_nnue_mismatches(pos, depth - 1, incremental, refreshed);
+        pos.undo_move();
+    }
+    
+    return mismatches;
+}
+
+// Make/undo perft over MoveLists; the allocation-free path used by search
+static uint64_t perft_make_undo(Position& pos, int depth)
+{
+    if (depth == 0) return 1;
+    
+    MoveList moves;
+    pos.generate_legal_moves(moves);
+    
+    uint64_t nodes = 0;
+    for (const Move& move : moves) {
+        pos.make_move(move);
+        nodes += perft_make_undo(pos, depth - 1);
+        pos.undo_move();
+    }
+    
+    return nodes;
+}
 
 // ANSI color codes for better output
 const std::string GREEN = "\033[32m";
@@ -300,6 +586,25 @@ void ChessTests::test_piece_functions()
     TEST_ASSERT_EQ(type_of(Piece::WhiteKing), PieceType::King, "Type of white king is King");
     TEST_ASSERT_EQ(color_of(Piece::BlackPawn), Color::Black, "Color of black pawn is Black");
     
+    // Test packed move encoding
+    print_subtest("Packed move encoding");
+    TEST_ASSERT_EQ(sizeof(Move), static_cast<size_t>(2), "Move is 16 bits");
+    TEST_ASSERT(Move().is_none(), "Default move is the null move");
+    
+    Move castle(Square::E8, Square::C8, MoveType::Castle);
+    TEST_ASSERT_EQ(castle.from_square(), Square::E8, "Castle from square decodes");
+    TEST_ASSERT_EQ(castle.to_square(), Square::C8, "Castle to square decodes");
+    TEST_ASSERT_EQ(castle.move_type(), MoveType::Castle, "Castle type decodes");
+    TEST_ASSERT_EQ(castle.promotion_piece(), Piece::None, "Non-promotion has no promotion piece");
+    
+    Move promo(Square::B2, Square::A1, MoveType::Promotion, Piece::BlackKnight);
+    TEST_ASSERT_EQ(promo.move_type(), MoveType::Promotion, "Promotion type decodes");
+    TEST_ASSERT_EQ(promo.promotion_piece(), Piece::BlackKnight, "Black knight promotion decodes");
+    TEST_ASSERT_EQ(promo.to_string(), "b2a1n", "Promotion string includes the piece");
+    TEST_ASSERT(Move::from_raw(promo.raw()) == promo, "Move round-trips through raw()");
+    TEST_ASSERT(promo != Move(Square::B2, Square::A1, MoveType::Promotion, Piece::BlackQueen), 
+                "Promotions to different pieces differ");
+    
     std::cout << GREEN << "All piece function tests passed" << RESET << std::endl;
 }
 
@@ -442,6 +747,53 @@ void ChessTests::test_bitboard_functions()
     TEST_ASSERT_EQ(popped, static_cast<uint8_t>(Square::E4), "Popped LSB is E4");
     TEST_ASSERT_EQ(test_bb.count_bits(), 1, "Bitboard has 1 bit after popping");
     
+    // Test zero checks
+    print_subtest("Empty/any checks");
+    TEST_ASSERT(empty_bb.empty() && !empty_bb.any(), "Empty bitboard is empty");
+    TEST_ASSERT(test_bb.any() && !test_bb.empty(), "Bitboard with H8 set is not empty");
+    test_bb.pop_lsb();
+    TEST_ASSERT(test_bb.empty(), "Bitboard is empty after popping last bit");
+    
+    // Intrinsics and portable fallbacks must agree on every single-bit word 
+    // and on a spread of pseudo-random words.
+    print_subtest("Intrinsic bit operations match fallbacks");
+    int bitop_mismatches = 0;
+    for (int i = 0; i < 64; ++i)
+    {
+        uint64_t b = 1ULL << i;
+        if (bitops::lsb(b) != i || bitops::lsb_fallback(b) != i ||
+            bitops::msb(b) != i || bitops::msb_fallback(b) != i ||
+            bitops::popcount(b) != 1 || bitops::popcount_fallback(b) != 1)
+            ++bitop_mismatches;
+    }
+    
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < 10000; ++i)
+    {
+        // xorshift64
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        if (bitops::lsb(seed) != bitops::lsb_fallback(seed) ||
+            bitops::msb(seed) != bitops::msb_fallback(seed) ||
+            bitops::popcount(seed) != bitops::popcount_fallback(seed))
+            ++bitop_mismatches;
+    }
+    TEST_ASSERT_EQ(bitop_mismatches, 0, "Intrinsics and fallbacks agree");
+    
+    print_subtest("Pawn structure masks");
+    TEST_ASSERT_EQ(Bitboard::adjacent_files(File::A).count_bits(), 8, "File A has one adjacent file");
+    TEST_ASSERT_EQ(Bitboard::adjacent_files(File::E).count_bits(), 16, "File E has two adjacent files");
+    TEST_ASSERT(Bitboard::adjacent_files(File::E).is_bit_set(Square::D4) && 
+                !Bitboard::adjacent_files(File::E).is_bit_set(Square::E4), "Adjacent files exclude the file itself");
+    Bitboard white_span = Bitboard::passed_pawn_span(Color::White, Square::E4);
+    TEST_ASSERT_EQ(white_span.count_bits(), 12, "White e4 span covers d-f files on ranks 5-8");
+    TEST_ASSERT(white_span.is_bit_set(Square::D5) && !white_span.is_bit_set(Square::E4), "White span starts one rank ahead");
+    Bitboard black_span = Bitboard::passed_pawn_span(Color::Black, Square::A7);
+    TEST_ASSERT_EQ(black_span.count_bits(), 12, "Black a7 span covers a-b files on ranks 1-6");
+    TEST_ASSERT(black_span.is_bit_set(Square::B1) && !black_span.is_bit_set(Square::B7), "Black span runs toward rank 1");
+    TEST_ASSERT(Bitboard::passed_pawn_span(Color::White, Square::H8).empty(), "Nothing lies ahead of the last rank");
+    
     std::cout << GREEN << "All bitboard function tests passed" << RESET << std::endl;
 }
 
@@ -602,6 +954,62 @@ void ChessTests::test_sliding_piece_attacks()
     TEST_ASSERT(rook_h8.is_bit_set(Square::A8), "Rook on H8 attacks A8");
     TEST_ASSERT(rook_h8.is_bit_set(Square::H1), "Rook on H8 attacks H1");
     
+    // Magic lookups must agree with the ray-walking reference for every square
+    // and every occupancy of the squares that can block the slider
+    print_subtest("Magic lookups match reference rays");
+    int bishop_mismatches = 0;
+    int rook_mismatches = 0;
+    int occupancies_checked = 0;
+    
+    for (int sq = 0; sq < 64; sq++) {
+        Square square = static_cast<Square>(sq);
+        
+        // Board edges only matter when the slider sits on that edge
+        Bitboard edges = ((Bitboard(Rank::One) | Bitboard(Rank::Eight)) & ~Bitboard(rank_of(square))) |
+                         ((Bitboard(File::A) | Bitboard(File::H)) & ~Bitboard(file_of(square)));
+        
+        for (int piece = 0; piece < 2; piece++) {
+            bool is_bishop = (piece == 0);
+            Bitboard mask = (is_bishop ? Bitboard::bishop_attacks_reference(square, empty)
+                                       : Bitboard::rook_attacks_reference(square, empty)) & ~edges;
+            
+            // List the mask squares so each index can be expanded to an occupancy
+            Square mask_squares[16];
+            int mask_count = 0;
+            Bitboard mask_copy = mask;
+            while (mask_copy.any()) {
+                mask_squares[mask_count++] = static_cast<Square>(mask_copy.pop_lsb());
+            }
+            
+            for (int index = 0; index < (1 << mask_count); index++) {
+                Bitboard occ;
+                for (int bit = 0; bit < mask_count; bit++) {
+                    if (index & (1 << bit)) occ.set_bit(mask_squares[bit]);
+                }
+                
+                // Fill the edges too; they must never change the result
+                Bitboard occ_with_edges = occ | edges;
+                
+                if (is_bishop) {
+                    Bitboard expected = Bitboard::bishop_attacks_reference(square, occ);
+                    if ((Bitboard::bishop_attacks(square, occ) ^ expected).any() ||
+                        (Bitboard::bishop_attacks(square, occ_with_edges) ^ Bitboard::bishop_attacks_reference(square, occ_with_edges)).any())
+                        bishop_mismatches++;
+                } else {
+                    Bitboard expected = Bitboard::rook_attacks_reference(square, occ);
+                    if ((Bitboard::rook_attacks(square, occ) ^ expected).any() ||
+                        (Bitboard::rook_attacks(square, occ_with_edges) ^ Bitboard::rook_attacks_reference(square, occ_with_edges)).any())
+                        rook_mismatches++;
+                }
+                occupancies_checked++;
+            }
+        }
+    }
+    
+    std::cout << "  Checked " << occupancies_checked << " square/occupancy pairs" << std::endl;
+    TEST_ASSERT_EQ(bishop_mismatches, 0, "Bishop magic lookups match reference on all occupancies");
+    TEST_ASSERT_EQ(rook_mismatches, 0, "Rook magic lookups match reference on all occupancies");
+    
     std::cout << GREEN << "All sliding piece attack tests passed" << RESET << std::endl;
 }
 
@@ -776,7 +1184,7 @@ std::map<PieceType, int> count_moves_by_piece(const Position& pos, const std::ve
     
     for (const Move& move : moves)
     {
-        Piece piece = pos.piece_on(move.from_square);
+        Piece piece = pos.piece_on(move.from_square());
         PieceType type = type_of(piece);
         counts[type]++;
     }
@@ -795,7 +1203,7 @@ std::map<MoveType, int> count_moves_by_type(const std::vector<Move>& moves)
     
     for (const Move& move : moves)
     {
-        counts[move.move_type]++;
+        counts[move.move_type()]++;
     }
     
     return counts;
@@ -867,10 +1275,10 @@ void ChessTests::test_position_move_generation()
     // Check for en passant move
     bool has_en_passant = false;
     for (const Move& move : moves) {
-        if (move.move_type == MoveType::EnPassant) {
+        if (move.move_type() == MoveType::EnPassant) {
             has_en_passant = true;
-            TEST_ASSERT_EQ(move.from_square, Square::E5, "En passant from E5");
-            TEST_ASSERT_EQ(move.to_square, Square::F6, "En passant to F6");
+            TEST_ASSERT_EQ(move.from_square(), Square::E5, "En passant from E5");
+            TEST_ASSERT_EQ(move.to_square(), Square::F6, "En passant to F6");
         }
     }
     TEST_ASSERT(has_en_passant, "En passant move is available");
@@ -972,12 +1380,124 @@ void ChessTests::test_position_move_generation()
     // Knight is pinned and can't move
     bool knight_can_move = false;
     for (const Move& move : moves) {
-        if (move.from_square == Square::E5) {
+        if (move.from_square() == Square::E5) {
             knight_can_move = true;
         }
     }
     TEST_ASSERT(!knight_can_move, "Pinned knight cannot move");
     
+    // En passant that would expose the king along the rank
+    print_subtest("En passant discovered check");
+    pos.load_fen("8/8/8/KPp4r/8/8/8/7k w - c6 0 2");
+    moves = pos.generate_legal_moves();
+    bool ep_generated = false;
+    for (const Move& move : moves) {
+        if (move.move_type() == MoveType::EnPassant) ep_generated = true;
+    }
+    TEST_ASSERT(!ep_generated, "En passant exposing the king is illegal");
+    
+    // Double check leaves only king moves
+    print_subtest("Double check");
+    pos.load_fen("4k3/8/8/8/1b6/5N2/8/R3K2r w Q - 0 1");
+    moves = pos.generate_legal_moves();
+    bool only_king_moves = true;
+    for (const Move& move : moves) {
+        if (move.from_square() != Square::E1) only_king_moves = false;
+    }
+    TEST_ASSERT(only_king_moves && !moves.empty(), "Only the king moves in double check");
+    
+    // Pin-aware generation must agree with generate-and-filter everywhere in 
+    // the perft trees of the standard test positions
+    print_subtest("Pin-aware generator matches filter");
+    const char* generator_fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+    };
+    int generator_mismatches = 0;
+    for (const char* fen : generator_fens) {
+        pos.load_fen(fen);
+        generator_mismatches += count_generator_mismatches(pos, 3);
+    }
+    TEST_ASSERT_EQ(generator_mismatches, 0, "Generators agree on every node to depth 3");
+    
+    // Captures and quiets partition the legal moves; evasions and quiet checks
+    // match what make_move reports
+    print_subtest("Staged generation");
+    int staged_mismatches = 0;
+    for (const char* fen : generator_fens) {
+        pos.load_fen(fen);
+        staged_mismatches += count_staged_mismatches(pos, 3);
+    }
+    TEST_ASSERT_EQ(staged_mismatches, 0, "Staged generators agree on every node to depth 3");
+    
+    // Hash and killer moves are validated without generating
+    print_subtest("Pseudo-legal move validation");
+    int pseudo_legal_mismatches = 0;
+    for (const char* fen : generator_fens) {
+        pos.load_fen(fen);
+        pseudo_legal_mismatches += count_pseudo_legal_mismatches(pos, 2);
+    }
+    TEST_ASSERT_EQ(pseudo_legal_mismatches, 0, "is_pseudo_legal accepts exactly the generated moves");
+    
+    // The picker returns every legal move exactly once, hash move first, and
+    // ignores killers that are not legal in the position
+    print_subtest("Staged move picker");
+    const char* picker_fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "rnbqkbnr/ppp2ppp/3p4/4p2Q/4P3/8/PPPP1PPP/RNB1KBNR b KQkq - 1 3",
+        "4k3/8/8/8/8/8/4q3/4K3 w - - 0 1"
+    };
+    int picker_mismatches = 0;
+    for (const char* fen : picker_fens) {
+        pos.load_fen(fen);
+        MoveList legal;
+        MoveGenerator::generate_legal_moves(pos, legal);
+        
+        Move tt_move = legal[legal.size() / 2];
+        Move killers[2] = { legal[legal.size() - 1], Move(Square::A4, Square::A5, MoveType::Normal) };
+        ButterflyHistory history = {};
+        MovePicker picker(pos, tt_move, killers, legal[0], &history, nullptr);
+        
+        MoveList picked;
+        for (Move move = picker.next_move(); !move.is_none(); move = picker.next_move()) {
+            if (picked.contains(move) || !legal.contains(move)) picker_mismatches++;
+            picked.push_back(move);
+        }
+        if (picked.size() != legal.size() || picked[0] != tt_move) picker_mismatches++;
+        
+        MovePicker capture_picker(pos);
+        for (Move move = capture_picker.next_move(); !move.is_none(); move = capture_picker.next_move()) {
+            if (move.move_type() == MoveType::Normal || move.move_type() == MoveType::Castle) picker_mismatches++;
+        }
+    }
+    TEST_ASSERT_EQ(picker_mismatches, 0, "Picker yields each legal move once, hash move first");
+    
+    // Exchange values with x-rays; see_ge agrees with see at the boundary
+    print_subtest("Static exchange evaluation");
+    struct SeeCase { const char* fen; Move move; int value; };
+    const SeeCase see_cases[] = {
+        { "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", Move(Square::E1, Square::E5, MoveType::Capture), 100 },
+        { "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", Move(Square::D3, Square::E5, MoveType::Capture), -220 },
+        { "4k3/8/2p5/3p4/8/8/8/3QK3 w - - 0 1", Move(Square::D1, Square::D5, MoveType::Capture), -800 },
+        { "4k3/8/2p5/3p4/8/8/3R4/3QK3 w - - 0 1", Move(Square::D2, Square::D5, MoveType::Capture), -300 },
+        { "3rk3/3r4/8/3p4/8/8/3R4/3RK3 w - - 0 1", Move(Square::D2, Square::D5, MoveType::Capture), -400 },
+        { "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 2", Move(Square::E5, Square::D6, MoveType::EnPassant), 100 },
+        { "8/8/8/3pk3/8/8/8/3RK3 w - - 0 1", Move(Square::D1, Square::D5, MoveType::Capture), -400 },
+        { "8/8/8/3pk3/8/8/3R4/3RK3 w - - 0 1", Move(Square::D2, Square::D5, MoveType::Capture), 100 },
+        { "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1", Move(Square::E2, Square::E4, MoveType::Normal), 0 }
+    };
+    for (const SeeCase& test : see_cases) {
+        pos.load_fen(test.fen);
+        TEST_ASSERT_EQ(MoveGenerator::see(pos, test.move), test.value, "SEE of " + test.move.to_string());
+        TEST_ASSERT(MoveGenerator::see_ge(pos, test.move, test.value) && 
+                    !MoveGenerator::see_ge(pos, test.move, test.value + 1), 
+                    "see_ge threshold for " + test.move.to_string());
+    }
+    
     std::cout << GREEN << "All move generation tests passed" << RESET << std::endl;
 }
 
@@ -1161,23 +1681,10 @@ void ChessTests::test_game_scenarios()
     // Perft test for move generation correctness
     print_subtest("Standard Perft Tests");
     
-    // Define a perft function
-    std::function<uint64_t(Position&, int)> perft = [&](Position& position, int depth) -> uint64_t 
-    {
-        if (depth == 0) return 1;
-        
-        uint64_t nodes = 0;
-        std::vector<Move> moves = position.generate_legal_moves();
-        
-        for (const Move& move : moves) {
-            Position copy = position;
-            copy.make_move(move);
-            
-            uint64_t curr_nodes = perft(copy, depth - 1);
-            nodes += curr_nodes;
-        }
-        
-        return nodes;
+    // Plain single-threaded perft without a hash table
+    Perft perft_counter;
+    auto perft = [&](Position& position, int depth) -> uint64_t {
+        return perft_counter.count(position, depth);
     };
     
     std::cout << "Using perft depth: " << perft_depth << std::endl;
@@ -1314,6 +1821,22 @@ void ChessTests::test_game_scenarios()
     }
     TEST_ASSERT_EQ(nodes, expected, "Perft(5) from Position 6 = 164075551");
     
+    // Hashed, multithreaded perft must agree with the plain count and its
+    // divide output must sum to the total
+    print_subtest("Hashed and threaded perft");
+    pos.load_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    Perft hashed_perft(16);
+    Perft::Result result = hashed_perft.run(pos, 4, 4);
+    TEST_ASSERT_EQ(result.nodes, 4085603ULL, "Threaded hashed Kiwipete perft(4) = 4085603");
+    
+    uint64_t divide_sum = 0;
+    for (const auto& entry : result.divide) divide_sum += entry.second;
+    TEST_ASSERT_EQ(divide_sum, result.nodes, "Divide counts sum to the total");
+    TEST_ASSERT_EQ(result.divide.size(), static_cast<size_t>(48), "Divide has one line per root move");
+    
+    // A second run reuses the filled table and must return the same count
+    TEST_ASSERT_EQ(hashed_perft.run(pos, 4, 2).nodes, 4085603ULL, "Perft hash reuse keeps counts exact");
+    
     std::cout << GREEN << "All game scenario tests passed" << RESET << std::endl;
 }
 
@@ -1352,6 +1875,37 @@ void ChessTests::test_performance()
     std::cout << "  " << iterations / 100 << " attack generations: " 
               << duration.count() << " microseconds" << std::endl;
     
+    print_subtest("Sliding attack generation");
+    Bitboard blockers;
+    blockers.set_bit(Square::C3);
+    blockers.set_bit(Square::F6);
+    blockers.set_bit(Square::D5);
+    blockers.set_bit(Square::B7);
+    
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations / 10; i++) {
+        Square sq = static_cast<Square>(i % 64);
+        Bitboard::bishop_attacks(sq, blockers);
+        Bitboard::rook_attacks(sq, blockers);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    std::cout << "  " << iterations / 10 << " magic slider lookups: " 
+              << duration.count() << " microseconds" << std::endl;
+    
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations / 10; i++) {
+        Square sq = static_cast<Square>(i % 64);
+        Bitboard::bishop_attacks_reference(sq, blockers);
+        Bitboard::rook_attacks_reference(sq, blockers);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    
+    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    std::cout << "  " << iterations / 10 << " reference ray generations: " 
+              << duration.count() << " microseconds" << std::endl;
+    
     print_subtest("Move generation");
     Position pos;
     pos.load_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
@@ -1366,6 +1920,114 @@ void ChessTests::test_performance()
     std::cout << "  10000 move generations from starting position: " 
               << duration.count() << " microseconds" << std::endl;
     
+    // After a warm-up run has sized the move history, a make/undo perft must 
+    // not touch the heap at all
+    print_subtest("Allocation-free perft");
+    pos.load_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    perft_make_undo(pos, 3);
+    
+    size_t allocations_before = g_allocation_count;
+    uint64_t kiwipete_nodes = perft_make_undo(pos, 3);
+    size_t allocations = g_allocation_count - allocations_before;
+    
+    std::cout << "  Kiwipete perft(3): " << kiwipete_nodes << " nodes, " 
+              << allocations << " heap allocations" << std::endl;
+    TEST_ASSERT_EQ(kiwipete_nodes, 97862ULL, "Kiwipete perft(3) = 97862");
+    TEST_ASSERT_EQ(allocations, static_cast<size_t>(0), "Perft performs no heap allocations");
+    
+    // Helpers share the table and must not change the answer to a forced line
+    print_subtest("Lazy SMP search");
+    pos.load_fen("6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1");
+    Engine smp_engine;
+    smp_engine.set_threads(3);
+    smp_engine.set_max_depth(4);
+    Move smp_move = smp_engine.find_best_move(pos, 10000);
+    TEST_ASSERT_EQ(smp_move.to_string(), std::string("a1a8"), "Three-thread search finds the back rank mate");
+    TEST_ASSERT(smp_engine.get_search_info().nodes_searched > 0, "Node counts are aggregated over threads");
+
+    // Null windows and aspiration windows only speed up the search; without
+    // pruning they must reach the score and move of a full-window search
+    print_subtest("PVS and aspiration windows match a full-window search");
+    const char* window_fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+    };
+    for (const char* fen : window_fens)
+    {
+        Move window_moves[2];
+        int window_scores[2];
+        for (int pvs = 0; pvs < 2; pvs++)
+        {
+            Engine window_engine;
+            window_engine.set_null_move(false);
+            window_engine.set_lmr(false);
+            window_engine.set_pvs(pvs == 1);
+            window_engine.set_max_depth(5);
+            pos.load_fen(fen);
+            window_moves[pvs] = window_engine.find_best_move(pos, 0);
+            window_scores[pvs] = window_engine.get_search_info().score;
+        }
+        std::cout << "  " << window_moves[1].to_string() << " " << window_scores[1]
+                  << " (full window " << window_moves[0].to_string() << " " << window_scores[0] << ")" << std::endl;
+        TEST_ASSERT_EQ(window_scores[1], window_scores[0], "Same score with and without PVS");
+        TEST_ASSERT_EQ(window_moves[1].to_string(), window_moves[0].to_string(), "Same best move with and without PVS");
+    }
+
+    // Iteration times are passed in, so these checks do not depend on the clock
+    print_subtest("Time management");
+    TimeManager tm;
+    SearchLimits limits;
+    limits.time_left_ms = 60000 + MOVE_OVERHEAD_MS;
+    tm.start_search(limits);
+    TEST_ASSERT_EQ(tm.soft_limit_ms(), 60000 / DEFAULT_MOVES_TO_GO, "Clock is spread over the default moves to go");
+    TEST_ASSERT_EQ(tm.hard_limit_ms(), tm.soft_limit_ms() * HARD_LIMIT_SOFT_MULTIPLE, "Hard limit is a multiple of the soft limit");
+    int no_increment_soft = tm.soft_limit_ms();
+    limits.increment_ms = 1000;
+    tm.start_search(limits);
+    TEST_ASSERT(tm.soft_limit_ms() > no_increment_soft, "Increment adds to the budget");
+    limits.increment_ms = 0;
+    limits.moves_to_go = 1;
+    tm.start_search(limits);
+    TEST_ASSERT(tm.hard_limit_ms() < 60000 && tm.soft_limit_ms() <= tm.hard_limit_ms(), 
+                "Last move before the time control keeps a reserve");
+    limits.moves_to_go = 0;
+    
+    Move stable_move(Square::E2, Square::E4, MoveType::Normal);
+    Move other_move(Square::D2, Square::D4, MoveType::Normal);
+    tm.start_search(limits);
+    int base_soft = tm.soft_limit_ms();
+    for (int i = 1; i <= 5; i++) tm.stop_after_iteration(stable_move, 20, i);
+    TEST_ASSERT(tm.soft_limit_ms() < base_soft, "A stable best move shrinks the soft limit");
+    tm.stop_after_iteration(other_move, -80, 6);
+    TEST_ASSERT(tm.soft_limit_ms() > base_soft, "A best move change and score drop extend it");
+    
+    tm.start_search(limits);
+    tm.stop_after_iteration(stable_move, 0, 300);
+    TEST_ASSERT(!tm.stop_after_iteration(other_move, 0, 500), "Keeps iterating while the next depth fits");
+    tm.start_search(limits);
+    tm.stop_after_iteration(stable_move, 0, 300);
+    TEST_ASSERT(tm.stop_after_iteration(other_move, 0, 2700), "Stops when the next depth would overrun the hard limit");
+    
+    tm.start_search(0);
+    TEST_ASSERT(!tm.should_stop() && !tm.stop_after_iteration(stable_move, 0, 100000), "No limit without a time control");
+    limits.move_time_ms = 50;
+    tm.start_search(limits);
+    TEST_ASSERT_EQ(tm.hard_limit_ms(), 50, "Move time is a fixed deadline");
+    
+    Engine timed_engine;
+    timed_engine.set_max_depth(MAX_SEARCH_DEPTH);
+    SearchLimits clock;
+    clock.time_left_ms = 3000;
+    clock.increment_ms = 100;
+    pos.load_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    auto timed_start = std::chrono::steady_clock::now();
+    Move timed_move = timed_engine.find_best_move(pos, clock);
+    auto timed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - timed_start).count();
+    TEST_ASSERT(!timed_move.is_none(), "Clock search returns a move");
+    TEST_ASSERT(timed_ms < clock.time_left_ms, "Clock search stays within the remaining time");
+    
     std::cout << GREEN << "Performance tests completed" << RESET << std::endl;
 }
 
@@ -1422,12 +2084,12 @@ void ChessTests::test_edge_cases()
     
     // Debug stalemate position
     std::cout << "Debugging stalemate position:" << std::endl;
-    std::vector<Move> pseudo_legal;
+    MoveList pseudo_legal;
     MoveGenerator::generate_all_moves(pos, pseudo_legal, pos.side_to_move());
     std::cout << "Pseudo-legal moves: " << pseudo_legal.size() << std::endl;
     
     for (const Move& move : pseudo_legal) {
-        std::cout << "Move: " << square_to_string(move.from_square) << " to " << square_to_string(move.to_square) << std::endl;
+        std::cout << "Move: " << square_to_string(move.from_square()) << " to " << square_to_string(move.to_square()) << std::endl;
         
         // Make move on a copy
         Position test_pos = pos;
@@ -1508,6 +2170,23 @@ void ChessTests::test_regression_bugs()
     
     std::vector<Move> moves = pos.generate_legal_moves();
     TEST_ASSERT_EQ(moves.size(), 8, "4 knights in corners have 8 moves total");
+
+    // Mate scores used to count the game's moves instead of the search ply,
+    // so late in a game a mate fell outside the mate score range
+    print_subtest("Mate score after a long game");
+    pos.load_fen("6k1/5ppp/8/4n3/8/8/5PPP/R2N2K1 w - - 0 1");
+    for (int i = 0; i < 20; i++)
+    {
+        pos.make_move(Move(Square::D1, Square::E3, MoveType::Normal));
+        pos.make_move(Move(Square::E5, Square::C4, MoveType::Normal));
+        pos.make_move(Move(Square::E3, Square::D1, MoveType::Normal));
+        pos.make_move(Move(Square::C4, Square::E5, MoveType::Normal));
+    }
+    Engine mate_engine;
+    mate_engine.set_max_depth(3);
+    Move mate_move = mate_engine.find_best_move(pos, 0);
+    TEST_ASSERT_EQ(mate_move.to_string(), std::string("a1a8"), "Back rank mate found after 80 plies");
+    TEST_ASSERT_EQ(mate_engine.get_search_info().score, MATE_SCORE - 1, "Mate in one scores MATE_SCORE - 1");
     
     std::cout << GREEN << "All regression tests passed" << RESET << std::endl;
 }
@@ -1666,8 +2345,8 @@ void ChessTests::test_position_unmake_move()
         pos.undo_move();
         
         if (!positions_equal(pos, before)) {
-            std::cout << RED << "Failed on move: " << square_to_string(move.from_square) 
-                      << " to " << square_to_string(move.to_square) << RESET << std::endl;
+            std::cout << RED << "Failed on move: " << square_to_string(move.from_square()) 
+                      << " to " << square_to_string(move.to_square()) << RESET << std::endl;
             TEST_ASSERT(false, "Make/unmake failed to restore position");
         }
         tested++;
@@ -1688,9 +2367,446 @@ void ChessTests::test_position_unmake_move()
     pos.undo_move();
     TEST_ASSERT_EQ(pos.move_count(), 0, "History cleared after undo");
     
+    // Test 9: Incremental hash matches a full recomputation. Covers captures, 
+    // castling, en passant, promotions and castling-rights changes.
+    print_subtest("Incremental Zobrist hash");
+    int hash_mismatches = 0;
+    for (const char* fen : TEST_FENS) {
+        pos.load_fen(fen);
+        hash_mismatches += count_hash_mismatches(pos, 3);
+    }
+    TEST_ASSERT_EQ(hash_mismatches, 0, "Incremental hash matches hash_position at every node");
+    
+    print_subtest("Incremental material and piece-square score");
+    int psq_mismatches = 0;
+    for (const char* fen : TEST_FENS) {
+        pos.load_fen(fen);
+        psq_mismatches += count_psq_mismatches(pos, 3);
+    }
+    TEST_ASSERT_EQ(psq_mismatches, 0, "Incremental score and phase match a full recomputation at every node");
+    
+    pos.load_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    TEST_ASSERT(pos.psq_score() == Score(), "Starting position is balanced");
+    TEST_ASSERT_EQ(pos.game_phase(), MAX_PHASE, "Starting position is at full phase");
+    
+    // key_after is exact except for moves that change castling rights,
+    // move a castling rook or create an en passant square
+    print_subtest("Prefetch key estimate");
+    int key_after_mismatches = 0;
+    for (const char* fen : TEST_FENS) {
+        pos.load_fen(fen);
+        MoveList key_moves;
+        pos.generate_legal_moves(key_moves);
+        for (const Move& move : key_moves) {
+            uint8_t rights_before = pos.castling_rights();
+            uint64_t estimate = pos.key_after(move);
+            pos.make_move(move);
+            bool approximated = move.move_type() == MoveType::Castle || 
+                                pos.castling_rights() != rights_before ||
+                                pos.en_passant_square() != Square::None;
+            if (!approximated && estimate != pos.hash_key()) key_after_mismatches++;
+            pos.undo_move();
+        }
+    }
+    TEST_ASSERT_EQ(key_after_mismatches, 0, "key_after matches the child key for ordinary moves");
+    
+    // A null move flips the side and clears en passant; undoing it restores everything
+    print_subtest("Null move make/undo");
+    pos.load_fen("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 3");
+    std::string null_fen = pos.to_fen();
+    uint64_t null_key = pos.hash_key();
+    pos.make_null_move();
+    TEST_ASSERT(pos.side_to_move() == Color::White, "Null move passes the turn");
+    TEST_ASSERT(pos.en_passant_square() == Square::None, "Null move clears en passant");
+    TEST_ASSERT(pos.last_move().is_none(), "Null move is recorded as no move");
+    TEST_ASSERT_EQ(pos.hash_key(), luna::ZobristHash::hash_position(pos), "Null move hash is updated incrementally");
+    pos.undo_null_move();
+    TEST_ASSERT_EQ(pos.to_fen(), null_fen, "Undoing a null move restores the FEN");
+    TEST_ASSERT_EQ(pos.hash_key(), null_key, "Undoing a null move restores the hash");
+    
     std::cout << GREEN << "All unmake move tests passed" << RESET << std::endl;
 }
 
+void ChessTests::test_transposition_table()
+{
+    print_test_header("Testing Transposition Table");
+    
+    // Mate scores used to be truncated to 16 bits in the table
+    print_subtest("Transposition table entries");
+    TranspositionTable tt(1);
+    tt.new_search();
+    TEST_ASSERT_EQ(tt.hashfull(), 0, "Empty table reports hashfull 0");
+    
+    Move tt_move(Square::E2, Square::E4, MoveType::Normal);
+    tt.store(0x123456789ABCDEFULL, MATE_SCORE - 5, 7, BoundType::LOWER_BOUND, tt_move, 3);
+    
+    int tt_score = 0, tt_depth = 0;
+    BoundType tt_bound = BoundType::NONE;
+    Move probed_move;
+    TEST_ASSERT(tt.probe(0x123456789ABCDEFULL, tt_score, tt_depth, tt_bound, probed_move, 1),
+                "Stored key is found");
+    TEST_ASSERT_EQ(tt_score, MATE_SCORE - 3, "Mate score is rebased to the probing ply");
+    TEST_ASSERT_EQ(tt_depth, 7, "Depth round-trips");
+    TEST_ASSERT(tt_bound == BoundType::LOWER_BOUND, "Bound round-trips");
+    TEST_ASSERT(probed_move == tt_move, "Move round-trips");
+    TEST_ASSERT(!tt.probe(0x123456789ABCDEEULL, tt_score, tt_depth, tt_bound, probed_move, 0),
+                "Different key in the same cluster misses");
+    
+    // A shallower non-exact result for the same position does not overwrite
+    tt.store(0x123456789ABCDEFULL, 10, 2, BoundType::UPPER_BOUND, Move(), 0);
+    tt.probe(0x123456789ABCDEFULL, tt_score, tt_depth, tt_bound, probed_move, 0);
+    TEST_ASSERT_EQ(tt_depth, 7, "Deeper entry from this search is kept");
+    
+    // A later search replaces it and keeps the old move when given none
+    tt.new_search();
+    tt.store(0x123456789ABCDEFULL, 10, 2, BoundType::UPPER_BOUND, Move(), 0);
+    tt.probe(0x123456789ABCDEFULL, tt_score, tt_depth, tt_bound, probed_move, 0);
+    TEST_ASSERT_EQ(tt_depth, 2, "Entry from an older search is replaced");
+    TEST_ASSERT(probed_move == tt_move, "Best move survives a replacement without one");
+    
+    // Parallel clear and resize leave an empty, aligned table
+    tt.clear(4);
+    TEST_ASSERT(!tt.probe(0x123456789ABCDEFULL, tt_score, tt_depth, tt_bound, probed_move, 0),
+                "Cleared table misses");
+    tt.resize(8, 4);
+    TEST_ASSERT_EQ(tt.size_mb(), static_cast<size_t>(8), "Resized table reports its size");
+    TEST_ASSERT_EQ(tt.hashfull(), 0, "Resized table is empty");
+    
+    // A saved table loads back at its saved size, and bad files are rejected
+    tt.store(0x123456789ABCDEFULL, 42, 9, BoundType::EXACT, tt_move, 0);
+    const std::string hash_file = "luna_tt_test.bin";
+    TEST_ASSERT(tt.save(hash_file), "Table saves to a file");
+    
+    TranspositionTable loaded_tt(2);
+    TEST_ASSERT(loaded_tt.load(hash_file), "Saved table loads");
+    TEST_ASSERT_EQ(loaded_tt.size_mb(), static_cast<size_t>(8), "Loaded table takes the saved size");
+    TEST_ASSERT(loaded_tt.probe(0x123456789ABCDEFULL, tt_score, tt_depth, tt_bound, probed_move, 0) &&
+                tt_score == 42 && tt_depth == 9 && probed_move == tt_move, "Loaded table holds the saved entry");
+    
+    {
+        std::ofstream truncated(hash_file, std::ios::binary | std::ios::trunc);
+        truncated << "LUNATT";
+    }
+    TEST_ASSERT(!loaded_tt.load(hash_file), "Truncated hash file is rejected");
+    TEST_ASSERT(!loaded_tt.load("missing_luna_tt_test.bin"), "Missing hash file is rejected");
+    TEST_ASSERT_EQ(loaded_tt.size_mb(), static_cast<size_t>(8), "Rejected load leaves the table unchanged");
+    std::remove(hash_file.c_str());
+    
+    // A size that cannot be allocated leaves a usable minimum table
+    print_subtest("Failed resize");
+    TranspositionTable failed_tt(1);
+    bool resize_threw = false;
+    try {
+        failed_tt.resize(static_cast<size_t>(1) << 30);
+    } catch (const std::bad_alloc&) {
+        resize_threw = true;
+    }
+    TEST_ASSERT(resize_threw, "Oversized resize reports std::bad_alloc");
+    TEST_ASSERT_EQ(failed_tt.size_mb(), MIN_HASH_SIZE_MB, "Table falls back to the minimum size");
+    failed_tt.store(0x123456789ABCDEFULL, 42, 9, BoundType::EXACT, tt_move, 0);
+    TEST_ASSERT(failed_tt.probe(0x123456789ABCDEFULL, tt_score, tt_depth, tt_bound, probed_move, 0) && tt_score == 42,
+                "Fallback table stores and probes");
+    
+    // A search stopped partway through a node has not seen most of its
+    // moves, so it must not leave a bound for that node in the shared table
+    print_subtest("Stopped search stores nothing");
+    Position stop_pos;
+    stop_pos.load_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    luna::Evaluator stop_eval;
+    TranspositionTable stop_tt(1);
+    std::unique_ptr<Search> stopped = std::make_unique<Search>(&stop_eval, &stop_tt);
+    TimeManager expired;
+    expired.start_search(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    stopped->time_manager_ = &expired;
+    stopped->negamax(stop_pos, 6, -INFINITY_SCORE, INFINITY_SCORE, 0);
+    TEST_ASSERT(stopped->stop_search_, "Search stops on the expired deadline");
+    TEST_ASSERT(!stop_tt.probe(stop_pos.hash_key(), tt_score, tt_depth, tt_bound, probed_move, 0),
+                "No entry is stored for the stopped root");
+    
+    std::cout << GREEN << "All transposition table tests passed" << RESET << std::endl;
+}
+
+void ChessTests::test_evaluation_caches()
+{
+    print_test_header("Testing Evaluation Caches");
+    
+    Position pos;
+    
+    print_subtest("Pawn structure cache");
+    luna::Evaluator cached_eval;
+    int pawn_cache_mismatches = 0;
+    for (const char* fen : TEST_FENS) {
+        pos.load_fen(fen);
+        pawn_cache_mismatches += count_pawn_cache_mismatches(pos, 2, cached_eval);
+    }
+    TEST_ASSERT_EQ(pawn_cache_mismatches, 0, "Cached pawn terms match a cold evaluation at every node");
+    
+    print_subtest("Evaluation cache");
+    luna::Evaluator eval;
+    pos.load_fen(TEST_FENS[0]);
+    int first_eval = eval.evaluate(pos);
+    int second_eval = eval.evaluate(pos);
+    TEST_ASSERT_EQ(second_eval, first_eval, "Cached evaluation matches the computed one");
+    TEST_ASSERT(eval.cache_misses() == 1 && eval.cache_hits() == 1, "Second evaluation is a cache hit");
+    pos.make_move(Move(Square::E1, Square::F1, MoveType::Normal));
+    eval.evaluate(pos);
+    pos.undo_move();
+    TEST_ASSERT_EQ(eval.cache_misses(), static_cast<uint64_t>(2), "A different position misses");
+    eval.set_cache_size(0);
+    eval.reset_cache_stats();
+    TEST_ASSERT_EQ(eval.evaluate(pos), first_eval, "Evaluation is unchanged with the cache disabled");
+    TEST_ASSERT_EQ(eval.cache_hits(), static_cast<uint64_t>(0), "A disabled cache never hits");
+    
+    std::cout << GREEN << "All evaluation cache tests passed" << RESET << std::endl;
+}
+
+void ChessTests::test_batch_eval()
+{
+    print_test_header("Testing Batched Evaluation");
+    
+    Position pos;
+    luna::Evaluator eval;
+    
+    // An odd count leaves the last group of lanes partly empty
+    print_subtest("Batched evaluation");
+    std::vector<luna::BoardSnapshot> batch_boards;
+    std::vector<int> single_scores;
+    for (const char* fen : TEST_FENS) {
+        pos.load_fen(fen);
+        collect_boards(pos, 2, eval, batch_boards, single_scores, batch_boards.size() + 100);
+    }
+    pos.load_fen("8/8/4k3/8/8/3K4/8/8 b - - 0 1");
+    collect_boards(pos, 0, eval, batch_boards, single_scores, batch_boards.size() + 1);
+    std::vector<int> batch_scores(batch_boards.size());
+    luna::Evaluator batch_eval;
+    batch_eval.evaluate_batch(batch_boards.data(), batch_boards.size(), batch_scores.data());
+    int batch_mismatches = 0;
+    for (size_t i = 0; i < batch_boards.size(); i++) {
+        if (batch_scores[i] != single_scores[i]) batch_mismatches++;
+    }
+    TEST_ASSERT_EQ(batch_mismatches, 0, "Batched scores match one-at-a-time evaluation");
+    TEST_ASSERT_EQ(batch_eval.cache_hits() + batch_eval.cache_misses(), static_cast<uint64_t>(0), 
+                   "Batched evaluation bypasses the cache");
+    
+    int kernel_mismatches = 0;
+    for (size_t base = 0; base < batch_boards.size(); base += luna::BATCH_LANES) {
+        luna::BitboardLanes lanes;
+        luna::load_lanes(&batch_boards[base], std::min(luna::BATCH_LANES, batch_boards.size() - base), lanes);
+        int lane_scores[luna::BATCH_LANES], lane_ref[luna::BATCH_LANES];
+        luna::batch_kernels::mobility(lanes, lane_scores);
+        luna::batch_kernels::mobility_scalar(lanes, lane_ref);
+        if (!std::equal(lane_scores, lane_scores + luna::BATCH_LANES, lane_ref)) kernel_mismatches++;
+    }
+    TEST_ASSERT_EQ(kernel_mismatches, 0, 
+                   std::string("Mobility kernel matches scalar (") + luna::batch_kernels::instruction_set() + ")");
+    
+    std::cout << GREEN << "All batched evaluation tests passed" << RESET << std::endl;
+}
+
+void ChessTests::test_tuner()
+{
+    print_test_header("Testing Tuner");
+    
+    Position pos;
+    luna::Evaluator eval;
+    
+    // The tuner evaluates in floating point, so the integer taper can
+    // round differently by a point
+    print_subtest("Tuning features match the evaluator");
+    std::vector<double> tune_params = luna::default_tune_params();
+    luna::TuneFeatures tune_features;
+    int tune_mismatches = 0;
+    for (const char* fen : TEST_FENS) {
+        pos.load_fen(fen);
+        for (const Move& move : pos.generate_legal_moves()) {
+            pos.make_move(move);
+            luna::extract_features(luna::pack_position(pos, 0.5), tune_features);
+            int white_eval = pos.side_to_move() == Color::White ? eval.evaluate(pos) : -eval.evaluate(pos);
+            if (std::abs(tune_features.evaluate(tune_params) - white_eval) > 1.0) tune_mismatches++;
+            pos.undo_move();
+        }
+    }
+    TEST_ASSERT_EQ(tune_mismatches, 0, "Feature dot product equals the classical evaluation");
+    
+    print_subtest("Tuning data file");
+    std::string tune_path = "luna_test_positions.txt";
+    {
+        std::ofstream tune_file(tune_path, std::ios::trunc);
+        tune_file << "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1 [1.0]\n";
+        tune_file << "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 1/2-1/2\n";
+        tune_file << "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - c9 \"0-1\";\n";
+        tune_file << "8/8/4k3/8/8/3K4/8/8 w - - 0 1 [0.5]\n";
+        tune_file << "not a position 1-0\n";
+    }
+    luna::Tuner tuner(2);
+    TEST_ASSERT_EQ(tuner.load(tune_path), 3LL, "Labeled positions load and bad or bare-king lines are skipped");
+    TEST_ASSERT_EQ(tuner.load("missing_positions.txt"), -1LL, "Missing position file is reported");
+    std::remove(tune_path.c_str());
+    double tune_error = tuner.error(tune_params, 1.0);
+    for (int epoch = 0; epoch < 20; epoch++) tuner.train_epoch(tune_params, 1.0, 1.0);
+    TEST_ASSERT(tuner.error(tune_params, 1.0) < tune_error, "Training lowers the error");
+    
+    std::cout << GREEN << "All tuner tests passed" << RESET << std::endl;
+}
+
+void ChessTests::test_nnue()
+{
+    print_test_header("Testing NNUE Evaluation");
+    
+    Position pos;
+    
+    // Random weights; the scores mean nothing but exercise every layer
+    print_subtest("NNUE incremental accumulators");
+    luna::NnueNetwork network;
+    network.randomize(20250817);
+    luna::NnueEvaluator incremental(&network);
+    luna::NnueEvaluator refreshed(&network);
+    int nnue_mismatches = 0;
+    for (const char* fen : TEST_FENS) {
+        pos.load_fen(fen);
+        nnue_mismatches += count_nnue_mismatches(pos, 3, incremental, refreshed);
+    }
+    TEST_ASSERT_EQ(nnue_mismatches, 0, "Incremental accumulators match a full refresh at every node");
+    
+    print_subtest("NNUE kernels match scalar reference");
+    uint64_t kernel_seed = 0x2545F4914F6CDD1DULL;
+    auto kernel_random = [&kernel_seed]() {
+        kernel_seed ^= kernel_seed << 13;
+        kernel_seed ^= kernel_seed >> 7;
+        kernel_seed ^= kernel_seed << 17;
+        return kernel_seed;
+    };
+    int16_t relu_in[64];
+    uint8_t relu_out[64], relu_ref[64];
+    for (int16_t& v : relu_in) v = static_cast<int16_t>(static_cast<int>(kernel_random() % 1000) - 500);
+    luna::nnue_kernels::clipped_relu(relu_in, 64, relu_out);
+    luna::nnue_kernels::clipped_relu_scalar(relu_in, 64, relu_ref);
+    TEST_ASSERT(std::equal(relu_out, relu_out + 64, relu_ref), "Clipped ReLU matches scalar");
+    
+    uint8_t dense_in[512];
+    int8_t dense_weights[4 * 512];
+    int32_t dense_biases[4] = { 7, -3, 1000, -1000 };
+    int32_t dense_out[4], dense_ref[4];
+    for (uint8_t& v : dense_in) v = static_cast<uint8_t>(kernel_random() % 128);
+    for (int8_t& w : dense_weights) w = static_cast<int8_t>(static_cast<int>(kernel_random() % 255) - 127);
+    luna::nnue_kernels::dense(dense_in, 512, dense_weights, dense_biases, 4, dense_out);
+    luna::nnue_kernels::dense_scalar(dense_in, 512, dense_weights, dense_biases, 4, dense_ref);
+    TEST_ASSERT(std::equal(dense_out, dense_out + 4, dense_ref), 
+                std::string("Dense layer matches scalar (") + luna::nnue_kernels::instruction_set() + ")");
+    
+    print_subtest("NNUE network file");
+    std::string nnue_path = "luna_test_network.nnue";
+    TEST_ASSERT(network.save(nnue_path), "Network saves to a file");
+    luna::NnueNetwork loaded;
+    TEST_ASSERT(loaded.load(nnue_path), "Saved network loads");
+    luna::NnueEvaluator loaded_eval(&loaded);
+    pos.load_fen(TEST_FENS[1]);
+    refreshed.reset();
+    TEST_ASSERT_EQ(loaded_eval.evaluate(pos), refreshed.evaluate(pos), "Loaded network evaluates like the saved one");
+    {
+        std::ofstream truncate(nnue_path, std::ios::binary | std::ios::trunc);
+        truncate << "LUNANNUE";
+    }
+    TEST_ASSERT(!loaded.load(nnue_path), "Truncated network file is rejected");
+    TEST_ASSERT(!loaded.load("missing_network.nnue"), "Missing network file is rejected");
+    std::remove(nnue_path.c_str());
+    
+    print_subtest("Evaluator switches to NNUE");
+    luna::Evaluator switching;
+    pos.load_fen(TEST_FENS[2]);
+    int classical_score = switching.evaluate(pos);
+    switching.set_network(&network);
+    refreshed.reset();
+    TEST_ASSERT_EQ(switching.evaluate(pos), refreshed.evaluate(pos), "Evaluator uses the network once set");
+    int network_batch_score = 0;
+    luna::BoardSnapshot network_board = luna::snapshot_position(pos);
+    switching.evaluate_batch(&network_board, 1, &network_batch_score);
+    TEST_ASSERT_EQ(network_batch_score, refreshed.evaluate(pos), "Batched evaluation uses the network too");
+    switching.set_network(nullptr);
+    TEST_ASSERT_EQ(switching.evaluate(pos), classical_score, "Evaluator returns to the hand-written terms");
+    
+    std::cout << GREEN << "All NNUE tests passed" << RESET << std::endl;
+}
+
+void ChessTests::test_move_ordering()
+{
+    print_test_header("Testing Move Ordering");
+    
+    Position pos;
+    luna::Evaluator eval;
+    TranspositionTable tt(1);
+    std::unique_ptr<Search> search = std::make_unique<Search>(&eval, &tt);
+    
+    // Bonuses shrink as an entry saturates, so no run of them passes the bound
+    print_subtest("History gravity");
+    int entry = 0;
+    int max_entry = 0;
+    for (int i = 0; i < 100; i++) {
+        Search::apply_gravity(entry, HISTORY_MAX);
+        max_entry = std::max(max_entry, entry);
+    }
+    TEST_ASSERT(max_entry <= HISTORY_MAX, "Repeated bonuses stay within HISTORY_MAX");
+    int min_entry = entry;
+    for (int i = 0; i < 100; i++) {
+        Search::apply_gravity(entry, -HISTORY_MAX);
+        min_entry = std::min(min_entry, entry);
+    }
+    TEST_ASSERT(min_entry >= -HISTORY_MAX, "Repeated penalties stay within -HISTORY_MAX");
+    
+    pos.load_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    pos.make_move(Move(Square::E2, Square::E4, MoveType::Normal));
+    Move cutoff(Square::G8, Square::F6, MoveType::Normal);
+    Move tried[] = { Move(Square::B8, Square::C6, MoveType::Normal) };
+    for (int i = 0; i < 50; i++) {
+        search->update_quiet_stats(pos, cutoff, 1, 20, tried, 1);
+    }
+    int black = static_cast<int>(Color::Black);
+    int cutoff_history = search->history_[black][static_cast<int>(Square::G8)][static_cast<int>(Square::F6)];
+    int tried_history = search->history_[black][static_cast<int>(Square::B8)][static_cast<int>(Square::C6)];
+    int cutoff_continuation = (*search->continuation_row(pos))[static_cast<int>(Piece::BlackKnight)][static_cast<int>(Square::F6)];
+    TEST_ASSERT(cutoff_history > 0 && cutoff_history <= HISTORY_MAX, "Cutoff move history is positive and bounded");
+    TEST_ASSERT(tried_history < 0 && tried_history >= -HISTORY_MAX, "Moves tried before the cutoff are penalized and bounded");
+    TEST_ASSERT(cutoff_continuation > 0 && cutoff_continuation <= HISTORY_MAX, "Continuation history is bounded");
+    
+    // The refutation is recorded against the piece that moved and where it went
+    print_subtest("Countermoves");
+    Move refutation(Square::D7, Square::D5, MoveType::Normal);
+    search->update_quiet_stats(pos, refutation, 1, 3, nullptr, 0);
+    TEST_ASSERT(search->countermoves_[static_cast<int>(Piece::WhitePawn)][static_cast<int>(Square::E4)] == refutation,
+                "Cutoff records the countermove for the previous piece and square");
+    TEST_ASSERT(search->countermove(pos) == refutation, "Countermove is returned after the same move");
+    pos.undo_move();
+    pos.make_move(Move(Square::D2, Square::D4, MoveType::Normal));
+    TEST_ASSERT(search->countermove(pos).is_none(), "No countermove after a different move");
+    TEST_ASSERT(search->continuation_row(pos) != nullptr, "Continuation row exists after a move");
+    pos.make_null_move();
+    TEST_ASSERT(search->continuation_row(pos) == nullptr && search->countermove(pos).is_none(), 
+                "No continuation or countermove after a null move");
+    pos.undo_null_move();
+    
+    // Deep into a game, killers still go to the slot of the search ply
+    print_subtest("Killers by search ply");
+    pos.load_fen("4k3/8/8/8/8/8/8/R3K2N w - - 0 1");
+    for (int i = 0; i < 10; i++) {
+        pos.make_move(Move(Square::H1, Square::G3, MoveType::Normal));
+        pos.make_move(Move(Square::E8, Square::D8, MoveType::Normal));
+        pos.make_move(Move(Square::G3, Square::H1, MoveType::Normal));
+        pos.make_move(Move(Square::D8, Square::E8, MoveType::Normal));
+    }
+    Move killer(Square::A1, Square::A7, MoveType::Normal);
+    search->update_quiet_stats(pos, killer, 2, 4, nullptr, 0);
+    TEST_ASSERT(search->killer_moves_[2][0] == killer, "Killer is stored at the search ply");
+    TEST_ASSERT(search->killer_moves_[std::min(static_cast<int>(pos.move_count()), MAX_PLY - 1)][0].is_none(), 
+                "Killer is not stored at the game ply");
+    Move second_killer(Square::A1, Square::A6, MoveType::Normal);
+    search->update_quiet_stats(pos, second_killer, 2, 4, nullptr, 0);
+    TEST_ASSERT(search->killer_moves_[2][0] == second_killer && search->killer_moves_[2][1] == killer, 
+                "A new killer shifts the old one to the second slot");
+    
+    std::cout << GREEN << "All move ordering tests passed" << RESET << std::endl;
+}
+
 // Run all tests
 void ChessTests::run_all_tests()
 {
@@ -1725,6 +2841,14 @@ void ChessTests::run_all_tests()
         test_regression_bugs();
         test_game_scenarios();
         
+        // Engine component tests
+        test_transposition_table();
+        test_evaluation_caches();
+        test_batch_eval();
+        test_tuner();
+        test_nnue();
+        test_move_ordering();
+        
         // Performance tests (optional)
         if (true) {  // Set to true to run performance tests
             test_performance();
@@ -8,23 +8,97 @@
 
 #include "ChessEngine/include/time_manager.h"
 #include "ChessEngine/include/constants.h"
+#include <algorithm>
 
 namespace luna {
 
 TimeManager::TimeManager() 
-    : allocated_time_ms_(DEFAULT_SEARCH_TIME_MS) {}
+    : hard_limit_ms_(DEFAULT_SEARCH_TIME_MS), base_soft_limit_ms_(DEFAULT_SEARCH_TIME_MS),
+      soft_limit_ms_(DEFAULT_SEARCH_TIME_MS), adaptive_(false), last_score_(0), 
+      stable_iterations_(0), iterations_(0), last_iteration_end_ms_(0), last_iteration_ms_(0) {}
 
 void TimeManager::start_search(int time_ms) {
     start_time_ = std::chrono::steady_clock::now();
-    allocated_time_ms_ = time_ms;
+    hard_limit_ms_ = std::max(0, time_ms);
+    base_soft_limit_ms_ = hard_limit_ms_;
+    soft_limit_ms_ = hard_limit_ms_;
+    adaptive_ = false;
+
+    last_best_move_ = Move();
+    last_score_ = 0;
+    stable_iterations_ = 0;
+    iterations_ = 0;
+    last_iteration_end_ms_ = 0;
+    last_iteration_ms_ = 0;
+}
+
+void TimeManager::start_search(const SearchLimits& limits) {
+    if (limits.infinite) {
+        start_search(0);
+        return;
+    }
+    if (limits.move_time_ms > 0 || limits.time_left_ms <= 0) {
+        start_search(limits.move_time_ms);
+        return;
+    }
+
+    start_search(0);
+    adaptive_ = true;
+
+    // Spread the clock over the moves left in this time control and spend
+    // most of each increment as it comes
+    int available = std::max(1, limits.time_left_ms - MOVE_OVERHEAD_MS);
+    int moves_to_go = limits.moves_to_go > 0 ? std::min(limits.moves_to_go, MAX_MOVES_TO_GO) 
+                                             : DEFAULT_MOVES_TO_GO;
+    int soft = available / moves_to_go + limits.increment_ms * INCREMENT_USE_PERCENT / 100;
+
+    // The hard limit leaves room to finish an iteration the soft limit let
+    // start, but never risks the clock
+    int hard = std::min(soft * HARD_LIMIT_SOFT_MULTIPLE, available * HARD_LIMIT_MAX_PERCENT / 100);
+    hard_limit_ms_ = std::max(1, hard);
+    base_soft_limit_ms_ = std::max(1, std::min(soft, hard_limit_ms_));
+    soft_limit_ms_ = base_soft_limit_ms_;
 }
 
 bool TimeManager::should_stop() const {
-    auto current_time = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>
-        (current_time - start_time_).count();
-    
-    return elapsed >= allocated_time_ms_;
+    return hard_limit_ms_ > 0 && elapsed_ms() >= hard_limit_ms_;
+}
+
+bool TimeManager::stop_after_iteration(const Move& best_move, int score, int elapsed_ms) {
+    int iteration_ms = elapsed_ms - last_iteration_end_ms_;
+    int previous_iteration_ms = last_iteration_ms_;
+    last_iteration_end_ms_ = elapsed_ms;
+    last_iteration_ms_ = iteration_ms;
+
+    // Count how long the best move has held and how far the score fell
+    stable_iterations_ = (iterations_ > 0 && best_move == last_best_move_) ? stable_iterations_ + 1 : 0;
+    int score_drop = iterations_ > 0 ? last_score_ - score : 0;
+    last_best_move_ = best_move;
+    last_score_ = score;
+    iterations_++;
+
+    if (!adaptive_) return false;
+
+    // Settle sooner on a stable move; think longer after a flip or a drop
+    long long soft = static_cast<long long>(base_soft_limit_ms_) * 
+                     STABILITY_SCALE_PERCENT[std::min(stable_iterations_, 4)] / 100;
+    if (score_drop > 0) {
+        soft = soft * (100 + std::min(score_drop / SCORE_DROP_CP_PER_PERCENT, MAX_SCORE_DROP_PERCENT)) / 100;
+    }
+    soft_limit_ms_ = static_cast<int>(std::min<long long>(soft, hard_limit_ms_));
+
+    if (elapsed_ms >= soft_limit_ms_) return true;
+
+    // An unfinished iteration is thrown away, so do not start one that is
+    // expected to run past the hard limit. Each depth takes a roughly
+    // constant multiple of the one before.
+    int growth = DEFAULT_ITERATION_GROWTH_PERCENT;
+    if (previous_iteration_ms > 0) {
+        growth = std::clamp(iteration_ms * 100 / previous_iteration_ms, 
+                            MIN_ITERATION_GROWTH_PERCENT, MAX_ITERATION_GROWTH_PERCENT);
+    }
+    long long predicted = static_cast<long long>(iteration_ms) * growth / 100;
+    return elapsed_ms + predicted > hard_limit_ms_;
 }
 
 int TimeManager::elapsed_ms() const {
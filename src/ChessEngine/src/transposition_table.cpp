@@ -8,109 +8,465 @@
 
 #include "transposition_table.h"
 #include "constants.h"
+#include "zobrist.h"
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <new>
+#include <thread>
+#include <vector>
 
-namespace luna 
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#include <xmmintrin.h>
+#endif
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LUNA_TT_MMAP 1
+#endif
+
+namespace luna
+{
+
+namespace
+{
+
+// High 64 bits of a 64x64-bit product. Maps a key uniformly onto
+// [0, count) without a divide.
+inline uint64_t mul_hi64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128;
+    return static_cast<uint64_t>((static_cast<uint128>(a) * b) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return __umulh(a, b);
+#else
+    uint64_t a_lo = a & 0xFFFFFFFFULL, a_hi = a >> 32;
+    uint64_t b_lo = b & 0xFFFFFFFFULL, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFULL) + lo_hi;
+    return a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+#endif
+}
+
+constexpr size_t LARGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Run fn(begin, end) over [0, count) split into chunks of at least 2 MB of
+// clusters, using up to the given number of threads
+template<typename Fn>
+void for_cluster_ranges(size_t count, int threads, Fn fn)
+{
+    // Small tables are not worth starting threads for
+    size_t min_clusters_per_thread = LARGE_PAGE_SIZE / sizeof(TTCluster);
+    size_t max_threads = std::max<size_t>(1, count / min_clusters_per_thread);
+    size_t thread_count = std::min<size_t>(std::max(threads, 1), max_threads);
+    size_t chunk = (count + thread_count - 1) / thread_count;
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < thread_count; t++)
+    {
+        size_t begin = std::min(count, t * chunk);
+        size_t end = std::min(count, begin + chunk);
+        workers.emplace_back(fn, begin, end);
+    }
+    fn(0, std::min(count, chunk));
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// Saved table file header. Padded to one cluster so the clusters that
+// follow it keep their alignment in a mapped file.
+struct TTFileHeader
+{
+    char magic[8];              // "LUNATT" and two zero bytes
+    uint32_t version;           // TT_FILE_VERSION
+    uint32_t byte_order;        // TT_FILE_BYTE_ORDER as written by the saving machine
+    uint32_t entry_size;        // sizeof(TTEntry)
+    uint32_t cluster_size;      // TT_CLUSTER_SIZE
+    uint64_t cluster_count;     // Number of clusters that follow
+    uint64_t zobrist_seed;      // ZobristHash::SEED
+    uint8_t age;                // Table generation when saved
+    uint8_t padding[23];
+};
+
+static_assert(sizeof(TTFileHeader) == sizeof(TTCluster), "TT file header must fill one cluster");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "TT entries are saved as raw words");
+
+constexpr char TT_FILE_MAGIC[8] = { 'L', 'U', 'N', 'A', 'T', 'T', 0, 0 };
+constexpr uint32_t TT_FILE_VERSION = 1;
+constexpr uint32_t TT_FILE_BYTE_ORDER = 0x01020304;
+
+// Whether a header was written by this build's table format
+bool header_matches_format(const TTFileHeader& header)
 {
+    return std::memcmp(header.magic, TT_FILE_MAGIC, sizeof(TT_FILE_MAGIC)) == 0 &&
+           header.version == TT_FILE_VERSION &&
+           header.byte_order == TT_FILE_BYTE_ORDER &&
+           header.entry_size == sizeof(TTEntry) &&
+           header.cluster_size == TT_CLUSTER_SIZE &&
+           header.zobrist_seed == ZobristHash::SEED &&
+           header.cluster_count > 0;
+}
+
+// Whether the file holds exactly the clusters the header announces
+bool file_size_matches(const TTFileHeader& header, size_t file_size)
+{
+    size_t payload = file_size - sizeof(TTFileHeader);
+    return file_size >= sizeof(TTFileHeader) && payload % sizeof(TTCluster) == 0 &&
+           payload / sizeof(TTCluster) == header.cluster_count;
+}
+
+} // namespace
 
-TranspositionTable::TranspositionTable(size_t size_mb) : current_age_(0) 
+void TTMemoryDeleter::operator()(TTCluster* clusters) const
 {
-    resize(size_mb);
+#if defined(_MSC_VER)
+    _aligned_free(clusters);
+#else
+    std::free(clusters);
+#endif
 }
 
-void TranspositionTable::resize(size_t size_mb) {
-    // Calculate number of entries
+uint64_t TTEntry::pack(const Move& move, int score, int depth, BoundType bound, uint8_t age)
+{
+    return static_cast<uint64_t>(move.raw())
+         | (static_cast<uint64_t>(static_cast<uint32_t>(score)) << 16)
+         | (static_cast<uint64_t>(static_cast<uint8_t>(static_cast<int8_t>(depth))) << 48)
+         | (static_cast<uint64_t>(bound) << 56)
+         | (static_cast<uint64_t>(age) << 58);
+}
+
+TranspositionTable::TranspositionTable(size_t size_mb, int threads)
+    : clusters_(&fallback_cluster_), cluster_count_(1), current_age_(0), prefetch_enabled_(true)
+{
+    resize(size_mb, threads);
+}
+
+void TranspositionTable::resize(size_t size_mb, int threads) {
+    // Calculate number of clusters
     size_t bytes = size_mb * 1024 * 1024;
-    table_size_ = bytes / sizeof(TTEntry);
-    
-    // Resize and clear the table
-    table_.resize(table_size_);
-    clear();
+    resize_clusters(std::max<size_t>(1, bytes / sizeof(TTCluster)), threads);
 }
 
-void TranspositionTable::clear() 
+void TranspositionTable::resize_clusters(size_t cluster_count, int threads)
 {
-    std::fill(table_.begin(), table_.end(), TTEntry());
+    // Release the old table first so both never have to fit in memory at once
+    clusters_ = &fallback_cluster_;
+    cluster_count_ = 1;
+    table_.reset();
+
+    table_.reset(allocate(cluster_count));
+
+    if (!table_)
+    {
+        // Keep a usable minimum table, or the single built-in cluster if
+        // even that cannot be allocated, and report the failure
+        cluster_count = MIN_HASH_SIZE_MB * 1024 * 1024 / sizeof(TTCluster);
+        table_.reset(allocate(cluster_count));
+        if (table_)
+        {
+            clusters_ = table_.get();
+            cluster_count_ = cluster_count;
+        }
+        clear(threads);
+        throw std::bad_alloc();
+    }
+
+    clusters_ = table_.get();
+    cluster_count_ = cluster_count;
+
+    // Allocated memory is uninitialized; clearing constructs every entry
+    clear(threads);
 }
 
-void TranspositionTable::store(uint64_t key, int score, int depth, BoundType bound, 
-                              const Move& best_move, int ply) 
+TTCluster* TranspositionTable::allocate(size_t cluster_count)
 {
-    size_t index = get_index(key);
-    TTEntry& entry = table_[index];
-    
+    // Sizes whose byte count would wrap around cannot be allocated
+    if (cluster_count > (SIZE_MAX - LARGE_PAGE_SIZE) / sizeof(TTCluster)) return nullptr;
+    size_t bytes = cluster_count * sizeof(TTCluster);
+
+    // Align large tables to the huge page size so the kernel can back them
+    // with 2 MB pages, cutting TLB misses on random probes
+    size_t alignment = bytes >= LARGE_PAGE_SIZE ? LARGE_PAGE_SIZE : alignof(TTCluster);
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+
+#if defined(_MSC_VER)
+    void* memory = _aligned_malloc(bytes, alignment);
+#else
+    void* memory = std::aligned_alloc(alignment, bytes);
+#endif
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (memory && alignment == LARGE_PAGE_SIZE) madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+
+    return static_cast<TTCluster*>(memory);
+}
+
+void TranspositionTable::clear(int threads)
+{
+    TTCluster* clusters = clusters_;
+
+    // Constructing a cluster empties it; clusters are trivially destructible,
+    // so this is also how a used table is cleared
+    for_cluster_ranges(cluster_count_, threads, [clusters](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) new (&clusters[i]) TTCluster();
+    });
+}
+
+bool TranspositionTable::save(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    TTFileHeader header = {};
+    std::memcpy(header.magic, TT_FILE_MAGIC, sizeof(TT_FILE_MAGIC));
+    header.version = TT_FILE_VERSION;
+    header.byte_order = TT_FILE_BYTE_ORDER;
+    header.entry_size = sizeof(TTEntry);
+    header.cluster_size = TT_CLUSTER_SIZE;
+    header.cluster_count = cluster_count_;
+    header.zobrist_seed = ZobristHash::SEED;
+    header.age = current_age_;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(clusters_),
+               static_cast<std::streamsize>(cluster_count_ * sizeof(TTCluster)));
+    return static_cast<bool>(file);
+}
+
+bool TranspositionTable::load(const std::string& path, int threads)
+{
+#if defined(LUNA_TT_MMAP)
+    // Map the file read-only and copy the clusters out in parallel. The
+    // table itself stays in anonymous (huge page advised) memory, since a
+    // mapping of the file would fault in a private copy of every page the
+    // search writes to.
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TTFileHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t file_size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    const TTFileHeader* header = static_cast<const TTFileHeader*>(mapping);
+    bool valid = header_matches_format(*header) && file_size_matches(*header, file_size);
+
+    if (valid)
+    {
+        ::madvise(mapping, file_size, MADV_SEQUENTIAL);
+
+        try
+        {
+            resize_clusters(header->cluster_count, threads);
+        }
+        catch (const std::bad_alloc&)
+        {
+            ::munmap(mapping, file_size);
+            throw;
+        }
+        current_age_ = header->age;
+
+        const TTCluster* saved = reinterpret_cast<const TTCluster*>(header + 1);
+        TTCluster* clusters = clusters_;
+        for_cluster_ranges(cluster_count_, threads, [clusters, saved](size_t begin, size_t end) {
+            std::memcpy(static_cast<void*>(clusters + begin), saved + begin, (end - begin) * sizeof(TTCluster));
+        });
+    }
+
+    ::munmap(mapping, file_size);
+    return valid;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+
+    size_t file_size = static_cast<size_t>(file.tellg());
+    TTFileHeader header = {};
+    file.seekg(0);
+    if (file_size < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        return false;
+    }
+
+    if (!header_matches_format(header) || !file_size_matches(header, file_size))
+    {
+        return false;
+    }
+
+    resize_clusters(header.cluster_count, threads);
+    current_age_ = header.age;
+
+    file.read(reinterpret_cast<char*>(clusters_),
+              static_cast<std::streamsize>(cluster_count_ * sizeof(TTCluster)));
+    return static_cast<bool>(file);
+#endif
+}
+
+void TranspositionTable::store(uint64_t key, int score, int depth, BoundType bound,
+                              const Move& best_move, int ply)
+{
+    TTCluster& cluster = cluster_for(key);
+
     // Adjust mate scores for storage
     int store_score = score;
-    if (score > MATE_SCORE - MAX_PLY) 
+    if (score > MATE_SCORE - MAX_PLY)
     {
         store_score += ply;
-    } 
-    else if (score < -MATE_SCORE + MAX_PLY) 
+    }
+    else if (score < -MATE_SCORE + MAX_PLY)
     {
         store_score -= ply;
     }
-    
-    // Check if we should replace this entry
-    if (!entry.is_valid() || should_replace(entry, depth, current_age_)) 
+
+    // Reuse the entry already holding this position, otherwise replace the
+    // shallowest / oldest entry in the cluster
+    TTEntry* replace = &cluster.entries[0];
+    uint64_t replace_data = replace->data.load(std::memory_order_relaxed);
+    bool same_position = false;
+
+    for (TTEntry& entry : cluster.entries)
+    {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.key_xor_data.load(std::memory_order_relaxed);
+
+        if (data == 0 || (check ^ data) == key)
+        {
+            replace = &entry;
+            replace_data = data;
+            same_position = (data != 0);
+            break;
+        }
+
+        if (replacement_value(data) < replacement_value(replace_data))
+        {
+            replace = &entry;
+            replace_data = data;
+        }
+    }
+
+    Move move = best_move;
+    if (same_position)
     {
-        entry.key = key;
-        entry.score = static_cast<int16_t>(store_score);
-        entry.depth = static_cast<int16_t>(depth);
-        entry.bound_type = static_cast<uint8_t>(bound);
-        entry.age = current_age_;
-        entry.best_move = best_move;
+        // Keep a deeper result for the same position from this search,
+        // unless the new one is exact
+        if (TTEntry::age_of(replace_data) == current_age_ && bound != BoundType::EXACT &&
+            depth < TTEntry::depth_of(replace_data))
+        {
+            return;
+        }
+
+        // Keep the old best move if this search produced none
+        if (move.is_none()) move = TTEntry::move_of(replace_data);
     }
+
+    uint64_t data = TTEntry::pack(move, store_score, depth, bound, current_age_);
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->key_xor_data.store(key ^ data, std::memory_order_relaxed);
 }
 
-bool TranspositionTable::probe(uint64_t key, int& score, int& depth, BoundType& bound, 
-                              Move& best_move, int ply) const 
-{
-    size_t index = get_index(key);
-    const TTEntry& entry = table_[index];
-    
-    // Check if entry is valid and keys match
-    if (!entry.is_valid() || entry.key != key) return false;
-    
-    // Extract values
-    score = entry.score;
-    depth = entry.depth;
-    bound = static_cast<BoundType>(entry.bound_type);
-    best_move = entry.best_move;
-    
-    // Adjust mate scores for current ply (make them relative to current position)
-    if (score > MATE_SCORE - MAX_PLY) 
-    {
-        score -= ply;
-    } 
-    else if (score < -MATE_SCORE + MAX_PLY) 
+bool TranspositionTable::probe(uint64_t key, int& score, int& depth, BoundType& bound,
+                              Move& best_move, int ply) const
+{
+    const TTCluster& cluster = cluster_for(key);
+
+    for (const TTEntry& entry : cluster.entries)
     {
-        score += ply;
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        uint64_t check = entry.key_xor_data.load(std::memory_order_relaxed);
+
+        // Empty entries and torn or foreign writes fail the key check
+        if (data == 0 || (check ^ data) != key) continue;
+
+        // Extract values
+        score = TTEntry::score_of(data);
+        depth = TTEntry::depth_of(data);
+        bound = TTEntry::bound_of(data);
+        best_move = TTEntry::move_of(data);
+
+        // Adjust mate scores for current ply (make them relative to current position)
+        if (score > MATE_SCORE - MAX_PLY)
+        {
+            score -= ply;
+        }
+        else if (score < -MATE_SCORE + MAX_PLY)
+        {
+            score += ply;
+        }
+
+        return true;
     }
-    
-    return true;
+
+    return false;
 }
 
-size_t TranspositionTable::size_mb() const 
+void TranspositionTable::prefetch(uint64_t key) const
 {
-    return (table_.size() * sizeof(TTEntry)) / (1024 * 1024);
+    if (!prefetch_enabled_) return;
+
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(&cluster_for(key));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    _mm_prefetch(reinterpret_cast<const char*>(&cluster_for(key)), _MM_HINT_T0);
+#else
+    (void)key;
+#endif
 }
 
-size_t TranspositionTable::get_index(uint64_t key) const 
+size_t TranspositionTable::size_mb() const
 {
-    return key % table_size_;
+    return (cluster_count_ * sizeof(TTCluster)) / (1024 * 1024);
 }
 
-bool TranspositionTable::should_replace(const TTEntry& existing, int new_depth, uint8_t new_age) const 
+int TranspositionTable::hashfull() const
 {
-    // Always replace invalid entries
-    if (!existing.is_valid()) return true;
-     
-    // Replace if the new entry is from a more recent search
-    if (new_age != existing.age) return true;
-    
-    // Replace if the new entry has greater or equal depth
-    return new_depth >= existing.depth;
+    // Sample the first thousand clusters (or all of a smaller table)
+    size_t sample = std::min<size_t>(cluster_count_, 1000);
+    size_t used = 0;
+    if (sample == 0) return 0;
+
+    for (size_t i = 0; i < sample; i++)
+    {
+        for (const TTEntry& entry : clusters_[i].entries)
+        {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+            if (data != 0 && TTEntry::age_of(data) == current_age_) used++;
+        }
+    }
+
+    return static_cast<int>(used * 1000 / (sample * TT_CLUSTER_SIZE));
+}
+
+TTCluster& TranspositionTable::cluster_for(uint64_t key) const
+{
+    return clusters_[mul_hi64(key, cluster_count_)];
+}
+
+int TranspositionTable::replacement_value(uint64_t data) const
+{
+    // Empty entries are replaced first
+    if (data == 0) return -TT_AGE_CYCLE * 8;
+
+    // Each search generation of age costs the entry as much as 8 plies of depth
+    int relative_age = (TT_AGE_CYCLE + current_age_ - TTEntry::age_of(data)) % TT_AGE_CYCLE;
+    return TTEntry::depth_of(data) - 8 * relative_age;
 }
 
 } // namespace luna
@@ -0,0 +1,534 @@
+/*
+    Implementation of the evaluation tuner: position packing, feature
+    extraction mirroring Evaluator, and the sigmoid error and its gradient.
+
+    Author: Nicolas Miller
+    Date: 08/24/2025
+*/
+
+#include "tuner.h"
+#include "constants.h"
+#include "position.h"
+#include "psqt.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+namespace luna {
+
+namespace {
+
+constexpr double ADAM_BETA1 = 0.9;
+constexpr double ADAM_BETA2 = 0.999;
+constexpr double ADAM_EPSILON = 1e-8;
+
+// D4, E4, D5 and E5
+constexpr uint64_t CENTER_SQUARES = (1ULL << 27) | (1ULL << 28) | (1ULL << 35) | (1ULL << 36);
+
+int mirror(int sq) { return (7 - sq / 8) * 8 + sq % 8; }
+
+double sigmoid(double eval, double k)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -k * eval / 400.0));
+}
+
+// Split [0, count) into one contiguous range per thread and run
+// work(begin, end, thread) on each
+template <typename Work>
+void run_parallel(int threads, size_t count, Work work)
+{
+    size_t thread_count = std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(threads), count));
+    size_t chunk = (count + thread_count - 1) / std::max<size_t>(thread_count, 1);
+
+    std::vector<std::thread> helpers;
+    for (size_t t = 1; t < thread_count; t++)
+    {
+        helpers.emplace_back(work, std::min(count, t * chunk), std::min(count, (t + 1) * chunk), t);
+    }
+    work(0, std::min(count, chunk), 0);
+    for (std::thread& helper : helpers)
+    {
+        helper.join();
+    }
+}
+
+// Result in half points, or -1 if the line has none
+int parse_result(const std::string& line)
+{
+    size_t bracket = line.find('[');
+    if (bracket != std::string::npos)
+    {
+        double value = std::atof(line.c_str() + bracket + 1);
+        if (value == 1.0) return 2;
+        if (value == 0.5) return 1;
+        if (value == 0.0) return 0;
+        return -1;
+    }
+
+    if (line.find("1/2-1/2") != std::string::npos) return 1;
+    if (line.find("1-0") != std::string::npos) return 2;
+    if (line.find("0-1") != std::string::npos) return 0;
+    return -1;
+}
+
+bool parse_line(const std::string& line, Position& pos, double& result)
+{
+    int half_points = parse_result(line);
+    if (half_points < 0) return false;
+
+    // Board, side, castling and en passant, then the clocks if present
+    std::istringstream ss(line);
+    std::string fields[6];
+    if (!(ss >> fields[0] >> fields[1] >> fields[2] >> fields[3])) return false;
+    ss >> fields[4] >> fields[5];
+
+    auto is_number = [](const std::string& field)
+    {
+        return !field.empty() &&
+               std::all_of(field.begin(), field.end(), [](unsigned char ch) { return std::isdigit(ch) != 0; });
+    };
+    bool clocks = is_number(fields[4]) && is_number(fields[5]);
+    std::string fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3] +
+                      (clocks ? " " + fields[4] + " " + fields[5] : " 0 1");
+    if (!pos.load_fen(fen)) return false;
+
+    // Need both kings and at most 32 pieces to pack; a bare-kings position
+    // evaluates to 0 whatever the weights
+    if (pos.pieces(Color::White, PieceType::King).count_bits() != 1 ||
+        pos.pieces(Color::Black, PieceType::King).count_bits() != 1 ||
+        pos.occupied().count_bits() == 2 || pos.occupied().count_bits() > 32)
+    {
+        return false;
+    }
+
+    result = half_points / 2.0;
+    return true;
+}
+
+} // namespace
+
+PackedPosition pack_position(const Position& pos, double result)
+{
+    PackedPosition packed = {};
+    packed.occupied = pos.occupied().value();
+    packed.castling_rights = pos.castling_rights();
+    packed.result = static_cast<uint8_t>(std::lround(result * 2.0));
+
+    Bitboard occupied = pos.occupied();
+    for (int n = 0; occupied.any(); n++)
+    {
+        Square sq = static_cast<Square>(occupied.pop_lsb());
+        packed.pieces[n / 2] |= static_cast<uint8_t>(static_cast<int>(pos.piece_on(sq)) << (4 * (n % 2)));
+    }
+    return packed;
+}
+
+// Every term below mirrors the matching Evaluator function; the
+// coefficient of a weight is how many times the evaluation adds it
+void extract_features(const PackedPosition& packed, TuneFeatures& features)
+{
+    features.count = 0;
+    auto add = [&features](int index, double coefficient)
+    {
+        if (coefficient == 0.0) return;
+        features.index[features.count] = static_cast<uint16_t>(index);
+        features.coefficient[features.count] = coefficient;
+        features.count++;
+    };
+
+    // Unpack the pieces, summing the game phase on the way
+    Bitboard pieces[2][6];
+    Square squares[32];
+    Piece piece_list[32];
+    int piece_count = 0;
+    int phase = 0;
+
+    Bitboard occupied(packed.occupied);
+    Bitboard remaining = occupied;
+    while (remaining.any())
+    {
+        Square sq = static_cast<Square>(remaining.pop_lsb());
+        Piece piece = static_cast<Piece>((packed.pieces[piece_count / 2] >> (4 * (piece_count % 2))) & 0xF);
+        pieces[static_cast<int>(color_of(piece))][static_cast<int>(type_of(piece))].set_bit(sq);
+        phase += PieceSquareTable::phase(piece);
+        squares[piece_count] = sq;
+        piece_list[piece_count] = piece;
+        piece_count++;
+    }
+    phase = std::min(phase, MAX_PHASE);
+
+    // Material and piece-square terms; only the king tables are tapered
+    for (int n = 0; n < piece_count; n++)
+    {
+        Color color = color_of(piece_list[n]);
+        int type = static_cast<int>(type_of(piece_list[n]));
+        double sign = (color == Color::White) ? 1.0 : -1.0;
+        int sq = (color == Color::White) ? static_cast<int>(squares[n]) : mirror(static_cast<int>(squares[n]));
+
+        if (type == static_cast<int>(PieceType::King))
+        {
+            add(TUNE_KING_MG + sq, sign * phase / MAX_PHASE);
+            add(TUNE_KING_EG + sq, sign * (MAX_PHASE - phase) / MAX_PHASE);
+        }
+        else
+        {
+            add(TUNE_MATERIAL + type, sign);
+            add(TUNE_PST + type * 64 + sq, sign);
+        }
+    }
+
+    int doubled = 0, isolated = 0, passed = 0, bishop_pair = 0, seventh = 0, open_file = 0;
+    int shield = 0, castling = 0, mobility = 0, center = 0;
+
+    for (Color us : { Color::White, Color::Black })
+    {
+        Color them = (us == Color::White) ? Color::Black : Color::White;
+        int c = static_cast<int>(us);
+        int sign = (us == Color::White) ? 1 : -1;
+        Bitboard our_pawns = pieces[c][static_cast<int>(PieceType::Pawn)];
+        Bitboard their_pawns = pieces[static_cast<int>(them)][static_cast<int>(PieceType::Pawn)];
+        Bitboard all_pawns = our_pawns | their_pawns;
+        Bitboard own = Bitboard();
+        for (int pt = 0; pt < 6; pt++) own |= pieces[c][pt];
+
+        // Pawn structure
+        Bitboard pawns = our_pawns;
+        while (pawns.any())
+        {
+            Square sq = static_cast<Square>(pawns.pop_lsb());
+            File file = file_of(sq);
+            if ((our_pawns & Bitboard(file)).count_bits() > 1) doubled += sign;
+            if ((our_pawns & Bitboard::adjacent_files(file)).empty()) isolated += sign;
+            if ((their_pawns & Bitboard::passed_pawn_span(us, sq)).empty())
+            {
+                int rank = static_cast<int>(rank_of(sq));
+                passed += sign * (us == Color::White ? rank : 7 - rank);
+            }
+        }
+
+        // King safety: castling rights and pawns in front of a back rank king
+        int rights = (us == Color::White)
+            ? (1 << static_cast<int>(CastlingRights::White_OO)) | (1 << static_cast<int>(CastlingRights::White_OOO))
+            : (1 << static_cast<int>(CastlingRights::Black_OO)) | (1 << static_cast<int>(CastlingRights::Black_OOO));
+        if (packed.castling_rights & rights) castling += sign;
+
+        Square king = static_cast<Square>(pieces[c][static_cast<int>(PieceType::King)].get_lsb_index());
+        Rank back_rank = (us == Color::White) ? Rank::One : Rank::Eight;
+        Rank shield_rank = (us == Color::White) ? Rank::Two : Rank::Seven;
+        if (rank_of(king) == back_rank)
+        {
+            int king_file = static_cast<int>(file_of(king));
+            for (int f = std::max(0, king_file - 1); f <= std::min(7, king_file + 1); f++)
+            {
+                if (our_pawns.is_bit_set(make_square(static_cast<File>(f), shield_rank))) shield += sign;
+            }
+        }
+
+        // Mobility and center occupancy
+        Bitboard knights = pieces[c][static_cast<int>(PieceType::Knight)];
+        while (knights.any())
+        {
+            Square sq = static_cast<Square>(knights.pop_lsb());
+            mobility += sign * (Bitboard::knight_attacks(sq) & ~own).count_bits();
+        }
+        Bitboard bishops = pieces[c][static_cast<int>(PieceType::Bishop)];
+        while (bishops.any())
+        {
+            Square sq = static_cast<Square>(bishops.pop_lsb());
+            mobility += sign * (Bitboard::bishop_attacks(sq, occupied) & ~own).count_bits();
+        }
+        Bitboard rooks = pieces[c][static_cast<int>(PieceType::Rook)];
+        while (rooks.any())
+        {
+            Square sq = static_cast<Square>(rooks.pop_lsb());
+            mobility += sign * (Bitboard::rook_attacks(sq, occupied) & ~own).count_bits();
+            if (rank_of(sq) == (us == Color::White ? Rank::Seven : Rank::Two)) seventh += sign;
+            if ((all_pawns & Bitboard(file_of(sq))).empty()) open_file += sign;
+        }
+        center += sign * (own & Bitboard(CENTER_SQUARES)).count_bits();
+
+        if (pieces[c][static_cast<int>(PieceType::Bishop)].count_bits() >= 2) bishop_pair += sign;
+    }
+
+    // Penalties are subtracted
+    add(TUNE_DOUBLED_PAWN, -doubled);
+    add(TUNE_ISOLATED_PAWN, -isolated);
+    add(TUNE_PASSED_PAWN, passed);
+    add(TUNE_BISHOP_PAIR, bishop_pair);
+    add(TUNE_ROOK_ON_SEVENTH, seventh);
+    add(TUNE_ROOK_ON_OPEN_FILE, open_file);
+    add(TUNE_KING_PAWN_SHIELD, shield);
+    add(TUNE_CASTLING_RIGHTS, castling);
+    add(TUNE_MOBILITY, mobility);
+    add(TUNE_CENTER_CONTROL, center);
+}
+
+std::vector<double> default_tune_params()
+{
+    PieceSquareTable::initialize();
+    std::vector<double> params(TUNE_PARAM_COUNT, 0.0);
+
+    // The combined tables hold material plus placement; white's entries
+    // are unmirrored
+    for (int pt = 0; pt < 5; pt++)
+    {
+        params[TUNE_MATERIAL + pt] = PIECE_VALUES[pt];
+        Piece piece = make_piece(Color::White, static_cast<PieceType>(pt));
+        for (int sq = 0; sq < 64; sq++)
+        {
+            params[TUNE_PST + pt * 64 + sq] = PieceSquareTable::value(piece, static_cast<Square>(sq)).mg - PIECE_VALUES[pt];
+        }
+    }
+    for (int sq = 0; sq < 64; sq++)
+    {
+        Score king = PieceSquareTable::value(Piece::WhiteKing, static_cast<Square>(sq));
+        params[TUNE_KING_MG + sq] = king.mg;
+        params[TUNE_KING_EG + sq] = king.eg;
+    }
+
+    params[TUNE_DOUBLED_PAWN] = DOUBLED_PAWN_PENALTY;
+    params[TUNE_ISOLATED_PAWN] = ISOLATED_PAWN_PENALTY;
+    params[TUNE_PASSED_PAWN] = PASSED_PAWN_BONUS;
+    params[TUNE_BISHOP_PAIR] = BISHOP_PAIR_BONUS;
+    params[TUNE_ROOK_ON_SEVENTH] = ROOK_ON_SEVENTH_BONUS;
+    params[TUNE_ROOK_ON_OPEN_FILE] = ROOK_ON_OPEN_FILE_BONUS;
+    params[TUNE_KING_PAWN_SHIELD] = KING_PAWN_SHIELD_BONUS;
+    params[TUNE_CASTLING_RIGHTS] = CASTLING_RIGHTS_BONUS;
+    params[TUNE_MOBILITY] = MOBILITY_SCORE_MULTIPLIER;
+    params[TUNE_CENTER_CONTROL] = CENTER_CONTROL_BONUS;
+    return params;
+}
+
+Tuner::Tuner(int threads)
+    : threads_(std::max(1, threads)), momentum_(TUNE_PARAM_COUNT, 0.0),
+      velocity_(TUNE_PARAM_COUNT, 0.0), step_(0)
+{
+    // Feature extraction reads these tables from every thread
+    Bitboard::init_attack_tables();
+    PieceSquareTable::initialize();
+}
+
+long long Tuner::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return -1;
+
+    file.seekg(0, std::ios::end);
+    std::string text(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0, std::ios::beg);
+    if (!file.read(&text[0], static_cast<std::streamsize>(text.size()))) return -1;
+
+    std::vector<size_t> line_starts;
+    line_starts.push_back(0);
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        if (text[i] == '\n') line_starts.push_back(i + 1);
+    }
+    line_starts.push_back(text.size() + 1);
+
+    // Parse ranges of lines on each thread, then append them in file order
+    size_t line_count = line_starts.size() - 1;
+    std::vector<std::vector<PackedPosition>> parsed(static_cast<size_t>(threads_));
+    run_parallel(threads_, line_count, [&](size_t begin, size_t end, size_t thread)
+    {
+        std::unique_ptr<Position> pos(new Position());
+        double result;
+        for (size_t i = begin; i < end; i++)
+        {
+            std::string line = text.substr(line_starts[i], line_starts[i + 1] - 1 - line_starts[i]);
+            if (parse_line(line, *pos, result)) parsed[thread].push_back(pack_position(*pos, result));
+        }
+    });
+
+    size_t before = positions_.size();
+    for (const std::vector<PackedPosition>& part : parsed)
+    {
+        positions_.insert(positions_.end(), part.begin(), part.end());
+    }
+    return static_cast<long long>(positions_.size() - before);
+}
+
+void Tuner::add(const Position& pos, double result)
+{
+    positions_.push_back(pack_position(pos, result));
+}
+
+double Tuner::accumulate(const std::vector<double>& params, double k, std::vector<double>* gradient) const
+{
+    std::vector<double> errors(static_cast<size_t>(threads_), 0.0);
+    std::vector<std::vector<double>> gradients(gradient ? static_cast<size_t>(threads_) : 0,
+                                               std::vector<double>(TUNE_PARAM_COUNT, 0.0));
+    const double slope = k * std::log(10.0) / 400.0;
+
+    run_parallel(threads_, positions_.size(), [&](size_t begin, size_t end, size_t thread)
+    {
+        std::unique_ptr<TuneFeatures> features(new TuneFeatures());
+        double error = 0.0;
+        for (size_t i = begin; i < end; i++)
+        {
+            extract_features(positions_[i], *features);
+            double result = positions_[i].result / 2.0;
+            double predicted = sigmoid(features->evaluate(params), k);
+            double delta = result - predicted;
+            error += delta * delta;
+
+            if (gradient)
+            {
+                // d(error)/d(weight) = -2 * delta * sigmoid' * coefficient
+                double scale = -2.0 * delta * predicted * (1.0 - predicted) * slope;
+                std::vector<double>& local = gradients[thread];
+                for (int f = 0; f < features->count; f++)
+                {
+                    local[features->index[f]] += scale * features->coefficient[f];
+                }
+            }
+        }
+        errors[thread] = error;
+    });
+
+    double total = 0.0;
+    for (double e : errors) total += e;
+
+    double n = static_cast<double>(std::max<size_t>(positions_.size(), 1));
+    if (gradient)
+    {
+        gradient->assign(TUNE_PARAM_COUNT, 0.0);
+        for (const std::vector<double>& local : gradients)
+        {
+            for (int p = 0; p < TUNE_PARAM_COUNT; p++) (*gradient)[p] += local[p] / n;
+        }
+    }
+    return total / n;
+}
+
+double Tuner::error(const std::vector<double>& params, double k) const
+{
+    return accumulate(params, k, nullptr);
+}
+
+double Tuner::fit_k(const std::vector<double>& params) const
+{
+    // Golden section search; the error is unimodal in k
+    const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+    double lo = 0.05, hi = 4.0;
+    double a = hi - ratio * (hi - lo), b = lo + ratio * (hi - lo);
+    double error_a = error(params, a), error_b = error(params, b);
+
+    for (int i = 0; i < 30; i++)
+    {
+        if (error_a < error_b)
+        {
+            hi = b;
+            b = a;
+            error_b = error_a;
+            a = hi - ratio * (hi - lo);
+            error_a = error(params, a);
+        }
+        else
+        {
+            lo = a;
+            a = b;
+            error_a = error_b;
+            b = lo + ratio * (hi - lo);
+            error_b = error(params, b);
+        }
+    }
+    return (lo + hi) / 2.0;
+}
+
+double Tuner::train_epoch(std::vector<double>& params, double k, double learning_rate)
+{
+    std::vector<double> gradient;
+    double current = accumulate(params, k, &gradient);
+
+    step_++;
+    double correction1 = 1.0 - std::pow(ADAM_BETA1, step_);
+    double correction2 = 1.0 - std::pow(ADAM_BETA2, step_);
+    for (int p = 0; p < TUNE_PARAM_COUNT; p++)
+    {
+        momentum_[p] = ADAM_BETA1 * momentum_[p] + (1.0 - ADAM_BETA1) * gradient[p];
+        velocity_[p] = ADAM_BETA2 * velocity_[p] + (1.0 - ADAM_BETA2) * gradient[p] * gradient[p];
+        double m = momentum_[p] / correction1;
+        double v = velocity_[p] / correction2;
+        params[p] -= learning_rate * m / (std::sqrt(v) + ADAM_EPSILON);
+    }
+    return current;
+}
+
+bool Tuner::write_header(const std::string& path, const std::vector<double>& params,
+                         const std::string& comment)
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) return false;
+
+    auto value = [&params](int index) { return static_cast<int>(std::lround(params[index])); };
+    auto write_table = [&](const char* name, int offset)
+    {
+        out << "constexpr int " << name << "[64] = \n{\n";
+        for (int row = 0; row < 8; row++)
+        {
+            out << "    ";
+            for (int col = 0; col < 8; col++)
+            {
+                char cell[8];
+                std::snprintf(cell, sizeof(cell), "%3d", value(offset + row * 8 + col));
+                out << cell << (row * 8 + col < 63 ? "," : "");
+            }
+            out << "\n";
+        }
+        out << "};\n\n";
+    };
+
+    out << "/*\n"
+        << "    Evaluation weights generated by luna-tune.\n"
+        << "    " << comment << "\n\n"
+        << "    Copy the values into constants.h and the tables into psqt.cpp.\n"
+        << "*/\n\n"
+        << "#ifndef CHESS_ENGINE_TUNED_PARAMS_H\n"
+        << "#define CHESS_ENGINE_TUNED_PARAMS_H\n\n"
+        << "namespace luna {\n"
+        << "namespace tuned {\n\n";
+
+    const char* material_names[5] = { "PAWN_VALUE", "KNIGHT_VALUE", "BISHOP_VALUE", "ROOK_VALUE", "QUEEN_VALUE" };
+    for (int pt = 0; pt < 5; pt++)
+    {
+        out << "constexpr int " << material_names[pt] << " = " << value(TUNE_MATERIAL + pt) << ";\n";
+    }
+    out << "\n";
+
+    const std::pair<const char*, int> scalars[] = {
+        { "DOUBLED_PAWN_PENALTY", TUNE_DOUBLED_PAWN },
+        { "ISOLATED_PAWN_PENALTY", TUNE_ISOLATED_PAWN },
+        { "PASSED_PAWN_BONUS", TUNE_PASSED_PAWN },
+        { "BISHOP_PAIR_BONUS", TUNE_BISHOP_PAIR },
+        { "ROOK_ON_SEVENTH_BONUS", TUNE_ROOK_ON_SEVENTH },
+        { "ROOK_ON_OPEN_FILE_BONUS", TUNE_ROOK_ON_OPEN_FILE },
+        { "KING_PAWN_SHIELD_BONUS", TUNE_KING_PAWN_SHIELD },
+        { "CASTLING_RIGHTS_BONUS", TUNE_CASTLING_RIGHTS },
+        { "MOBILITY_SCORE_MULTIPLIER", TUNE_MOBILITY },
+        { "CENTER_CONTROL_BONUS", TUNE_CENTER_CONTROL }
+    };
+    for (const auto& scalar : scalars)
+    {
+        out << "constexpr int " << scalar.first << " = " << value(scalar.second) << ";\n";
+    }
+    out << "\n";
+
+    const char* table_names[5] = { "pawn_table", "knight_table", "bishop_table", "rook_table", "queen_table" };
+    for (int pt = 0; pt < 5; pt++) write_table(table_names[pt], TUNE_PST + pt * 64);
+    write_table("king_middlegame_table", TUNE_KING_MG);
+    write_table("king_endgame_table", TUNE_KING_EG);
+
+    out << "} // namespace tuned\n"
+        << "} // namespace luna\n\n"
+        << "#endif // CHESS_ENGINE_TUNED_PARAMS_H\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace luna
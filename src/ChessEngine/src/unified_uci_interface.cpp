@@ -6,14 +6,47 @@
 */
 
 #include "unified_uci_interface.h"
+#include "perft.h"
+#include "nnue.h"
 #include <iostream>
 #include <chrono>
 #include <algorithm>
 #include <cctype>
+#include <new>
+#include <stdexcept>
 
 namespace luna 
 {
 
+namespace 
+{
+
+// Parse the value of a spin option, clamped to [min, max] as the GUI was
+// told. Returns false if the value is not a whole number.
+bool parse_spin(const std::string& value, long long min, long long max, long long& result) 
+{
+    try 
+    {
+        size_t used = 0;
+        long long number = std::stoll(value, &used);
+        if (used != value.size()) return false;
+        result = std::clamp(number, min, max);
+        return true;
+    } 
+    catch (const std::out_of_range&) 
+    {
+        // A number too long for long long is past one of the bounds
+        result = value[0] == '-' ? min : max;
+        return true;
+    } 
+    catch (const std::invalid_argument&) 
+    {
+        return false;
+    }
+}
+
+} // namespace
+
 UnifiedUCIInterface::UnifiedUCIInterface() 
     : engine_(std::make_unique<Engine>()),
       searching_(false),
@@ -117,6 +150,14 @@ void UnifiedUCIInterface::run()
             {
                 handle_listrules();
             }
+            else if (command == "savehash") 
+            {
+                handle_savehash(line);
+            }
+            else if (command == "loadhash") 
+            {
+                handle_loadhash(line);
+            }
         }
         // Ignore unknown commands per UCI protocol
     }
@@ -179,6 +220,9 @@ void UnifiedUCIInterface::handle_ucinewgame()
     
     // Reset position to starting position
     current_position_ = Position();
+    
+    // Results from the previous game should not leak into this one
+    engine_->clear_hash();
 }
 
 void UnifiedUCIInterface::handle_position(const std::string& command) 
@@ -237,7 +281,7 @@ void UnifiedUCIInterface::handle_position(const std::string& command)
         while (idx < tokens.size()) 
         {
             Move move = parse_move(tokens[idx], current_position_);
-            if (move.from_square == Square::None) 
+            if (move.is_none()) 
             {
                 send_info_string("Invalid move: " + tokens[idx]);
                 break;
@@ -264,7 +308,7 @@ void UnifiedUCIInterface::handle_go(const std::string& command)
     std::vector<std::string> tokens = split_string(command);
     
     // Parse go parameters
-    int wtime = 0, btime = 0;
+    int wtime = 0, btime = 0, winc = 0, binc = 0, movestogo = 0;
     int depth = 0, movetime = 0;
     bool infinite = false;
     
@@ -281,6 +325,18 @@ void UnifiedUCIInterface::handle_go(const std::string& command)
         {
             btime = std::stoi(tokens[++i]);
         } 
+        else if (tokens[i] == "winc" && i + 1 < tokens.size()) 
+        {
+            winc = std::stoi(tokens[++i]);
+        } 
+        else if (tokens[i] == "binc" && i + 1 < tokens.size()) 
+        {
+            binc = std::stoi(tokens[++i]);
+        } 
+        else if (tokens[i] == "movestogo" && i + 1 < tokens.size()) 
+        {
+            movestogo = std::stoi(tokens[++i]);
+        } 
         else if (tokens[i] == "depth" && i + 1 < tokens.size()) 
         {
             depth = std::stoi(tokens[++i]);
@@ -291,31 +347,23 @@ void UnifiedUCIInterface::handle_go(const std::string& command)
         }
     }
     
-    // Calculate time for this move
-    int search_time = 0;
-    if (movetime > 0) 
-    {
-        search_time = movetime;
-    } 
-    else if (!infinite) 
-    {
-        // Use 1/20 of remaining time by default
-        int time_left = (current_position_.side_to_move() == Color::White) ? wtime : btime;
-        if (time_left > 0) 
-        {
-            search_time = time_left / 20;
-            search_time = std::min(search_time, 5000); // Don't use more than 5 seconds per move
-        }
-    }
+    // The time manager budgets the move from our side of the clock
+    bool white = current_position_.side_to_move() == Color::White;
+    SearchLimits limits;
+    limits.time_left_ms = white ? wtime : btime;
+    limits.increment_ms = white ? winc : binc;
+    limits.moves_to_go = movestogo;
+    limits.move_time_ms = movetime;
+    limits.infinite = infinite;
     
     // Set depth if specified
     if (depth > 0) 
     {
         engine_->set_max_depth(depth);
         // If no time was specified but depth was, give enough time to complete the search
-        if (search_time == 0 && !infinite) 
+        if (movetime == 0 && limits.time_left_ms <= 0 && !infinite) 
         {
-            search_time = 60000; // 60 seconds should be enough for most depths
+            limits.move_time_ms = 60000; // 60 seconds should be enough for most depths
         }
     }
     
@@ -329,7 +377,7 @@ void UnifiedUCIInterface::handle_go(const std::string& command)
     stop_search_ = false;
     searching_ = true;
     
-    search_thread_ = std::thread([this, search_time, infinite]() {
+    search_thread_ = std::thread([this, limits]() {
         try 
         {
             auto start_time = std::chrono::steady_clock::now();
@@ -337,9 +385,8 @@ void UnifiedUCIInterface::handle_go(const std::string& command)
             // Create position with rule engine modifications if in UCI+ mode
             Position search_position = current_position_;
             
-            // Call find_best_move with time limit
-            Move best_move = engine_->find_best_move(search_position, 
-                                                     infinite ? 0 : search_time);
+            // Call find_best_move with the time control
+            Move best_move = engine_->find_best_move(search_position, limits);
             
             // Get search information
             const Search::SearchInfo& info = engine_->get_search_info();
@@ -349,7 +396,7 @@ void UnifiedUCIInterface::handle_go(const std::string& command)
             
             // Send info line with actual search data
             std::vector<Move> pv = info.pv;
-            if (pv.empty() && best_move.from_square != Square::None) 
+            if (pv.empty() && !best_move.is_none()) 
             {
                 pv.push_back(best_move);
             }
@@ -377,6 +424,7 @@ void UnifiedUCIInterface::handle_go_extended(const std::string& command)
     bool has_perft = false;
     bool has_analyze = false;
     int perft_depth = 0;
+    int perft_threads = 1;
     
     for (size_t i = 1; i < tokens.size(); i++) 
     {
@@ -385,6 +433,10 @@ void UnifiedUCIInterface::handle_go_extended(const std::string& command)
             has_perft = true;
             perft_depth = std::stoi(tokens[++i]);
         } 
+        else if (tokens[i] == "threads" && i + 1 < tokens.size()) 
+        {
+            perft_threads = std::stoi(tokens[++i]);
+        } 
         else if (tokens[i] == "analyze") 
         {
             has_analyze = true;
@@ -393,9 +445,13 @@ void UnifiedUCIInterface::handle_go_extended(const std::string& command)
     
     if (has_perft) 
     {
-        // Run perft test
+        // Run perft on the current position and print the divide
         send_info_string("Running perft " + std::to_string(perft_depth));
-        // TODO: Implement perft with rule engine
+        Perft perft(PERFT_HASH_SIZE_MB);
+        Perft::Result result = perft.run(current_position_, perft_depth, perft_threads);
+        Perft::print_result(std::cout, result);
+        std::cout << "info nodes " << result.nodes << " time " << result.time_ms 
+                  << " nps " << result.nps << std::endl;
         return;
     }
     
@@ -424,9 +480,32 @@ void UnifiedUCIInterface::handle_setoption(const std::string& command)
 {
     std::vector<std::string> tokens = split_string(command);
     
-    if (tokens.size() < 5) return; // Need at least: setoption name <name> value <value>
+    if (tokens.size() < 3 || tokens[1] != "name") return;
+    
+    // Buttons have no value
+    if (command.find(" value ") == std::string::npos) 
+    {
+        std::string button;
+        for (size_t i = 2; i < tokens.size(); i++) 
+        {
+            if (!button.empty()) button += " ";
+            button += tokens[i];
+        }
+        
+        if (button == "Clear Hash") 
+        {
+            if (searching_) 
+            {
+                send_info_string("Cannot clear Hash while searching");
+                return;
+            }
+            if (search_thread_.joinable()) search_thread_.join();
+            engine_->clear_hash();
+        }
+        return;
+    }
     
-    if (tokens[1] != "name") return;
+    if (tokens.size() < 5) return; // Need at least: setoption name <name> value <value>
     
     // Find where "value" appears
     size_t value_idx = 0;
@@ -452,6 +531,129 @@ void UnifiedUCIInterface::handle_setoption(const std::string& command)
     // Get value
     std::string value = tokens[value_idx + 1];
     
+    // Threads rebuilds the search threads, so it waits for an idle engine
+    if (option_name == "Threads") 
+    {
+        if (searching_) 
+        {
+            send_info_string("Cannot change Threads while searching");
+            return;
+        }
+        if (search_thread_.joinable()) search_thread_.join();
+        long long threads = 0;
+        if (!parse_spin(value, 1, MAX_SEARCH_THREADS, threads)) 
+        {
+            send_info_string("Invalid Threads value " + value);
+            return;
+        }
+        try 
+        {
+            engine_->set_threads(static_cast<int>(threads));
+        } 
+        catch (const std::bad_alloc&) 
+        {
+            send_info_string("Could not allocate eval caches for " + std::to_string(threads) + 
+                             " threads, eval cache disabled");
+        }
+        return;
+    }
+    
+    // Hash reallocates the shared table, so it also waits for an idle engine
+    if (option_name == "Hash") 
+    {
+        if (searching_) 
+        {
+            send_info_string("Cannot change Hash while searching");
+            return;
+        }
+        if (search_thread_.joinable()) search_thread_.join();
+        long long size_mb = 0;
+        if (!parse_spin(value, static_cast<long long>(MIN_HASH_SIZE_MB), static_cast<long long>(MAX_HASH_SIZE_MB), size_mb)) 
+        {
+            send_info_string("Invalid Hash value " + value);
+            return;
+        }
+        try 
+        {
+            engine_->set_hash_size(static_cast<size_t>(size_mb));
+        } 
+        catch (const std::bad_alloc&) 
+        {
+            send_info_string("Could not allocate " + std::to_string(size_mb) + " MB hash, using " + 
+                             std::to_string(engine_->hash_size()) + " MB");
+        }
+        return;
+    }
+    
+    // The network is shared by the search threads, so it is swapped only
+    // while idle. "<empty>" switches back to the hand-written evaluation.
+    if (option_name == "EvalFile") 
+    {
+        if (searching_) 
+        {
+            send_info_string("Cannot change EvalFile while searching");
+            return;
+        }
+        if (search_thread_.joinable()) search_thread_.join();
+        
+        // Paths may contain spaces
+        std::string path = value;
+        for (size_t i = value_idx + 2; i < tokens.size(); i++) path += " " + tokens[i];
+        if (path == "<empty>") path.clear();
+        
+        if (!engine_->set_eval_file(path)) 
+        {
+            send_info_string("Could not load network " + path + ", keeping the current evaluation");
+        } 
+        else if (!path.empty()) 
+        {
+            send_info_string("Using NNUE network " + path + " (" + nnue_kernels::instruction_set() + ")");
+        }
+        return;
+    }
+    
+    // Each thread's evaluator owns an eval cache, resized only while idle
+    if (option_name == "EvalCache") 
+    {
+        if (searching_) 
+        {
+            send_info_string("Cannot change EvalCache while searching");
+            return;
+        }
+        if (search_thread_.joinable()) search_thread_.join();
+        long long size_mb = 0;
+        if (!parse_spin(value, 0, static_cast<long long>(MAX_EVAL_CACHE_MB), size_mb)) 
+        {
+            send_info_string("Invalid EvalCache value " + value);
+            return;
+        }
+        try 
+        {
+            engine_->set_eval_cache_size(static_cast<size_t>(size_mb));
+        } 
+        catch (const std::bad_alloc&) 
+        {
+            send_info_string("Could not allocate " + std::to_string(size_mb) + 
+                             " MB eval cache per thread, eval cache disabled");
+        }
+        return;
+    }
+    
+    // Pruning switches are read by the search threads, so they wait too
+    if (option_name == "NullMove" || option_name == "LMR") 
+    {
+        if (searching_) 
+        {
+            send_info_string("Cannot change " + option_name + " while searching");
+            return;
+        }
+        if (search_thread_.joinable()) search_thread_.join();
+        bool enabled = value == "true";
+        if (option_name == "NullMove") engine_->set_null_move(enabled);
+        else engine_->set_lmr(enabled);
+        return;
+    }
+    
     // Handle UCI+ specific options
     if (option_name == "Variant" && uci_plus_mode_) handle_variant("variant " + value);
 }
@@ -566,6 +768,72 @@ void UnifiedUCIInterface::handle_listrules()
     send_info_string("Available rules: king_of_the_hill");
 }
 
+void UnifiedUCIInterface::handle_savehash(const std::string& command) 
+{
+    if (!uci_plus_mode_) return;
+    
+    // The file name is the rest of the line, so it may contain spaces
+    std::string path = command.substr(std::string("savehash").size());
+    path.erase(0, path.find_first_not_of(" \t"));
+    if (path.empty()) 
+    {
+        send_info_string("Error: savehash requires a file name");
+        return;
+    }
+    
+    if (searching_) 
+    {
+        send_info_string("Cannot save hash while searching");
+        return;
+    }
+    if (search_thread_.joinable()) search_thread_.join();
+    
+    if (engine_->save_hash(path)) 
+    {
+        send_info_string("Saved " + std::to_string(engine_->hash_size()) + " MB hash to " + path);
+    } 
+    else 
+    {
+        send_info_string("Error: could not write hash file " + path);
+    }
+}
+
+void UnifiedUCIInterface::handle_loadhash(const std::string& command) 
+{
+    if (!uci_plus_mode_) return;
+    
+    std::string path = command.substr(std::string("loadhash").size());
+    path.erase(0, path.find_first_not_of(" \t"));
+    if (path.empty()) 
+    {
+        send_info_string("Error: loadhash requires a file name");
+        return;
+    }
+    
+    if (searching_) 
+    {
+        send_info_string("Cannot load hash while searching");
+        return;
+    }
+    if (search_thread_.joinable()) search_thread_.join();
+    
+    try 
+    {
+        if (engine_->load_hash(path)) 
+        {
+            send_info_string("Loaded " + std::to_string(engine_->hash_size()) + " MB hash from " + path);
+        } 
+        else 
+        {
+            send_info_string("Error: " + path + " is missing or not a compatible hash file");
+        }
+    } 
+    catch (const std::bad_alloc&) 
+    {
+        send_info_string("Error: not enough memory for the hash in " + path);
+    }
+}
+
 // Output functions
 void UnifiedUCIInterface::send_id() 
 {
@@ -575,7 +843,16 @@ void UnifiedUCIInterface::send_id()
 
 void UnifiedUCIInterface::send_options() 
 {
-    // Currently no standard UCI options
+    std::cout << "option name Hash type spin default " << DEFAULT_HASH_SIZE_MB 
+              << " min " << MIN_HASH_SIZE_MB << " max " << MAX_HASH_SIZE_MB << std::endl;
+    std::cout << "option name Clear Hash type button" << std::endl;
+    std::cout << "option name Threads type spin default " << DEFAULT_SEARCH_THREADS 
+              << " min 1 max " << MAX_SEARCH_THREADS << std::endl;
+    std::cout << "option name EvalFile type string default <empty>" << std::endl;
+    std::cout << "option name EvalCache type spin default " << DEFAULT_EVAL_CACHE_MB 
+              << " min 0 max " << MAX_EVAL_CACHE_MB << std::endl;
+    std::cout << "option name NullMove type check default true" << std::endl;
+    std::cout << "option name LMR type check default true" << std::endl;
 }
 
 void UnifiedUCIInterface::send_bestmove(const Move& move) 
@@ -583,7 +860,7 @@ void UnifiedUCIInterface::send_bestmove(const Move& move)
     std::cout << "bestmove " << move.to_string() << std::endl;
 }
 
-void UnifiedUCIInterface::send_info(int depth, int score, int nodes, int time_ms, 
+void UnifiedUCIInterface::send_info(int depth, int score, uint64_t nodes, int time_ms, 
                               const std::vector<Move>& pv) 
 {
     std::cout << "info";
@@ -591,6 +868,7 @@ void UnifiedUCIInterface::send_info(int depth, int score, int nodes, int time_ms
     std::cout << " score cp " << score;
     std::cout << " nodes " << nodes;
     std::cout << " time " << time_ms;
+    if (time_ms > 0) std::cout << " nps " << (nodes * 1000) / static_cast<uint64_t>(time_ms);
     std::cout << " pv";
     for (const Move& move : pv) 
     {
@@ -657,11 +935,11 @@ Move UnifiedUCIInterface::parse_move(const std::string& move_str, const Position
         
     for (const Move& move : legal_moves) 
     {
-        if (move.from_square == from && move.to_square == to) 
+        if (move.from_square() == from && move.to_square() == to) 
         {
-            if (move.move_type == MoveType::Promotion) 
+            if (move.move_type() == MoveType::Promotion) 
             {
-                if (move.promotion_piece == promotion_piece) 
+                if (move.promotion_piece() == promotion_piece) 
                 {
                     return move;
                 }
@@ -692,7 +970,7 @@ bool UnifiedUCIInterface::is_uci_plus_command(const std::string& command) const
 {
     static const std::vector<std::string> uci_plus_commands = 
     {
-        "uciplus", "variant", "listvariants", "setrule", "listrules"
+        "uciplus", "variant", "listvariants", "setrule", "listrules", "savehash", "loadhash"
     };
     
     return std::find(uci_plus_commands.begin(), uci_plus_commands.end(), command) != uci_plus_commands.end();
@@ -27,7 +27,7 @@ void ZobristHash::initialize()
     if (initialized_) return;
     
     // Use a fixed seed for reproducible hashes across runs
-    std::mt19937_64 rng(0x1234567890ABCDEFULL);
+    std::mt19937_64 rng(SEED);
     
     // Initialize piece keys
     for (int square = 0; square < 64; ++square) 
@@ -91,112 +91,18 @@ uint64_t ZobristHash::hash_position(const Position& pos)
     return hash;
 }
 
-uint64_t ZobristHash::update_hash_make_move(uint64_t current_hash, const Position& pos, const Move& move) 
+uint64_t ZobristHash::hash_pawns(const Position& pos)
 {
     assert(initialized_);
-    
-    uint64_t hash = current_hash;
-    
-    // Always flip side to move
-    hash ^= side_to_move_key_;
-    
-    // Get the moving piece
-    Piece moving_piece = pos.piece_on(move.from_square);
-    assert(moving_piece != Piece::None);
-    
-    // Remove piece from source square
-    hash ^= piece_keys_[static_cast<int>(move.from_square)][piece_index(moving_piece)];
-    
-    // Handle different move types
-    switch (move.move_type) 
+
+    uint64_t hash = 0;
+    for (int square = 0; square < 64; ++square) 
     {
-        case MoveType::Normal:
-            // Add piece to destination square
-            hash ^= piece_keys_[static_cast<int>(move.to_square)][piece_index(moving_piece)];
-            break;
-            
-        case MoveType::Capture:
-            // Remove captured piece
-            if (move.captured_piece != Piece::None) 
-            {
-                hash ^= piece_keys_[static_cast<int>(move.to_square)][piece_index(move.captured_piece)];
-            }
-            // Add moving piece to destination
-            hash ^= piece_keys_[static_cast<int>(move.to_square)][piece_index(moving_piece)];
-            break;
-            
-        case MoveType::Castle:
-            // Add king to destination
-            hash ^= piece_keys_[static_cast<int>(move.to_square)][piece_index(moving_piece)];
-            
-            // Handle rook movement for castling
-            if (move.to_square == Square::G1) 
-            {   // White kingside
-                hash ^= piece_keys_[static_cast<int>(Square::H1)][piece_index(Piece::WhiteRook)];
-                hash ^= piece_keys_[static_cast<int>(Square::F1)][piece_index(Piece::WhiteRook)];
-            } 
-            else if (move.to_square == Square::C1) 
-            {   // White queenside
-                hash ^= piece_keys_[static_cast<int>(Square::A1)][piece_index(Piece::WhiteRook)];
-                hash ^= piece_keys_[static_cast<int>(Square::D1)][piece_index(Piece::WhiteRook)];
-            } 
-            else if (move.to_square == Square::G8) 
-            {   // Black kingside
-                hash ^= piece_keys_[static_cast<int>(Square::H8)][piece_index(Piece::BlackRook)];
-                hash ^= piece_keys_[static_cast<int>(Square::F8)][piece_index(Piece::BlackRook)];
-            } 
-            else if (move.to_square == Square::C8) 
-            {   // Black queenside
-                hash ^= piece_keys_[static_cast<int>(Square::A8)][piece_index(Piece::BlackRook)];
-                hash ^= piece_keys_[static_cast<int>(Square::D8)][piece_index(Piece::BlackRook)];
-            }
-            break;
-            
-        case MoveType::EnPassant:
-        {
-            // Add pawn to destination
-            hash ^= piece_keys_[static_cast<int>(move.to_square)][piece_index(moving_piece)];
-            
-            // Remove captured pawn (not on destination square)
-            Square captured_square;
-            if (pos.side_to_move() == Color::White) 
-            {
-                captured_square = static_cast<Square>(static_cast<int>(move.to_square) - 8);
-            } 
-            else 
-            {
-                captured_square = static_cast<Square>(static_cast<int>(move.to_square) + 8);
-            }
-            Piece captured_pawn = (pos.side_to_move() == Color::White) ? Piece::BlackPawn : Piece::WhitePawn;
-            hash ^= piece_keys_[static_cast<int>(captured_square)][piece_index(captured_pawn)];
-            break;
-        }
-            
-        case MoveType::Promotion:
+        Piece piece = pos.piece_on(static_cast<Square>(square));
+        if (piece != Piece::None && type_of(piece) == PieceType::Pawn) 
         {
-            // Add promoted piece to destination
-            hash ^= piece_keys_[static_cast<int>(move.to_square)][piece_index(move.promotion_piece)];
-            
-            // Remove captured piece if it's a capture promotion
-            if (move.captured_piece != Piece::None) 
-            {
-                hash ^= piece_keys_[static_cast<int>(move.to_square)][piece_index(move.captured_piece)];
-            }
-            break;
+            hash ^= piece_keys_[square][piece_index(piece)];
         }
-            
-        default:
-            break;
-    }
-    
-    // Update castling rights hash
-    hash ^= castling_keys_[pos.castling_rights()]; // Remove old
-    
-    // Update en passant hash
-    if (pos.en_passant_square() != Square::None) 
-    {
-        int file = static_cast<int>(file_of(pos.en_passant_square()));
-        hash ^= en_passant_keys_[file]; // Remove old
     }
     
     return hash;
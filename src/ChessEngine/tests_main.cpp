@@ -0,0 +1,20 @@
+/*
+    Entry point for the Luna engine test suite (luna_tests).
+
+    The suite replaces the global allocator to count allocations, so it is
+    kept out of the engine library and linked only into this executable.
+
+    Author: Nicolas Miller
+    Date: 08/27/2025
+*/
+
+#include "tests.h"
+
+int main()
+{
+    luna::ChessTests tests;
+    tests.set_visualization(true);
+    tests.set_perft_depth(3);
+    tests.run_all_tests();
+    return tests.all_tests_passed() ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+/*
+    Entry point for luna-tune, the evaluation weight tuner (see tuner.h).
+
+    Author: Nicolas Miller
+    Date: 08/24/2025
+*/
+
+#include "tuner.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+void print_usage(const char* program_name) 
+{
+    std::cout << "Usage: " << program_name << " <positions> [options]" << std::endl;
+    std::cout << "  <positions>  File with one FEN and game result per line" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --epochs <n>     Training passes over the positions (default 200)" << std::endl;
+    std::cout << "  --rate <x>       Adam learning rate in centipawns (default 1.0)" << std::endl;
+    std::cout << "  --threads <n>    Worker threads (default: all cores)" << std::endl;
+    std::cout << "  --k <x>          Sigmoid scaling; fitted to the start weights if omitted" << std::endl;
+    std::cout << "  --out <path>     Header to write (default tuned_params.h)" << std::endl;
+}
+
+int64_t elapsed_ms(std::chrono::steady_clock::time_point start) 
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) 
+{
+    if (argc < 2 || std::string(argv[1]) == "--help") 
+    {
+        print_usage(argv[0]);
+        return argc < 2 ? 1 : 0;
+    }
+    
+    std::string positions_path = argv[1];
+    std::string out_path = "tuned_params.h";
+    int epochs = 200;
+    double rate = 1.0;
+    double k = 0.0;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    
+    for (int i = 2; i + 1 < argc; i += 2) 
+    {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--epochs") epochs = std::stoi(value);
+        else if (option == "--rate") rate = std::stod(value);
+        else if (option == "--threads") threads = std::stoi(value);
+        else if (option == "--k") k = std::stod(value);
+        else if (option == "--out") out_path = value;
+        else 
+        {
+            std::cerr << "Unknown option: " << option << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    luna::Tuner tuner(threads);
+    auto start = std::chrono::steady_clock::now();
+    long long loaded = tuner.load(positions_path);
+    if (loaded < 0) 
+    {
+        std::cerr << "Could not read " << positions_path << std::endl;
+        return 1;
+    }
+    if (loaded == 0) 
+    {
+        std::cerr << "No labeled positions in " << positions_path << std::endl;
+        return 1;
+    }
+    std::cout << "Loaded " << loaded << " positions in " << elapsed_ms(start) << " ms (" 
+              << loaded * static_cast<long long>(sizeof(luna::PackedPosition)) / (1024 * 1024) 
+              << " MB packed), " << threads << " threads" << std::endl;
+    
+    std::vector<double> params = luna::default_tune_params();
+    if (k <= 0.0) 
+    {
+        start = std::chrono::steady_clock::now();
+        k = tuner.fit_k(params);
+        std::cout << "Fitted K = " << k << " in " << elapsed_ms(start) << " ms" << std::endl;
+    }
+    
+    double start_error = tuner.error(params, k);
+    std::cout << std::fixed << std::setprecision(6) << "Start error: " << start_error << std::endl;
+    
+    start = std::chrono::steady_clock::now();
+    for (int epoch = 1; epoch <= epochs; epoch++) 
+    {
+        double error = tuner.train_epoch(params, k, rate);
+        if (epoch == 1 || epoch % 10 == 0 || epoch == epochs) 
+        {
+            std::cout << "Epoch " << std::setw(5) << epoch << "  error " << error << "  " 
+                      << elapsed_ms(start) / epoch << " ms/epoch" << std::endl;
+        }
+    }
+    
+    double final_error = tuner.error(params, k);
+    std::cout << "Final error: " << final_error << std::endl;
+    
+    std::ostringstream comment;
+    comment << std::fixed << std::setprecision(6) << loaded << " positions from " << positions_path 
+            << ", " << epochs << " epochs, K " << k << ", error " << start_error << " -> " << final_error;
+    if (!luna::Tuner::write_header(out_path, params, comment.str())) 
+    {
+        std::cerr << "Could not write " << out_path << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << out_path << std::endl;
+    return 0;
+}
@@ -6,6 +6,11 @@
         - Operator overloads
         -  Static factory functions to generate pre-defined bitboards
 
+    UPDATE: File, adjacent-file and passed-pawn-span masks are built at
+    compile time for pawn structure evaluation.
+    UPDATE: The raw 64-bit value is exposed for vector code that processes
+    several bitboards at once.
+
     Author: Nicolas Miller
     Date: 06/11/2025
 */
@@ -14,13 +19,59 @@
 #define BITBOARD_H
 
 #include "types.h"
+#include "bitops.h"
+
+#include <cstdint>
+
+// Compile-time masks for pawn structure evaluation. Squares run a1 = 0 to
+// h8 = 63, so a file is every eighth bit.
+namespace masks
+{
+
+constexpr uint64_t FILE_A = 0x0101010101010101ULL;
+
+struct PawnMasks
+{
+    uint64_t file[8];                // Every square on a file
+    uint64_t adjacent_files[8];      // Every square on the files either side
+    uint64_t passed_span[2][64];     // [color][square] Same and adjacent files, strictly ahead
+};
+
+constexpr PawnMasks build_pawn_masks()
+{
+    PawnMasks m{};
+    for (int f = 0; f < 8; f++)
+    {
+        m.file[f] = FILE_A << f;
+    }
+    for (int f = 0; f < 8; f++)
+    {
+        m.adjacent_files[f] = (f > 0 ? m.file[f - 1] : 0) | (f < 7 ? m.file[f + 1] : 0);
+    }
+    for (int sq = 0; sq < 64; sq++)
+    {
+        int file = sq % 8;
+        int rank = sq / 8;
+        uint64_t files = m.file[file] | m.adjacent_files[file];
+        uint64_t ahead_white = (rank == 7) ? 0 : ~0ULL << (8 * (rank + 1));
+        uint64_t ahead_black = (rank == 0) ? 0 : ~0ULL >> (8 * (8 - rank));
+        m.passed_span[0][sq] = files & ahead_white;
+        m.passed_span[1][sq] = files & ahead_black;
+    }
+    return m;
+}
+
+constexpr PawnMasks PAWN_MASKS = build_pawn_masks();
+
+} // namespace masks
 
 class Bitboard
 {
 public:
     // Constructors
-    Bitboard();
-    Bitboard(File file);
+    constexpr Bitboard() : bitboard(0ULL) {}
+    constexpr explicit Bitboard(uint64_t bits) : bitboard(bits) {}
+    Bitboard(File file) : bitboard(masks::PAWN_MASKS.file[static_cast<int>(file)]) {}
     Bitboard(Rank rank);
     Bitboard(Square square);
 
@@ -39,12 +90,20 @@ public:
     // Count the number of set bits
     uint8_t count_bits() const;
 
+    // Check whether no bits / any bits are set. Cheaper than count_bits() 
+    // when only testing for zero.
+    bool empty() const { return bitboard == 0; }
+    bool any() const { return bitboard != 0; }
+
     // Get the index of the least significant bit
     uint8_t get_lsb_index() const;
 
     // Get the index of the most significant bit
     uint8_t get_msb_index() const;
 
+    // Raw bits, for loading into vector registers
+    constexpr uint64_t value() const { return bitboard; }
+
     // Print bitboard
     void print_bitboard() const;
 
@@ -62,22 +121,61 @@ public:
     static Bitboard rank_bitboard(Rank rank);
     static Bitboard square_bitboard(Square square);
 
+    // Pawn structure masks (see masks::PawnMasks)
+    static Bitboard adjacent_files(File file)
+    {
+        return Bitboard(masks::PAWN_MASKS.adjacent_files[static_cast<int>(file)]);
+    }
+    static Bitboard passed_pawn_span(Color color, Square square)
+    {
+        return Bitboard(masks::PAWN_MASKS.passed_span[static_cast<int>(color)][static_cast<int>(square)]);
+    }
+
     // Non-sliding piece attack lookup functions
     static Bitboard knight_attacks(Square square);
     static Bitboard king_attacks(Square square);
     static Bitboard pawn_attacks(Square square, Color color);
     
-    // Sliding piece attack lookup functions
+    // Sliding piece attack lookup functions (magic bitboard lookups)
     static Bitboard bishop_attacks(Square square, Bitboard occupied);
     static Bitboard rook_attacks(Square square, Bitboard occupied);
     static Bitboard queen_attacks(Square square, Bitboard occupied);
 
-    // Initialize non-sliding attack lookup tables
+    // Reference sliding attack functions that walk the ray tables. Much slower 
+    // than the magic lookups; kept so tests can verify the magic tables.
+    static Bitboard bishop_attacks_reference(Square square, Bitboard occupied);
+    static Bitboard rook_attacks_reference(Square square, Bitboard occupied);
+
+    // Squares strictly between two squares on a shared rank, file or diagonal.
+    // Empty if the squares are not aligned.
+    static Bitboard between(Square from, Square to);
+
+    // The full edge-to-edge line through two aligned squares (both included).
+    // Empty if the squares are not aligned.
+    static Bitboard line(Square from, Square to);
+
+    // Initialize all attack lookup tables. Safe to call more than once; the
+    // tables are only built on the first call.
     static void init_attack_tables();
 
 private:
     uint64_t bitboard;
 
+    // Magic bitboard entry for a single square. The relevant occupancy bits are
+    // hashed to an index into that square's slice of the shared attack table.
+    struct Magic
+    {
+        uint64_t mask;          // Relevant occupancy squares (board edges excluded)
+        uint64_t magic;         // Magic multiplier
+        Bitboard* attacks;      // This square's slice of the attack table
+        unsigned int shift;     // 64 minus the number of relevant bits
+
+        unsigned int index(uint64_t occupied) const
+        {
+            return static_cast<unsigned int>(((occupied & mask) * magic) >> shift);
+        }
+    };
+
     // Lookup tables
     static Bitboard knight_attacks_table[static_cast<int>(Square::NB)];
     static Bitboard king_attacks_table[static_cast<int>(Square::NB)];
@@ -86,6 +184,18 @@ private:
     // Ray tables
     static Bitboard ray_table[8][static_cast<int>(Square::NB)]; // [direction][square]
 
+    // Magic bitboard tables
+    static Magic bishop_magics[static_cast<int>(Square::NB)];
+    static Magic rook_magics[static_cast<int>(Square::NB)];
+    static Bitboard bishop_table[0x1480];   // Sum of 2^relevant_bits over all squares
+    static Bitboard rook_table[0x19000];
+
+    // Line tables; [square][square]
+    static Bitboard between_table[static_cast<int>(Square::NB)][static_cast<int>(Square::NB)];
+    static Bitboard line_table[static_cast<int>(Square::NB)][static_cast<int>(Square::NB)];
+
+    static bool tables_initialized;
+
     // Helper functions for ray generation
     static void init_ray_table();
     static Bitboard generate_ray(Square square, Direction direction);
@@ -94,17 +204,107 @@ private:
     static void init_knight_attacks();
     static void init_king_attacks();
     static void init_pawn_attacks();
-
-    // Return the index of LSB from a given mask
-    static uint8_t index_of_mask(uint64_t lsb_mask) 
-    {
-        uint8_t index = 0;
-        while ((lsb_mask >> index) != 1) 
-        {
-            ++index;
-        }
-        return index;
-    }
+    static void init_line_tables();
+    static void init_magics(Magic magics[], Bitboard table[], const uint64_t magic_numbers[],
+                            Bitboard (*reference)(Square, Bitboard));
 };
 
+// Hot bit operations are defined inline so move generation loops can use
+// the intrinsics in bitops.h without a call per bit.
+
+// Set the bit at the index of the Square. 
+inline void Bitboard::set_bit(Square square)
+{
+    bitboard |= (1ULL << static_cast<int>(square));
+}
+
+// Clear the bit at the index of the Square. 
+inline void Bitboard::clear_bit(Square square)
+{
+    bitboard &= ~(1ULL << static_cast<int>(square));
+}
+
+// Return whether the bit at the square is set.
+inline bool Bitboard::is_bit_set(Square square) const
+{
+    return (bitboard & (1ULL << static_cast<int>(square))) != 0;
+}
+
+// Pop and return the index of the LSB
+inline uint8_t Bitboard::pop_lsb()
+{
+    if (bitboard == 0) return static_cast<uint8_t>(Square::None);
+
+    uint8_t index = static_cast<uint8_t>(bitops::lsb(bitboard));
+    bitboard &= bitboard - 1;   // Clear LSB
+    return index;
+}
+
+// Return the index of the LSB
+inline uint8_t Bitboard::get_lsb_index() const
+{
+    if (bitboard == 0) return static_cast<uint8_t>(Square::None);
+    return static_cast<uint8_t>(bitops::lsb(bitboard));
+}
+
+// Return the population count of the bitboard. 
+inline uint8_t Bitboard::count_bits() const
+{
+    return static_cast<uint8_t>(bitops::popcount(bitboard));
+}
+
+// Return index of MSB
+inline uint8_t Bitboard::get_msb_index() const
+{
+    if (bitboard == 0) return static_cast<uint8_t>(Square::None);
+    return static_cast<uint8_t>(bitops::msb(bitboard));
+}
+
+// Operator overloads
+inline Bitboard& Bitboard::operator|=(const Bitboard& other)
+{
+    bitboard |= other.bitboard;
+    return *this;
+}
+
+inline Bitboard& Bitboard::operator&=(const Bitboard& other)
+{
+    bitboard &= other.bitboard;
+    return *this;
+}
+
+inline Bitboard& Bitboard::operator^=(const Bitboard& other)
+{
+    bitboard ^= other.bitboard;
+    return *this;
+}
+
+inline Bitboard Bitboard::operator|(const Bitboard& other) const
+{
+    Bitboard result;
+    result.bitboard = bitboard | other.bitboard;
+    return result;
+}
+
+inline Bitboard Bitboard::operator&(const Bitboard& other) const
+{
+    Bitboard result;
+    result.bitboard = bitboard & other.bitboard;
+    return result;
+}
+
+inline Bitboard Bitboard::operator^(const Bitboard& other) const
+{
+    Bitboard result;
+    result.bitboard = bitboard ^ other.bitboard;
+    return result;
+}
+
+inline Bitboard Bitboard::operator~() const
+{
+    Bitboard result;
+    result.bitboard = ~bitboard;
+    return result;
+}
+
 #endif // BITBOARD_H
@@ -0,0 +1,112 @@
+/*
+    Portable bit operations on 64-bit words used by the Bitboard class.
+    Uses compiler intrinsics where available:
+        - GCC/Clang: __builtin_popcountll, __builtin_ctzll, __builtin_clzll
+        - MSVC x64:  __popcnt64, _BitScanForward64, _BitScanReverse64
+    and falls back to SWAR popcount and de Bruijn bit scans elsewhere.
+
+    All bit scans require a non-zero argument.
+
+    Author: Nicolas Miller
+    Date: 06/11/2025
+*/
+
+#ifndef BITOPS_H
+#define BITOPS_H
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
+
+namespace bitops
+{
+
+// Index table for the de Bruijn bit scans (Kim Walisch's variant; works for
+// both forward and reverse scans once the bits below the target are filled)
+constexpr int debruijn_index64[64] =
+{
+     0, 47,  1, 56, 48, 27,  2, 60,
+    57, 49, 41, 37, 28, 16,  3, 61,
+    54, 58, 35, 52, 50, 42, 21, 44,
+    38, 32, 29, 23, 17, 11,  4, 62,
+    46, 55, 26, 59, 40, 36, 15, 53,
+    34, 51, 20, 43, 31, 22, 10, 45,
+    25, 39, 14, 33, 19, 30,  9, 24,
+    13, 18,  8, 12,  7,  6,  5, 63
+};
+
+constexpr uint64_t debruijn64 = 0x03F79D71B4CB0A89ULL;
+
+// Fallback population count (SWAR)
+inline int popcount_fallback(uint64_t b)
+{
+    b = b - ((b >> 1) & 0x5555555555555555ULL);
+    b = (b & 0x3333333333333333ULL) + ((b >> 2) & 0x3333333333333333ULL);
+    b = (b + (b >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((b * 0x0101010101010101ULL) >> 56);
+}
+
+// Fallback forward bit scan (de Bruijn)
+inline int lsb_fallback(uint64_t b)
+{
+    return debruijn_index64[((b ^ (b - 1)) * debruijn64) >> 58];
+}
+
+// Fallback reverse bit scan (de Bruijn). Smear the MSB down first so the
+// multiply sees the same pattern as the forward scan.
+inline int msb_fallback(uint64_t b)
+{
+    b |= b >> 1;
+    b |= b >> 2;
+    b |= b >> 4;
+    b |= b >> 8;
+    b |= b >> 16;
+    b |= b >> 32;
+    return debruijn_index64[(b * debruijn64) >> 58];
+}
+
+// Number of set bits
+inline int popcount(uint64_t b)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(b);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(b));
+#else
+    return popcount_fallback(b);
+#endif
+}
+
+// Index of the least significant set bit
+inline int lsb(uint64_t b)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(b);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return static_cast<int>(index);
+#else
+    return lsb_fallback(b);
+#endif
+}
+
+// Index of the most significant set bit
+inline int msb(uint64_t b)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 ^ __builtin_clzll(b);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long index;
+    _BitScanReverse64(&index, b);
+    return static_cast<int>(index);
+#else
+    return msb_fallback(b);
+#endif
+}
+
+} // namespace bitops
+
+#endif // BITOPS_H
@@ -10,31 +10,113 @@
 
 #include "types.h"
 #include "bitboard.h"
+#include "movelist.h"
 #include <vector>
 
 class Position;
 
+// How generate_legal_moves decides legality. PinAware emits only legal moves 
+// using precomputed checkers and pins; Filter generates pseudo-legal moves and 
+// tests each one, and is kept so perft can cross-check the two generators.
+enum class LegalityMode
+{
+    PinAware,
+    Filter
+};
+
+// Move categories for staged generation. Every type emits legal moves only.
+//   Captures     captures, en passant and all promotions
+//   Quiets       non-capturing, non-promoting moves, including castling
+//   Evasions     every legal move when in check; nothing otherwise
+//   QuietChecks  quiet moves that give check
+//   Legal        every legal move (Captures + Quiets, or Evasions in check)
+enum class GenType
+{
+    Captures,
+    Quiets,
+    Evasions,
+    QuietChecks,
+    Legal
+};
+
+// Piece values used by static exchange evaluation, indexed by PieceType
+// (the same material values the engine evaluates with)
+constexpr int SEE_VALUES[6] = { 100, 320, 330, 500, 900, 20000 };
+
 class MoveGenerator
 {
 public:
     // Main interface
-    static void generate_all_moves(const Position& pos, std::vector<Move>& moves, Color color);
+    static void generate_all_moves(const Position& pos, MoveList& moves, Color color);
+    static void generate_legal_moves(const Position& pos, MoveList& moves, 
+                                     LegalityMode mode = LegalityMode::PinAware);
+    
+    // Staged generation; appends moves of one category to the list
+    template<GenType Type>
+    static void generate(const Position& pos, MoveList& moves);
+    
+    // Convenience overload that copies the legal moves into a vector. Allocates;
+    // not for use in search or perft.
     static std::vector<Move> generate_legal_moves(const Position& pos);
     
+    // Check whether a pseudo-legal move leaves the mover's king safe, without
+    // making the move
+    static bool is_legal(const Position& pos, const Move& move);
+    
+    // Check whether a move from elsewhere (a hash or killer move) could have
+    // been generated in this position, ignoring king safety. Castling moves
+    // are always rejected; they are left to normal generation.
+    static bool is_pseudo_legal(const Position& pos, const Move& move);
+    
     // Piece-specific move generation
-    static void generate_pawn_moves(const Position& pos, std::vector<Move>& moves, Color color);
-    static void generate_knight_moves(const Position& pos, std::vector<Move>& moves, Color color);
-    static void generate_bishop_moves(const Position& pos, std::vector<Move>& moves, Color color);
-    static void generate_rook_moves(const Position& pos, std::vector<Move>& moves, Color color);
-    static void generate_queen_moves(const Position& pos, std::vector<Move>& moves, Color color);
-    static void generate_king_moves(const Position& pos, std::vector<Move>& moves, Color color);
-    static void generate_castling_moves(const Position& pos, std::vector<Move>& moves, Color color);
+    static void generate_pawn_moves(const Position& pos, MoveList& moves, Color color);
+    static void generate_knight_moves(const Position& pos, MoveList& moves, Color color);
+    static void generate_bishop_moves(const Position& pos, MoveList& moves, Color color);
+    static void generate_rook_moves(const Position& pos, MoveList& moves, Color color);
+    static void generate_queen_moves(const Position& pos, MoveList& moves, Color color);
+    static void generate_king_moves(const Position& pos, MoveList& moves, Color color);
+    static void generate_castling_moves(const Position& pos, MoveList& moves, Color color);
     
     // Attack detection utilities
     static bool is_square_attacked(const Position& pos, Square square, Color by_color);
     static Bitboard get_attackers_to(const Position& pos, Square square, Color by_color);
+    
+    // Pieces of the given color pinned to their own king
+    static Bitboard get_pinned_pieces(const Position& pos, Color color);
+    
+    // Check whether a legal move gives check, directly or by discovery
+    static bool gives_check(const Position& pos, const Move& move);
+    
+    // Static exchange evaluation: the material won or lost by the capture
+    // sequence on the move's target square, each side recapturing with its
+    // least valuable attacker and free to stop. Sliders uncovered by earlier
+    // captures join in (x-rays); pins are ignored. Castling scores 0.
+    static int see(const Position& pos, const Move& move);
+    
+    // Whether see(pos, move) >= threshold, stopping as soon as that is known
+    static bool see_ge(const Position& pos, const Move& move, int threshold);
 
 private:
+    // Legal generation using checkers and pins computed up front. QuietChecks
+    // is built on top of Quiets and never reaches this function.
+    template<Color Us, GenType Type>
+    static void generate_pin_aware_moves(const Position& pos, MoveList& moves);
+    
+    // Add moves from a square to every square in targets
+    static void add_moves(const Position& pos, MoveList& moves, Square from, Bitboard targets);
+    
+    // Add a pawn move, expanding promotions
+    template<Color Us>
+    static void add_pawn_move(MoveList& moves, Square from, Square to, MoveType type);
+    
+    // All pieces of a color attacking a square, given an occupancy
+    static Bitboard attackers_to(const Position& pos, Square square, Color by_color, Bitboard occupied);
+    
+    // SEE step: take the least valuable of a side's attackers off the
+    // board, adding sliders it uncovers to the attackers
+    static PieceType pop_least_valuable_attacker(const Position& pos, Square square, Bitboard side_attackers,
+                                                 Bitboard& occupied, Bitboard& attackers);
+
     // Prevent instantiation
     MoveGenerator() = delete;
     MoveGenerator(const MoveGenerator&) = delete;
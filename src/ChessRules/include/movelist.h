@@ -0,0 +1,82 @@
+/*
+    A fixed-capacity move list with inline storage, used by move generation
+    and search in place of std::vector<Move>. No chess position has more than
+    218 legal moves, so 256 slots are always enough and filling a list never
+    touches the heap.
+
+    Author: Nicolas Miller
+    Date: 06/11/2025
+*/
+
+#ifndef MOVELIST_H
+#define MOVELIST_H
+
+#include "types.h"
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+
+constexpr int MAX_MOVES = 256;
+
+class MoveList
+{
+public:
+    MoveList() : size_(0) {}
+
+    // Moves are trivially copyable, so copying a list copies only the used slots
+    MoveList(const MoveList& other) : size_(0)
+    {
+        for (const Move& move : other) push_back(move);
+    }
+
+    MoveList& operator=(const MoveList& other)
+    {
+        size_ = 0;
+        for (const Move& move : other) push_back(move);
+        return *this;
+    }
+
+    // Append a move
+    void push_back(const Move& move)
+    {
+        assert(size_ < static_cast<size_t>(MAX_MOVES));
+        new (data() + size_) Move(move);
+        ++size_;
+    }
+
+    // Remove all moves
+    void clear() { size_ = 0; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    Move& operator[](size_t index) { return data()[index]; }
+    const Move& operator[](size_t index) const { return data()[index]; }
+
+    // Iteration
+    Move* begin() { return data(); }
+    Move* end() { return data() + size_; }
+    const Move* begin() const { return data(); }
+    const Move* end() const { return data() + size_; }
+
+    // Check if a move is in the list
+    bool contains(const Move& move) const
+    {
+        for (const Move& m : *this)
+        {
+            if (m == move) return true;
+        }
+        return false;
+    }
+
+private:
+    // Raw storage so constructing a list does not default-construct 256 moves
+    alignas(Move) unsigned char storage_[MAX_MOVES * sizeof(Move)];
+    size_t size_;
+
+    Move* data() { return reinterpret_cast<Move*>(storage_); }
+    const Move* data() const { return reinterpret_cast<const Move*>(storage_); }
+};
+
+#endif // MOVELIST_H
@@ -1,6 +1,10 @@
 /*
     Position class for chess engine - represents a complete chess position
     including piece placement, side to move, castling rights, en passant, etc.
+
+    UPDATE: Each undo stack entry records the pieces its move added,
+    removed or moved, so incremental evaluators (NNUE) can update from the
+    previous position instead of rescanning the board.
         
     Author: Nicolas Miller
     Date: 06/11/2025
@@ -11,24 +15,62 @@
 
 #include "types.h"
 #include "bitboard.h"
+#include "movelist.h"
 #include <string>
 #include <vector>
 
 class MoveGenerator;
 
+// Maximum number of moves the undo stack can hold; comfortably longer than 
+// any real game
+constexpr int MAX_GAME_PLY = 1024;
+
+// A piece changed by a move: from is Square::None for a piece placed on
+// the board (promotion), to is Square::None for a piece removed (capture)
+struct DirtyPiece
+{
+    Piece piece;
+    Square from;
+    Square to;
+};
+
+/*
+    State that make_move cannot recompute on undo. One entry is pushed per move.
+*/
+struct StateInfo
+{
+    Move move;                  // The move that was made
+    Piece captured_piece;       // The piece captured (if any)
+    uint8_t castling_rights;    // Castling rights before the move
+    Square en_passant_square;   // En passant square before the move
+    int halfmove_clock;         // Halfmove clock before the move
+    uint64_t hash_key;          // Zobrist hash before the move
+    uint64_t pawn_key;          // Pawn-only Zobrist hash before the move
+    Score psq_score;            // Material and piece-square sum before the move
+    int game_phase;             // Game phase before the move
+    DirtyPiece dirty[3];        // Pieces changed by the move
+    int dirty_count;            // 0 for a null move, at most 3 (capturing promotion)
+};
+
 class Position
 {
 public:
     // Constructor - creates starting position by default
     Position();
     
+    // Copies only the used part of the undo stack
+    Position(const Position& other);
+    Position& operator=(const Position& other);
+    
     // Load position from FEN string
     bool load_fen(const std::string& fen);
     
     // Get FEN string representation of current position
     std::string to_fen() const;
     
-    // Move generation; delegates to MoveGenerator
+    // Move generation; delegates to MoveGenerator. The MoveList overload does
+    // not allocate and is the one to use in search.
+    void generate_legal_moves(MoveList& moves) const;
     std::vector<Move> generate_legal_moves() const;
     
     // Make a move (updates the position and adds to history)
@@ -40,6 +82,13 @@ public:
     // Undo multiple moves
     void undo_moves(int count);
     
+    // Pass the turn without moving, for null move pruning. Clears the en
+    // passant square; must not be used while in check.
+    void make_null_move();
+    
+    // Undo a make_null_move (undo_move must not be used for this)
+    void undo_null_move();
+    
     // Check if a square is attacked by a given color; delegates to MoveGenerator
     bool is_square_attacked(Square square, Color by_color) const;
     
@@ -57,15 +106,34 @@ public:
     Square king_square(Color color) const;
     
     // Get move history
-    const std::vector<Move>& move_history() const { return move_history_; }
-    size_t move_count() const { return move_history_.size(); }
+    size_t move_count() const { return static_cast<size_t>(state_count_); }
+    Move last_move() const { return state_count_ > 0 ? states_[state_count_ - 1].move : Move(); }
     
     // Clear move history
-    void clear_history() { move_history_.clear(); }
+    void clear_history() { state_count_ = 0; }
+    
+    // Undo stack entry for move index (0 is the oldest kept, move_count() - 1
+    // the last move made). Its hash_key is the key of the position before
+    // that move.
+    const StateInfo& state(size_t index) const { return states_[index]; }
     
     // Hash key access
     uint64_t hash_key() const { return hash_key_; }
     
+    // Cheap estimate of the hash key after a move, for prefetching the
+    // child's table entry before making it. Ignores castling right changes,
+    // the castling rook and a new en passant square, so it can differ from
+    // the real key after those moves.
+    uint64_t key_after(const Move& move) const;
+    
+    // Zobrist hash of the pawns alone, for the pawn structure cache
+    uint64_t pawn_key() const { return pawn_key_; }
+    
+    // Running sum of material and piece-square values (white minus black)
+    // and the game phase, kept up to date by make_move
+    Score psq_score() const { return psq_score_; }
+    int game_phase() const { return game_phase_; }
+    
     // Getters for MoveGenerator
     Bitboard pieces(Color color, PieceType type) const 
     {
@@ -107,15 +175,27 @@ private:
     int halfmove_clock_;       // For 50-move rule
     int fullmove_number_;
     
-    // Move history stack
-    std::vector<Move> move_history_;
+    // Undo stack; one StateInfo per move made
+    StateInfo states_[MAX_GAME_PLY];
+    int state_count_;
     
     // Zobrist hash key for current position
     uint64_t hash_key_;
+    uint64_t pawn_key_;
+    
+    // Incrementally updated evaluation terms
+    Score psq_score_;
+    int game_phase_;
     
     // Update bitboards after a move
     void update_bitboards();
     
+    // Record a piece changed by the move being made
+    static void add_dirty_piece(StateInfo& st, Piece piece, Square from, Square to)
+    {
+        st.dirty[st.dirty_count++] = { piece, from, to };
+    }
+    
     // Helper function for opposite color
     static Color opposite_color(Color c) 
     {
@@ -3,8 +3,8 @@
     of a chess game/engine, including various enumerations and utility functions
     for board and piece representation.  
     
-    REVISED: Move struct no longer contains state information - that's handled
-    by MoveWithState in position.h
+    REVISED: Move is a packed 16-bit value and no longer contains state 
+    information - that's handled by the StateInfo stack in position.h
 
     Author: Nicolas Miller
     Date: 06/11/2025
@@ -13,6 +13,7 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <cstdint>
 #include <string>
 #include <cctype>
 #include <algorithm>
@@ -97,6 +98,18 @@ enum class Direction
     NorthWest = 7
 };
 
+// A middlegame and an endgame evaluation term, blended by game phase
+struct Score
+{
+    int mg = 0;
+    int eg = 0;
+    
+    Score& operator+=(const Score& other) { mg += other.mg; eg += other.eg; return *this; }
+    Score& operator-=(const Score& other) { mg -= other.mg; eg -= other.eg; return *this; }
+    bool operator==(const Score& other) const { return mg == other.mg && eg == other.eg; }
+    bool operator!=(const Score& other) const { return !(*this == other); }
+};
+
 // Returns a square from a File and Rank.
 inline Square make_square(File file, Rank rank) 
 {
@@ -203,57 +216,88 @@ inline std::string piece_to_string(Piece piece)
 }
 
 /*
-    A struct representing a Move in a chess game. Contains both the move
-    description and state information needed for undoing the move.
+    A chess move packed into 16 bits:
+        bits  0-5   from square
+        bits  6-11  to square
+        bits 12-15  flag: 0 normal, 1 capture, 2 castle, 3 en passant,
+                    4-7 promotion to knight, bishop, rook, queen
+    State needed to undo a move lives in Position's StateInfo stack. The 
+    all-zero value (a1a1) is never a real move and is used as "no move".
 */
-struct Move
+class Move
 {
-    // Move description (what the move is)
-    Square from_square;                 // The square a piece is moving from
-    Square to_square;                   // The square a piece is moving to
-    MoveType move_type;                 // The type of move made (normal, capture, etc.)
-    Piece promotion_piece;              // The piece promoted to, if applicable
+public:
+    // Constructors
+    Move() : data_(0) {}
     
-    // State info for undo (captured by make_move)
-    Piece captured_piece;               // The piece captured (if any)
-    uint8_t previous_castling_rights;   // Castling rights before the move
-    Square previous_en_passant_square;  // En passant square before the move
-    int previous_halfmove_clock;        // Halfmove clock before the move
+    Move(Square from, Square to, MoveType type, Piece promotion = Piece::None)
+        : data_(static_cast<uint16_t>(static_cast<int>(from) | 
+                                      (static_cast<int>(to) << 6) | 
+                                      (encode_flag(type, promotion) << 12))) {}
     
-    // Constructors
-    Move() : from_square(Square::None), to_square(Square::None), 
-             move_type(MoveType::Normal), promotion_piece(Piece::None),
-             captured_piece(Piece::None), previous_castling_rights(0),
-             previous_en_passant_square(Square::None), previous_halfmove_clock(0) {}
+    // Rebuild a move from its packed form (e.g. from a TT entry)
+    static Move from_raw(uint16_t raw) 
+    { 
+        Move move;
+        move.data_ = raw;
+        return move;
+    }
     
-    Move(Square from, Square to, MoveType type, Piece promotion = Piece::None) 
-        : from_square(from), to_square(to), move_type(type), promotion_piece(promotion),
-          captured_piece(Piece::None), previous_castling_rights(0),
-          previous_en_passant_square(Square::None), previous_halfmove_clock(0) {}
+    // Accessors
+    Square from_square() const { return static_cast<Square>(data_ & 0x3F); }
+    Square to_square() const { return static_cast<Square>((data_ >> 6) & 0x3F); }
     
-    // Equality operator; compares move description
-    bool operator==(const Move& other) const
+    MoveType move_type() const
     {
-        return from_square == other.from_square &&
-               to_square == other.to_square &&
-               move_type == other.move_type &&
-               promotion_piece == other.promotion_piece;
+        int flag = data_ >> 12;
+        return flag >= PROMOTION_FLAG ? MoveType::Promotion : static_cast<MoveType>(flag);
     }
     
+    // The promoted piece; its color follows from the promotion rank
+    Piece promotion_piece() const
+    {
+        int flag = data_ >> 12;
+        if (flag < PROMOTION_FLAG) return Piece::None;
+        
+        Color color = rank_of(to_square()) == Rank::Eight ? Color::White : Color::Black;
+        return make_piece(color, static_cast<PieceType>(flag - PROMOTION_FLAG + static_cast<int>(PieceType::Knight)));
+    }
+    
+    uint16_t raw() const { return data_; }
+    bool is_none() const { return data_ == 0; }
+    
+    // Comparison is a single integer compare
+    bool operator==(const Move& other) const { return data_ == other.data_; }
+    bool operator!=(const Move& other) const { return data_ != other.data_; }
+    
     // Convert to string notation (e.g., "e2e4", "e7e8q")
     std::string to_string() const
     {
-        std::string result = square_to_string(from_square) + square_to_string(to_square);
+        std::string result = square_to_string(from_square()) + square_to_string(to_square());
         
         // Add promotion piece if applicable
-        if (move_type == MoveType::Promotion && promotion_piece != Piece::None)
+        if (move_type() == MoveType::Promotion)
         {
-            std::string piece_str = piece_to_string(promotion_piece);
+            std::string piece_str = piece_to_string(promotion_piece());
             result += static_cast<char>(std::tolower(piece_str[0]));
         }
         
         return result;
     }
+    
+private:
+    static constexpr int PROMOTION_FLAG = 4;
+    
+    uint16_t data_;
+    
+    static int encode_flag(MoveType type, Piece promotion)
+    {
+        if (type != MoveType::Promotion) return static_cast<int>(type);
+        
+        // A promotion without a piece defaults to a queen
+        PieceType promo_type = (promotion == Piece::None) ? PieceType::Queen : type_of(promotion);
+        return PROMOTION_FLAG + static_cast<int>(promo_type) - static_cast<int>(PieceType::Knight);
+    }
 };
 
 #endif // TYPES_H
\ No newline at end of file
@@ -11,19 +11,6 @@
 
 #include <iostream>
 
-// Default constructor - creates an empty bitboard
-Bitboard::Bitboard() : bitboard(0ULL) {}
-
-// Constructor that creates a bitboard with all squares in a file set
-Bitboard::Bitboard(File file) : bitboard(0ULL)
-{
-    for (int rank = 0; rank < static_cast<int>(Rank::NB); ++rank)
-    {
-        Square sq = make_square(file, static_cast<Rank>(rank));
-        set_bit(sq);
-    }
-}
-
 // Constructor that creates a bitboard with all squares in a rank set
 Bitboard::Bitboard(Rank rank) : bitboard(0ULL)
 {
@@ -40,74 +27,6 @@ Bitboard::Bitboard(Square square) : bitboard(0ULL)
     set_bit(square);
 }
 
-// Set the bit at the index of the Square. 
-void Bitboard::set_bit(Square square)
-{
-    uint8_t bit_index = static_cast<uint8_t>(square);
-    bitboard |= (1ULL << bit_index);
-}
-
-// Clear the bit at the index of the Square. 
-void Bitboard::clear_bit(Square square)
-{
-    uint8_t bit_index = static_cast<uint8_t>(square);
-    bitboard &= ~(1ULL << bit_index);
-}
-
-// Return whether the bit at the square is set.
-bool Bitboard::is_bit_set(Square square) const
-{
-    uint8_t bit_index = static_cast<uint8_t>(square);
-    return (bitboard & (1ULL << bit_index)) != 0;
-}
-
-// Pop and return the index of the LSB
-uint8_t Bitboard::pop_lsb()
-{
-    if (bitboard == 0) return static_cast<uint8_t>(Square::None);
-
-    uint64_t lsb_mask = bitboard & (~bitboard + 1);     // Get LSB mask
-    uint8_t index = index_of_mask(lsb_mask);            // Get index of LSB
-    bitboard &= ~lsb_mask;                              // Clear LSB
-    return index;                                       // Return index
-}
-
-// Return the index of the LSB
-uint8_t Bitboard::get_lsb_index() const   
-{
-    if (bitboard == 0) return static_cast<uint8_t>(Square::None);
-    return index_of_mask(bitboard & (~bitboard + 1));
-}
-
-// Return the population count of the bitboard. 
-// TODO: Speed this up?
-uint8_t Bitboard::count_bits() const
-{
-    uint64_t bb_copy = bitboard;    // Create copy of bitboard
-    uint8_t count = 0;
-    while (bb_copy)
-    {
-        count += bb_copy & 1;       // Add 1 if LSB is set
-        bb_copy >>= 1;              // Shift to check next bit
-    }
-
-    return count;
-}
-
-// Return index of MSB
-uint8_t Bitboard::get_msb_index() const
-{
-    if (bitboard == 0) return static_cast<uint8_t>(Square::None);
-
-    // Start at the highest bit and work backwards
-    uint8_t index = 63; 
-    while (((bitboard >> index) & 1) == 0) 
-    {
-        --index;
-    }
-    return index;
-}
-
 // Print the bitboard as a standard game board. 
 void Bitboard::print_bitboard() const 
 {
@@ -357,13 +276,67 @@ Bitboard Bitboard::pawn_attacks(Square square, Color color)
     return pawn_attacks_table[static_cast<int>(color)][static_cast<int>(square)];
 }
 
-// Initialize all non-sliding attack tables
+// Magic multipliers for each square. Each one maps every relevant occupancy of
+// the square to a unique index (or to an index shared with an occupancy that has
+// the same attack set). Found offline with a sparse random search.
+const uint64_t bishop_magic_numbers[64] = 
+{
+    0x01400450C2004100ULL, 0x2044108404408200ULL, 0x0004580200401028ULL, 0x04C4440084045000ULL,
+    0x0801104000400200ULL, 0x0808480210208808ULL, 0x0001082803082100ULL, 0x8000120084200880ULL,
+    0x8510400404008A10ULL, 0x0000101206504204ULL, 0x0460522410420104ULL, 0xA480884841020011ULL,
+    0x0501040420004810ULL, 0x2060020210060000ULL, 0x2006008441601003ULL, 0x8400830049102807ULL,
+    0x20046012101A0800ULL, 0x40104C0810610040ULL, 0x0858087048002021ULL, 0xA882000422020404ULL,
+    0x0002012402110113ULL, 0x0000201210042020ULL, 0x0005110201100201ULL, 0x4241000480880184ULL,
+    0x1010100440029290ULL, 0x1904200010018100ULL, 0x0002824030010202ULL, 0x0004080101010500ULL,
+    0x1191840002802007ULL, 0x8001020011006100ULL, 0x0040840092010445ULL, 0x00A0831806010080ULL,
+    0x0004321820222000ULL, 0x0101010808208800ULL, 0x0A00802401208800ULL, 0x0502020080080080ULL,
+    0xC020008400010410ULL, 0x002411160000C800ULL, 0x900C080054022102ULL, 0x0010808100208400ULL,
+    0x4801105010010410ULL, 0x2010584210000801ULL, 0x2811010802041100ULL, 0x0030802214080800ULL,
+    0x0400196012000101ULL, 0x0001020800401200ULL, 0x8051020200400400ULL, 0x4842220042004102ULL,
+    0x0801051032201810ULL, 0x1080440208030800ULL, 0x0002804404440820ULL, 0x0000420084110009ULL,
+    0x420800300A0600A0ULL, 0x8110052004010120ULL, 0x0020020202440020ULL, 0x00042C0840410804ULL,
+    0x0000124208202808ULL, 0x0000210101104200ULL, 0x0012040022311008ULL, 0x0400410004411088ULL,
+    0x0202000008210100ULL, 0x04A0001060810100ULL, 0x0000509011014400ULL, 0x0004100208210414ULL
+};
+
+const uint64_t rook_magic_numbers[64] = 
+{
+    0x2880001020804001ULL, 0x0240019000C02000ULL, 0x3200220040081080ULL, 0x0880041000800802ULL,
+    0x0200080200102004ULL, 0x0200041008020001ULL, 0x0080020000800100ULL, 0x4080010000402080ULL,
+    0x0421800080400020ULL, 0x0112002041008200ULL, 0x3002001040208200ULL, 0x8009001000082300ULL,
+    0x8002001200080420ULL, 0x4042001004080201ULL, 0x0205000200041900ULL, 0x80C10000648A0100ULL,
+    0x800024800184C000ULL, 0x0020008080400020ULL, 0x2000808020001000ULL, 0x0020828048011000ULL,
+    0x0240808004000800ULL, 0x0302008080020400ULL, 0x2018808002000100ULL, 0x060102000400A041ULL,
+    0x0000209180004000ULL, 0x01C0100020002800ULL, 0x8640200280100086ULL, 0x8240120200200840ULL,
+    0x0210040080080080ULL, 0x020C000202001008ULL, 0x008450040011A208ULL, 0x4440048200052044ULL,
+    0x1000400063800588ULL, 0x00A0004000802084ULL, 0x0020001000802080ULL, 0x1100100080800800ULL,
+    0x0020041101000800ULL, 0x4102008002800400ULL, 0x4014500114001208ULL, 0x0000004402002081ULL,
+    0x0040014C30818000ULL, 0x1400402010004004ULL, 0x0010420080120024ULL, 0x0000120020420008ULL,
+    0x04A0040008008080ULL, 0x0000020004008080ULL, 0x4281108A011C0008ULL, 0x0012086404820011ULL,
+    0x4212010040208200ULL, 0x0009122040048100ULL, 0x000440110C200100ULL, 0x0210900080080180ULL,
+    0x0010080091010500ULL, 0x0003000802040100ULL, 0x8211000200040100ULL, 0x00100081205C0200ULL,
+    0x0000108008C12101ULL, 0x0000122841008202ULL, 0x0006000824801042ULL, 0x8830000410090021ULL,
+    0x8009003A08003015ULL, 0x2002000488100102ULL, 0x00A000C208011004ULL, 0x4080008021040042ULL
+};
+
+// Initialize all attack tables. The ray table must be built before the magic
+// tables since the magic initialization uses the reference ray attacks, and the
+// line tables are built from the magic lookups.
+bool Bitboard::tables_initialized = false;
+
 void Bitboard::init_attack_tables() 
 {
+    if (tables_initialized) return;
+
     Bitboard::init_knight_attacks();
     Bitboard::init_king_attacks();
     Bitboard::init_pawn_attacks();
     Bitboard::init_ray_table();
+    Bitboard::init_magics(bishop_magics, bishop_table, bishop_magic_numbers, bishop_attacks_reference);
+    Bitboard::init_magics(rook_magics, rook_table, rook_magic_numbers, rook_attacks_reference);
+    Bitboard::init_line_tables();
+
+    tables_initialized = true;
 }
 
 // Define ray table; one entry for each direction for each square
@@ -471,9 +444,9 @@ void Bitboard::init_ray_table()
     }
 }
 
-// Generate bishop attacks. Requires a bitboard representing the current state
-// of the board (should contain all occupied squares). 
-Bitboard Bitboard::bishop_attacks(Square square, Bitboard occupied)
+// Generate bishop attacks by walking the rays. Requires a bitboard representing 
+// the current state of the board (should contain all occupied squares). 
+Bitboard Bitboard::bishop_attacks_reference(Square square, Bitboard occupied)
 {
     Bitboard attacks;
 
@@ -534,9 +507,9 @@ Bitboard Bitboard::bishop_attacks(Square square, Bitboard occupied)
     return attacks;
 }
 
-// Generate rook attacks.
+// Generate rook attacks by walking the rays.
 // TODO: Nearly identical to bishop function. Could probably template it with T = Piece.
-Bitboard Bitboard::rook_attacks(Square square, Bitboard occupied) 
+Bitboard Bitboard::rook_attacks_reference(Square square, Bitboard occupied) 
 {
     Bitboard attacks;
     
@@ -596,61 +569,132 @@ Bitboard Bitboard::rook_attacks(Square square, Bitboard occupied)
     return attacks;
 }
 
-// Generate queen attacks (combination of bishop and rook attacks)
-Bitboard Bitboard::queen_attacks(Square square, Bitboard occupied) 
+// Define magic tables. Each square gets a slice of the shared attack table
+// sized 2^(relevant bits), so the total size is fixed for each piece type.
+Bitboard::Magic Bitboard::bishop_magics[static_cast<int>(Square::NB)];
+Bitboard::Magic Bitboard::rook_magics[static_cast<int>(Square::NB)];
+Bitboard Bitboard::bishop_table[0x1480];
+Bitboard Bitboard::rook_table[0x19000];
+
+// Fill the magic entries and attack table for one slider type. For every square
+// we enumerate each subset of the relevant occupancy mask (carry-rippler trick)
+// and store the reference attack set at the subset's magic index.
+void Bitboard::init_magics(Magic magics[], Bitboard table[], const uint64_t magic_numbers[],
+                           Bitboard (*reference)(Square, Bitboard))
 {
-    Bitboard bishop = bishop_attacks(square, occupied);
-    Bitboard rook = rook_attacks(square, occupied);
+    Bitboard* next_slice = table;
     
-    Bitboard queen;
-    queen.bitboard = bishop.bitboard | rook.bitboard;
-    
-    return queen;
+    for (int sq = 0; sq < static_cast<int>(Square::NB); sq++)
+    {
+        Square square = static_cast<Square>(sq);
+        
+        // Edge squares never block anything beyond them, so leave them out of 
+        // the mask unless the piece is on that edge itself
+        uint64_t edges = ((rank_bitboard(Rank::One).bitboard | rank_bitboard(Rank::Eight).bitboard) & ~rank_bitboard(rank_of(square)).bitboard) |
+                         ((file_bitboard(File::A).bitboard | file_bitboard(File::H).bitboard) & ~file_bitboard(file_of(square)).bitboard);
+        
+        Magic& m = magics[sq];
+        m.mask = reference(square, Bitboard()).bitboard & ~edges;
+        m.magic = magic_numbers[sq];
+        Bitboard mask_bb;
+        mask_bb.bitboard = m.mask;
+        m.shift = 64 - mask_bb.count_bits();
+        m.attacks = next_slice;
+        
+        // Walk every subset of the mask
+        uint64_t subset = 0;
+        do
+        {
+            Bitboard occupied;
+            occupied.bitboard = subset;
+            m.attacks[m.index(subset)] = reference(square, occupied);
+            subset = (subset - m.mask) & m.mask;
+        } while (subset != 0);
+        
+        next_slice += 1ULL << (64 - m.shift);
+    }
 }
 
-// Operator overloads
-Bitboard& Bitboard::operator|=(const Bitboard& other)
+// Bishop attacks from the magic table
+Bitboard Bitboard::bishop_attacks(Square square, Bitboard occupied)
 {
-    bitboard |= other.bitboard;
-    return *this;
+    if (square == Square::NB || square == Square::None)
+        return Bitboard();
+        
+    const Magic& m = bishop_magics[static_cast<int>(square)];
+    return m.attacks[m.index(occupied.bitboard)];
 }
 
-Bitboard& Bitboard::operator&=(const Bitboard& other)
+// Rook attacks from the magic table
+Bitboard Bitboard::rook_attacks(Square square, Bitboard occupied)
 {
-    bitboard &= other.bitboard;
-    return *this;
+    if (square == Square::NB || square == Square::None)
+        return Bitboard();
+        
+    const Magic& m = rook_magics[static_cast<int>(square)];
+    return m.attacks[m.index(occupied.bitboard)];
 }
 
-Bitboard& Bitboard::operator^=(const Bitboard& other)
+// Generate queen attacks (combination of bishop and rook attacks)
+Bitboard Bitboard::queen_attacks(Square square, Bitboard occupied) 
 {
-    bitboard ^= other.bitboard;
-    return *this;
+    Bitboard bishop = bishop_attacks(square, occupied);
+    Bitboard rook = rook_attacks(square, occupied);
+    
+    Bitboard queen;
+    queen.bitboard = bishop.bitboard | rook.bitboard;
+    
+    return queen;
 }
 
-Bitboard Bitboard::operator|(const Bitboard& other) const
+// Line lookup functions
+Bitboard Bitboard::between(Square from, Square to)
 {
-    Bitboard result;
-    result.bitboard = bitboard | other.bitboard;
-    return result;
+    if (from >= Square::NB || to >= Square::NB)
+        return Bitboard();
+        
+    return between_table[static_cast<int>(from)][static_cast<int>(to)];
 }
 
-Bitboard Bitboard::operator&(const Bitboard& other) const
+Bitboard Bitboard::line(Square from, Square to)
 {
-    Bitboard result;
-    result.bitboard = bitboard & other.bitboard;
-    return result;
+    if (from >= Square::NB || to >= Square::NB)
+        return Bitboard();
+        
+    return line_table[static_cast<int>(from)][static_cast<int>(to)];
 }
 
-Bitboard Bitboard::operator^(const Bitboard& other) const
-{
-    Bitboard result;
-    result.bitboard = bitboard ^ other.bitboard;
-    return result;
-}
+// Define line tables
+Bitboard Bitboard::between_table[static_cast<int>(Square::NB)][static_cast<int>(Square::NB)];
+Bitboard Bitboard::line_table[static_cast<int>(Square::NB)][static_cast<int>(Square::NB)];
 
-Bitboard Bitboard::operator~() const
+// Fill the between and line tables. Two squares are aligned if a rook or bishop 
+// on one attacks the other on an empty board; the squares between them are 
+// those each one attacks when the other is the only blocker.
+void Bitboard::init_line_tables()
 {
-    Bitboard result;
-    result.bitboard = ~bitboard;
-    return result;
+    for (int a = 0; a < static_cast<int>(Square::NB); a++)
+    {
+        Square sq_a = static_cast<Square>(a);
+        
+        for (int b = 0; b < static_cast<int>(Square::NB); b++)
+        {
+            Square sq_b = static_cast<Square>(b);
+            between_table[a][b] = Bitboard();
+            line_table[a][b] = Bitboard();
+            
+            if (a == b) continue;
+            
+            Bitboard (*attacks)(Square, Bitboard) = nullptr;
+            if (rook_attacks(sq_a, Bitboard()).is_bit_set(sq_b))
+                attacks = rook_attacks;
+            else if (bishop_attacks(sq_a, Bitboard()).is_bit_set(sq_b))
+                attacks = bishop_attacks;
+            else
+                continue;
+            
+            between_table[a][b] = attacks(sq_a, Bitboard(sq_b)) & attacks(sq_b, Bitboard(sq_a));
+            line_table[a][b] = (attacks(sq_a, Bitboard()) & attacks(sq_b, Bitboard())) | Bitboard(sq_a) | Bitboard(sq_b);
+        }
+    }
 }
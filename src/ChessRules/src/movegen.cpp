@@ -9,10 +9,11 @@
 #include "movegen.h"
 #include "position.h"
 #include "types.h"
+#include <algorithm>
 #include <vector>
 
 // Generate all pseudo-legal moves for a color
-void MoveGenerator::generate_all_moves(const Position& pos, std::vector<Move>& moves, Color color)
+void MoveGenerator::generate_all_moves(const Position& pos, MoveList& moves, Color color)
 {
     generate_pawn_moves(pos, moves, color);
     generate_knight_moves(pos, moves, color);
@@ -23,16 +24,18 @@ void MoveGenerator::generate_all_moves(const Position& pos, std::vector<Move>& m
     generate_castling_moves(pos, moves, color);
 }
 
-// Generate legal moves by filtering pseudo-legal moves
-std::vector<Move> MoveGenerator::generate_legal_moves(const Position& pos)
+// Generate legal moves
+void MoveGenerator::generate_legal_moves(const Position& pos, MoveList& moves, LegalityMode mode)
 {
+    moves.clear();
+    
     // Special case: if there are only two kings on the board, it's an automatic stalemate
     bool only_kings = true;
     for (int c = 0; c < static_cast<int>(Color::NB); ++c)
     {
         for (int pt = 0; pt < static_cast<int>(PieceType::NB); ++pt)
         {
-            if (pt != static_cast<int>(PieceType::King) && pos.pieces(static_cast<Color>(c), static_cast<PieceType>(pt)).count_bits() > 0)
+            if (pt != static_cast<int>(PieceType::King) && pos.pieces(static_cast<Color>(c), static_cast<PieceType>(pt)).any())
             {
                 only_kings = false;
                 break;
@@ -41,14 +44,20 @@ std::vector<Move> MoveGenerator::generate_legal_moves(const Position& pos)
         if (!only_kings) break;
     }
     
-    // If there are only two kings, return an empty list (stalemate)
+    // If there are only two kings, leave the list empty (stalemate)
     if (only_kings)
     {
-        return std::vector<Move>();
+        return;
+    }
+    
+    // Pin-aware generation needs a king to pin to
+    if (mode == LegalityMode::PinAware && pos.king_square(pos.side_to_move()) != Square::None)
+    {
+        generate<GenType::Legal>(pos, moves);
+        return;
     }
     
-    std::vector<Move> pseudo_legal;
-    std::vector<Move> legal;
+    MoveList pseudo_legal;
     
     // Generate all pseudo-legal moves
     generate_all_moves(pos, pseudo_legal, pos.side_to_move());
@@ -56,33 +65,380 @@ std::vector<Move> MoveGenerator::generate_legal_moves(const Position& pos)
     // Filter out illegal moves (those that leave king in check)
     for (const Move& move : pseudo_legal)
     {
-        // Make move on a copy
-        Position test_pos = pos;
-        test_pos.make_move(move);
+        if (is_legal(pos, move))
+        {
+            moves.push_back(move);
+        }
+    }
+}
+
+// Generate only legal moves. With the checkers and pinned pieces known, every
+// move except en passant can be validated against a target mask:
+//   - King moves go to squares not attacked once the king leaves its square
+//   - In double check only the king may move
+//   - In single check other pieces must capture the checker or block
+//   - Pinned pieces stay on the line through their king and pinner
+// The generation type then narrows the targets to enemy pieces (Captures) or
+// empty squares (Quiets).
+template<Color Us, GenType Type>
+void MoveGenerator::generate_pin_aware_moves(const Position& pos, MoveList& moves)
+{
+    constexpr Color Them = (Us == Color::White) ? Color::Black : Color::White;
+    constexpr bool Captures = (Type != GenType::Quiets);
+    constexpr bool Quiets = (Type != GenType::Captures);
+    constexpr int PushOffset = static_cast<int>(Us == Color::White ? Direction::North : Direction::South);
+    constexpr Rank StartRank = (Us == Color::White) ? Rank::Two : Rank::Seven;
+    constexpr Rank PromoRank = (Us == Color::White) ? Rank::Eight : Rank::One;
+    
+    Square king_sq = pos.king_square(Us);
+    Bitboard checkers = get_attackers_to(pos, king_sq, Them);
+    
+    if (Type == GenType::Evasions && checkers.empty())
+        return;
+    
+    Bitboard enemy_pieces = pos.occupied_by_color(Them);
+    Bitboard empty_squares = ~pos.occupied();
+    Bitboard pinned = get_pinned_pieces(pos, Us);
+    
+    // Destination squares allowed by the generation type
+    Bitboard type_mask;
+    if (Captures) type_mask |= enemy_pieces;
+    if (Quiets) type_mask |= empty_squares;
+    
+    // King moves; the king itself must not block sliders when testing its escape squares
+    Bitboard occupied_without_king = pos.occupied();
+    occupied_without_king.clear_bit(king_sq);
+    
+    Bitboard king_targets = Bitboard::king_attacks(king_sq) & type_mask;
+    while (king_targets.any())
+    {
+        Square to = static_cast<Square>(king_targets.pop_lsb());
+        if (attackers_to(pos, to, Them, occupied_without_king).empty())
+        {
+            moves.push_back(Move(king_sq, to, enemy_pieces.is_bit_set(to) ? MoveType::Capture : MoveType::Normal));
+        }
+    }
+    
+    // Double check: only king moves are legal
+    if (checkers.count_bits() > 1)
+        return;
+    
+    // Squares non-king moves may land on
+    Bitboard target = type_mask;
+    if (checkers.any())
+    {
+        Square checker_sq = static_cast<Square>(checkers.get_lsb_index());
+        target &= Bitboard::between(king_sq, checker_sq) | checkers;
+    }
+    
+    // Knights; a pinned knight can never move
+    Bitboard knights = pos.pieces(Us, PieceType::Knight) & ~pinned;
+    while (knights.any())
+    {
+        Square from = static_cast<Square>(knights.pop_lsb());
+        add_moves(pos, moves, from, Bitboard::knight_attacks(from) & target);
+    }
+    
+    // Sliders
+    Bitboard diagonal = pos.pieces(Us, PieceType::Bishop) | pos.pieces(Us, PieceType::Queen);
+    while (diagonal.any())
+    {
+        Square from = static_cast<Square>(diagonal.pop_lsb());
+        Bitboard attacks = Bitboard::bishop_attacks(from, pos.occupied()) & target;
+        if (pinned.is_bit_set(from))
+            attacks &= Bitboard::line(king_sq, from);
+        add_moves(pos, moves, from, attacks);
+    }
+    
+    Bitboard straight = pos.pieces(Us, PieceType::Rook) | pos.pieces(Us, PieceType::Queen);
+    while (straight.any())
+    {
+        Square from = static_cast<Square>(straight.pop_lsb());
+        Bitboard attacks = Bitboard::rook_attacks(from, pos.occupied()) & target;
+        if (pinned.is_bit_set(from))
+            attacks &= Bitboard::line(king_sq, from);
+        add_moves(pos, moves, from, attacks);
+    }
+    
+    // Pawns. Promotions count as captures, so pushes to the last rank are
+    // generated with the captures and left out of the quiets.
+    Bitboard evasion_mask;
+    if (checkers.any())
+    {
+        Square checker_sq = static_cast<Square>(checkers.get_lsb_index());
+        evasion_mask = Bitboard::between(king_sq, checker_sq) | checkers;
+    }
+    else
+    {
+        evasion_mask = ~Bitboard();
+    }
+    
+    Bitboard pawns = pos.pieces(Us, PieceType::Pawn);
+    while (pawns.any())
+    {
+        Square from = static_cast<Square>(pawns.pop_lsb());
+        
+        Bitboard allowed = evasion_mask;
+        if (pinned.is_bit_set(from))
+            allowed &= Bitboard::line(king_sq, from);
+        
+        // Pushes
+        Square to = static_cast<Square>(static_cast<int>(from) + PushOffset);
+        if (to >= Square::A1 && to <= Square::H8 && empty_squares.is_bit_set(to))
+        {
+            bool promotion = (rank_of(to) == PromoRank);
+            
+            if (allowed.is_bit_set(to) && (promotion ? Captures : Quiets))
+                add_pawn_move<Us>(moves, from, to, MoveType::Normal);
+            
+            if (Quiets && rank_of(from) == StartRank)
+            {
+                Square double_to = static_cast<Square>(static_cast<int>(to) + PushOffset);
+                if (empty_squares.is_bit_set(double_to) && allowed.is_bit_set(double_to))
+                    moves.push_back(Move(from, double_to, MoveType::Normal));
+            }
+        }
         
-        // Determine if we're in check after move
-        Color enemy_color = (pos.side_to_move() == Color::White) ? Color::Black : Color::White;
+        if (!Captures) continue;
         
-        // Get king square from the test position after the move
-        Square our_king = test_pos.king_square(pos.side_to_move());
+        // Captures
+        Bitboard attacks = Bitboard::pawn_attacks(from, Us) & enemy_pieces & allowed;
+        while (attacks.any())
+        {
+            Square cap_sq = static_cast<Square>(attacks.pop_lsb());
+            add_pawn_move<Us>(moves, from, cap_sq, MoveType::Capture);
+        }
+        
+        // En passant can expose the king along the rank of both pawns, so it is
+        // rare enough to check directly
+        Square ep_sq = pos.en_passant_square();
+        if (ep_sq != Square::None && Bitboard::pawn_attacks(from, Us).is_bit_set(ep_sq))
+        {
+            Move ep_move(from, ep_sq, MoveType::EnPassant);
+            if (is_legal(pos, ep_move))
+                moves.push_back(ep_move);
+        }
+    }
+    
+    // Castling is never legal out of check
+    if (Quiets && checkers.empty())
+        generate_castling_moves(pos, moves, Us);
+}
+
+// Staged generation entry point; dispatches on the side to move
+template<GenType Type>
+void MoveGenerator::generate(const Position& pos, MoveList& moves)
+{
+    // Without a king there is nothing to pin to; fall back to filtering
+    if (pos.king_square(pos.side_to_move()) == Square::None)
+    {
+        MoveList legal;
+        generate_legal_moves(pos, legal, LegalityMode::Filter);
+        for (const Move& move : legal)
+        {
+            bool capture = move.move_type() == MoveType::Capture || move.move_type() == MoveType::EnPassant ||
+                           move.move_type() == MoveType::Promotion;
+            if ((Type == GenType::Captures && capture) || (Type == GenType::Quiets && !capture) || 
+                Type == GenType::Legal)
+                moves.push_back(move);
+        }
+        return;
+    }
+    
+    if (Type == GenType::QuietChecks)
+    {
+        MoveList quiets;
+        generate<GenType::Quiets>(pos, quiets);
+        for (const Move& move : quiets)
+        {
+            if (gives_check(pos, move))
+                moves.push_back(move);
+        }
+        return;
+    }
+    
+    if (pos.side_to_move() == Color::White)
+        generate_pin_aware_moves<Color::White, Type>(pos, moves);
+    else
+        generate_pin_aware_moves<Color::Black, Type>(pos, moves);
+}
+
+template void MoveGenerator::generate<GenType::Captures>(const Position&, MoveList&);
+template void MoveGenerator::generate<GenType::Quiets>(const Position&, MoveList&);
+template void MoveGenerator::generate<GenType::Evasions>(const Position&, MoveList&);
+template void MoveGenerator::generate<GenType::QuietChecks>(const Position&, MoveList&);
+template void MoveGenerator::generate<GenType::Legal>(const Position&, MoveList&);
+
+// Add moves from a square to every target square
+void MoveGenerator::add_moves(const Position& pos, MoveList& moves, Square from, Bitboard targets)
+{
+    while (targets.any())
+    {
+        Square to = static_cast<Square>(targets.pop_lsb());
+        moves.push_back(Move(from, to, pos.piece_on(to) != Piece::None ? MoveType::Capture : MoveType::Normal));
+    }
+}
+
+// Add a pawn move; moves to the last rank become four promotions
+template<Color Us>
+void MoveGenerator::add_pawn_move(MoveList& moves, Square from, Square to, MoveType type)
+{
+    constexpr Rank PromoRank = (Us == Color::White) ? Rank::Eight : Rank::One;
+    
+    if (rank_of(to) == PromoRank)
+    {
+        moves.push_back(Move(from, to, MoveType::Promotion, make_piece(Us, PieceType::Queen)));
+        moves.push_back(Move(from, to, MoveType::Promotion, make_piece(Us, PieceType::Rook)));
+        moves.push_back(Move(from, to, MoveType::Promotion, make_piece(Us, PieceType::Bishop)));
+        moves.push_back(Move(from, to, MoveType::Promotion, make_piece(Us, PieceType::Knight)));
+    }
+    else
+    {
+        moves.push_back(Move(from, to, type));
+    }
+}
+
+// Generate legal moves into a vector
+std::vector<Move> MoveGenerator::generate_legal_moves(const Position& pos)
+{
+    MoveList list;
+    generate_legal_moves(pos, list);
+    return std::vector<Move>(list.begin(), list.end());
+}
+
+// Check that a move's piece, target square and type fit the position, so
+// moves from the transposition table or killer slots can be tried before
+// any moves are generated
+bool MoveGenerator::is_pseudo_legal(const Position& pos, const Move& move)
+{
+    if (move.is_none() || move.move_type() == MoveType::Castle)
+        return false;
+    
+    // Flags 8-15 are unused (promotions stop at a queen)
+    if ((move.raw() >> 12) > 7)
+        return false;
+    
+    Color us = pos.side_to_move();
+    Square from = move.from_square();
+    Square to = move.to_square();
+    
+    Piece piece = pos.piece_on(from);
+    if (piece == Piece::None || color_of(piece) != us)
+        return false;
+    
+    // Normal moves need an empty target, captures an enemy piece other than the king
+    Piece target = pos.piece_on(to);
+    bool capture = target != Piece::None;
+    if (capture && (color_of(target) == us || type_of(target) == PieceType::King))
+        return false;
+    
+    MoveType type = move.move_type();
+    if ((type == MoveType::Normal && capture) || (type == MoveType::Capture && !capture))
+        return false;
+    
+    if (type_of(piece) != PieceType::Pawn)
+    {
+        if (type == MoveType::EnPassant || type == MoveType::Promotion)
+            return false;
         
-        // Check if our king is still on board and not in check
-        if (!is_square_attacked(test_pos, our_king, enemy_color))
+        Bitboard attacks;
+        switch (type_of(piece))
         {
-            legal.push_back(move);
+            case PieceType::Knight: attacks = Bitboard::knight_attacks(from); break;
+            case PieceType::Bishop: attacks = Bitboard::bishop_attacks(from, pos.occupied()); break;
+            case PieceType::Rook:   attacks = Bitboard::rook_attacks(from, pos.occupied()); break;
+            case PieceType::Queen:  attacks = Bitboard::queen_attacks(from, pos.occupied()); break;
+            default:                attacks = Bitboard::king_attacks(from); break;
         }
+        return attacks.is_bit_set(to);
     }
     
-    return legal;
+    // Pawns promote exactly when they reach the last rank
+    Rank last_rank = (us == Color::White) ? Rank::Eight : Rank::One;
+    if ((type == MoveType::Promotion) != (rank_of(to) == last_rank))
+        return false;
+    
+    if (type == MoveType::EnPassant)
+        return to == pos.en_passant_square() && Bitboard::pawn_attacks(from, us).is_bit_set(to);
+    
+    if (capture)
+        return Bitboard::pawn_attacks(from, us).is_bit_set(to);
+    
+    // Single push, or double push from the starting rank over an empty square
+    int forward = (us == Color::White) ? 8 : -8;
+    int distance = static_cast<int>(to) - static_cast<int>(from);
+    if (distance == forward)
+        return true;
+    
+    Rank start_rank = (us == Color::White) ? Rank::Two : Rank::Seven;
+    Square middle = static_cast<Square>(static_cast<int>(from) + forward);
+    return distance == 2 * forward && rank_of(from) == start_rank && pos.piece_on(middle) == Piece::None;
+}
+
+// Check whether a pseudo-legal move leaves our king in check. Works on the 
+// occupancy after the move instead of copying the position and making it.
+bool MoveGenerator::is_legal(const Position& pos, const Move& move)
+{
+    Color us = pos.side_to_move();
+    Color them = (us == Color::White) ? Color::Black : Color::White;
+    
+    Square king_sq = pos.king_square(us);
+    
+    // Nothing to expose without a king (test positions)
+    if (king_sq == Square::None)
+        return true;
+    
+    // Castling legality (no check, safe path) is fully checked at generation
+    if (move.move_type() == MoveType::Castle)
+        return true;
+    
+    // The square the captured piece is removed from
+    Square capture_sq = move.to_square();
+    if (move.move_type() == MoveType::EnPassant)
+    {
+        capture_sq = static_cast<Square>(static_cast<int>(move.to_square()) + (us == Color::White ? -8 : 8));
+    }
+    
+    // Occupancy after the move
+    Bitboard occupied = pos.occupied();
+    occupied.clear_bit(move.from_square());
+    occupied.clear_bit(capture_sq);
+    occupied.set_bit(move.to_square());
+    
+    if (move.from_square() == king_sq)
+        king_sq = move.to_square();
+    
+    // Enemy pieces that survive the move
+    Bitboard survivors = ~Bitboard(capture_sq);
+    
+    if ((Bitboard::pawn_attacks(king_sq, us) & pos.pieces(them, PieceType::Pawn) & survivors).any())
+        return false;
+    
+    if ((Bitboard::knight_attacks(king_sq) & pos.pieces(them, PieceType::Knight) & survivors).any())
+        return false;
+    
+    if ((Bitboard::king_attacks(king_sq) & pos.pieces(them, PieceType::King)).any())
+        return false;
+    
+    Bitboard queens = pos.pieces(them, PieceType::Queen);
+    Bitboard diagonal = (pos.pieces(them, PieceType::Bishop) | queens) & survivors;
+    if ((Bitboard::bishop_attacks(king_sq, occupied) & diagonal).any())
+        return false;
+    
+    Bitboard straight = (pos.pieces(them, PieceType::Rook) | queens) & survivors;
+    if ((Bitboard::rook_attacks(king_sq, occupied) & straight).any())
+        return false;
+    
+    return true;
 }
 
 // Knight move generation
-void MoveGenerator::generate_knight_moves(const Position& pos, std::vector<Move>& moves, Color color)
+void MoveGenerator::generate_knight_moves(const Position& pos, MoveList& moves, Color color)
 {
     Bitboard knights = pos.pieces(color, PieceType::Knight);
     Bitboard own_pieces = pos.occupied_by_color(color);
     
-    while (knights.count_bits() > 0)
+    while (knights.any())
     {
         Square from = static_cast<Square>(knights.pop_lsb());
         Bitboard attacks = Bitboard::knight_attacks(from);
@@ -90,7 +446,7 @@ void MoveGenerator::generate_knight_moves(const Position& pos, std::vector<Move>
         // Remove squares occupied by own pieces
         attacks &= ~own_pieces;
         
-        while (attacks.count_bits() > 0)
+        while (attacks.any())
         {
             Square to = static_cast<Square>(attacks.pop_lsb());
             
@@ -107,12 +463,12 @@ void MoveGenerator::generate_knight_moves(const Position& pos, std::vector<Move>
 }
 
 // Bishop move generation
-void MoveGenerator::generate_bishop_moves(const Position& pos, std::vector<Move>& moves, Color color)
+void MoveGenerator::generate_bishop_moves(const Position& pos, MoveList& moves, Color color)
 {
     Bitboard bishops = pos.pieces(color, PieceType::Bishop);
     Bitboard own_pieces = pos.occupied_by_color(color);
     
-    while (bishops.count_bits() > 0)
+    while (bishops.any())
     {
         Square from = static_cast<Square>(bishops.pop_lsb());
         Bitboard attacks = Bitboard::bishop_attacks(from, pos.occupied());
@@ -120,7 +476,7 @@ void MoveGenerator::generate_bishop_moves(const Position& pos, std::vector<Move>
         // Remove squares occupied by own pieces
         attacks &= ~own_pieces;
         
-        while (attacks.count_bits() > 0)
+        while (attacks.any())
         {
             Square to = static_cast<Square>(attacks.pop_lsb());
             
@@ -137,12 +493,12 @@ void MoveGenerator::generate_bishop_moves(const Position& pos, std::vector<Move>
 }
 
 // Rook move generation
-void MoveGenerator::generate_rook_moves(const Position& pos, std::vector<Move>& moves, Color color)
+void MoveGenerator::generate_rook_moves(const Position& pos, MoveList& moves, Color color)
 {
     Bitboard rooks = pos.pieces(color, PieceType::Rook);
     Bitboard own_pieces = pos.occupied_by_color(color);
     
-    while (rooks.count_bits() > 0)
+    while (rooks.any())
     {
         Square from = static_cast<Square>(rooks.pop_lsb());
         Bitboard attacks = Bitboard::rook_attacks(from, pos.occupied());
@@ -150,7 +506,7 @@ void MoveGenerator::generate_rook_moves(const Position& pos, std::vector<Move>&
         // Remove squares occupied by own pieces
         attacks &= ~own_pieces;
         
-        while (attacks.count_bits() > 0)
+        while (attacks.any())
         {
             Square to = static_cast<Square>(attacks.pop_lsb());
             
@@ -167,12 +523,12 @@ void MoveGenerator::generate_rook_moves(const Position& pos, std::vector<Move>&
 }
 
 // Queen move generation
-void MoveGenerator::generate_queen_moves(const Position& pos, std::vector<Move>& moves, Color color)
+void MoveGenerator::generate_queen_moves(const Position& pos, MoveList& moves, Color color)
 {
     Bitboard queens = pos.pieces(color, PieceType::Queen);
     Bitboard own_pieces = pos.occupied_by_color(color);
     
-    while (queens.count_bits() > 0)
+    while (queens.any())
     {
         Square from = static_cast<Square>(queens.pop_lsb());
         Bitboard attacks = Bitboard::queen_attacks(from, pos.occupied());
@@ -180,7 +536,7 @@ void MoveGenerator::generate_queen_moves(const Position& pos, std::vector<Move>&
         // Remove squares occupied by own pieces
         attacks &= ~own_pieces;
         
-        while (attacks.count_bits() > 0)
+        while (attacks.any())
         {
             Square to = static_cast<Square>(attacks.pop_lsb());
             
@@ -197,13 +553,13 @@ void MoveGenerator::generate_queen_moves(const Position& pos, std::vector<Move>&
 }
 
 // King move generation (excluding castling)
-void MoveGenerator::generate_king_moves(const Position& pos, std::vector<Move>& moves, Color color)
+void MoveGenerator::generate_king_moves(const Position& pos, MoveList& moves, Color color)
 {
     Bitboard kings = pos.pieces(color, PieceType::King);
     Bitboard own_pieces = pos.occupied_by_color(color);
     
     // There should be exactly one king
-    if (kings.count_bits() > 0)
+    if (kings.any())
     {
         Square from = static_cast<Square>(kings.pop_lsb());
         Bitboard attacks = Bitboard::king_attacks(from);
@@ -211,7 +567,7 @@ void MoveGenerator::generate_king_moves(const Position& pos, std::vector<Move>&
         // Remove squares occupied by own pieces
         attacks &= ~own_pieces;
         
-        while (attacks.count_bits() > 0)
+        while (attacks.any())
         {
             Square to = static_cast<Square>(attacks.pop_lsb());
             
@@ -228,7 +584,7 @@ void MoveGenerator::generate_king_moves(const Position& pos, std::vector<Move>&
 }
 
 // Castling move generation
-void MoveGenerator::generate_castling_moves(const Position& pos, std::vector<Move>& moves, Color color)
+void MoveGenerator::generate_castling_moves(const Position& pos, MoveList& moves, Color color)
 {
     // Check if king is in check - can't castle out of check
     if (pos.is_in_check())
@@ -328,7 +684,7 @@ void MoveGenerator::generate_castling_moves(const Position& pos, std::vector<Mov
 }
 
 // Generate pawn moves
-void MoveGenerator::generate_pawn_moves(const Position& pos, std::vector<Move>& moves, Color color)
+void MoveGenerator::generate_pawn_moves(const Position& pos, MoveList& moves, Color color)
 {
     Bitboard pawns = pos.pieces(color, PieceType::Pawn);
     Bitboard own_pieces = pos.occupied_by_color(color);
@@ -342,7 +698,7 @@ void MoveGenerator::generate_pawn_moves(const Position& pos, std::vector<Move>&
     Rank start_rank = (color == Color::White) ? Rank::Two : Rank::Seven;
     Rank promo_rank = (color == Color::White) ? Rank::Eight : Rank::One;
     
-    while (pawns.count_bits() > 0)
+    while (pawns.any())
     {
         Square from = static_cast<Square>(pawns.pop_lsb());
         Rank from_rank = rank_of(from);
@@ -379,7 +735,7 @@ void MoveGenerator::generate_pawn_moves(const Position& pos, std::vector<Move>&
         Bitboard attacks = Bitboard::pawn_attacks(from, color);
         attacks &= enemy_pieces;  // Can only capture enemy pieces
         
-        while (attacks.count_bits() > 0)
+        while (attacks.any())
         {
             Square cap_sq = static_cast<Square>(attacks.pop_lsb());
             
@@ -461,22 +817,22 @@ bool MoveGenerator::is_square_attacked(const Position& pos, Square square, Color
     
     // Check knight attacks
     Bitboard knight_attackers = Bitboard::knight_attacks(square);
-    if ((knight_attackers & pos.pieces(by_color, PieceType::Knight)).count_bits() > 0)
+    if ((knight_attackers & pos.pieces(by_color, PieceType::Knight)).any())
         return true;
     
     // Check king attacks
     Bitboard king_attackers = Bitboard::king_attacks(square);
-    if ((king_attackers & pos.pieces(by_color, PieceType::King)).count_bits() > 0)
+    if ((king_attackers & pos.pieces(by_color, PieceType::King)).any())
         return true;
     
     // Check bishop/queen attacks (diagonal)
     Bitboard bishop_attackers = Bitboard::bishop_attacks(square, pos.occupied());
-    if ((bishop_attackers & (pos.pieces(by_color, PieceType::Bishop) | pos.pieces(by_color, PieceType::Queen))).count_bits() > 0)
+    if ((bishop_attackers & (pos.pieces(by_color, PieceType::Bishop) | pos.pieces(by_color, PieceType::Queen))).any())
         return true;
     
     // Check rook/queen attacks (straight)
     Bitboard rook_attackers = Bitboard::rook_attacks(square, pos.occupied());
-    if ((rook_attackers & (pos.pieces(by_color, PieceType::Rook) | pos.pieces(by_color, PieceType::Queen))).count_bits() > 0)
+    if ((rook_attackers & (pos.pieces(by_color, PieceType::Rook) | pos.pieces(by_color, PieceType::Queen))).any())
         return true;
     
     return false;
@@ -540,4 +896,275 @@ Bitboard MoveGenerator::get_attackers_to(const Position& pos, Square square, Col
     attackers |= rook_attacks & (pos.pieces(by_color, PieceType::Rook) | pos.pieces(by_color, PieceType::Queen));
     
     return attackers;
-}
\ No newline at end of file
+}
+
+// Get all pieces of a color pinned to their king. A piece is pinned when it is
+// the only piece between the king and an enemy slider aligned with it.
+Bitboard MoveGenerator::get_pinned_pieces(const Position& pos, Color color)
+{
+    Bitboard pinned;
+    Square king_sq = pos.king_square(color);
+    if (king_sq == Square::None)
+        return pinned;
+    
+    Color enemy = (color == Color::White) ? Color::Black : Color::White;
+    Bitboard queens = pos.pieces(enemy, PieceType::Queen);
+    
+    // Enemy sliders that would attack the king on an empty board
+    Bitboard snipers = (Bitboard::rook_attacks(king_sq, Bitboard()) & (pos.pieces(enemy, PieceType::Rook) | queens)) |
+                       (Bitboard::bishop_attacks(king_sq, Bitboard()) & (pos.pieces(enemy, PieceType::Bishop) | queens));
+    
+    while (snipers.any())
+    {
+        Square sniper_sq = static_cast<Square>(snipers.pop_lsb());
+        Bitboard blockers = Bitboard::between(king_sq, sniper_sq) & pos.occupied();
+        
+        if (blockers.count_bits() == 1 && (blockers & pos.occupied_by_color(color)).any())
+            pinned |= blockers;
+    }
+    
+    return pinned;
+}
+
+// Get all attackers of a color to a square for a given occupancy
+Bitboard MoveGenerator::attackers_to(const Position& pos, Square square, Color by_color, Bitboard occupied)
+{
+    Color defender = (by_color == Color::White) ? Color::Black : Color::White;
+    Bitboard queens = pos.pieces(by_color, PieceType::Queen);
+    
+    // A pawn of ours on the square would attack exactly the squares enemy pawns attack it from
+    return (Bitboard::pawn_attacks(square, defender) & pos.pieces(by_color, PieceType::Pawn)) |
+           (Bitboard::knight_attacks(square) & pos.pieces(by_color, PieceType::Knight)) |
+           (Bitboard::king_attacks(square) & pos.pieces(by_color, PieceType::King)) |
+           (Bitboard::bishop_attacks(square, occupied) & (pos.pieces(by_color, PieceType::Bishop) | queens)) |
+           (Bitboard::rook_attacks(square, occupied) & (pos.pieces(by_color, PieceType::Rook) | queens));
+}
+
+// Check whether a move gives check. Looks for a direct attack from the moved
+// piece (or the castling rook) and for a slider uncovered by the move.
+bool MoveGenerator::gives_check(const Position& pos, const Move& move)
+{
+    Color us = pos.side_to_move();
+    Color them = (us == Color::White) ? Color::Black : Color::White;
+    Square king_sq = pos.king_square(them);
+    if (king_sq == Square::None)
+        return false;
+    
+    Square from = move.from_square();
+    Square to = move.to_square();
+    
+    // Occupancy after the move
+    Bitboard occupied = pos.occupied();
+    occupied.clear_bit(from);
+    occupied.set_bit(to);
+    if (move.move_type() == MoveType::EnPassant)
+        occupied.clear_bit(static_cast<Square>(static_cast<int>(to) + (us == Color::White ? -8 : 8)));
+    
+    // Direct check from the moved piece
+    PieceType type = (move.move_type() == MoveType::Promotion) ? type_of(move.promotion_piece()) 
+                                                               : type_of(pos.piece_on(from));
+    switch (type)
+    {
+        case PieceType::Pawn:
+            if (Bitboard::pawn_attacks(to, us).is_bit_set(king_sq)) return true;
+            break;
+        case PieceType::Knight:
+            if (Bitboard::knight_attacks(to).is_bit_set(king_sq)) return true;
+            break;
+        case PieceType::Bishop:
+            if (Bitboard::bishop_attacks(to, occupied).is_bit_set(king_sq)) return true;
+            break;
+        case PieceType::Rook:
+            if (Bitboard::rook_attacks(to, occupied).is_bit_set(king_sq)) return true;
+            break;
+        case PieceType::Queen:
+            if (Bitboard::queen_attacks(to, occupied).is_bit_set(king_sq)) return true;
+            break;
+        default:
+            break;
+    }
+    
+    // Pieces that left their squares can't give discovered check
+    Bitboard vacated(from);
+    
+    // Castling checks come from the rook on its new square
+    if (move.move_type() == MoveType::Castle)
+    {
+        bool kingside = file_of(to) == File::G;
+        Square rook_from = make_square(kingside ? File::H : File::A, rank_of(to));
+        Square rook_to = make_square(kingside ? File::F : File::D, rank_of(to));
+        occupied.clear_bit(rook_from);
+        occupied.set_bit(rook_to);
+        vacated.set_bit(rook_from);
+        if (Bitboard::rook_attacks(rook_to, occupied).is_bit_set(king_sq)) return true;
+    }
+    
+    // Discovered check from our sliders
+    Bitboard queens = pos.pieces(us, PieceType::Queen);
+    Bitboard diagonal = (pos.pieces(us, PieceType::Bishop) | queens) & ~vacated;
+    Bitboard straight = (pos.pieces(us, PieceType::Rook) | queens) & ~vacated;
+    
+    return (Bitboard::bishop_attacks(king_sq, occupied) & diagonal).any() ||
+           (Bitboard::rook_attacks(king_sq, occupied) & straight).any();
+}
+
+// Value gained by the move itself: the captured piece plus any promotion gain
+static int see_move_gain(const Position& pos, const Move& move)
+{
+    int gain = 0;
+    if (move.move_type() == MoveType::EnPassant)
+        gain = SEE_VALUES[static_cast<int>(PieceType::Pawn)];
+    else if (pos.piece_on(move.to_square()) != Piece::None)
+        gain = SEE_VALUES[static_cast<int>(type_of(pos.piece_on(move.to_square())))];
+    
+    if (move.move_type() == MoveType::Promotion)
+        gain += SEE_VALUES[static_cast<int>(type_of(move.promotion_piece()))] - SEE_VALUES[static_cast<int>(PieceType::Pawn)];
+    
+    return gain;
+}
+
+// Value of the piece left standing on the target square after the move
+static int see_moved_value(const Position& pos, const Move& move)
+{
+    PieceType moved = (move.move_type() == MoveType::Promotion) ? type_of(move.promotion_piece()) 
+                                                                 : type_of(pos.piece_on(move.from_square()));
+    return SEE_VALUES[static_cast<int>(moved)];
+}
+
+// Occupancy once the move is made (the moving piece stays on the target)
+static Bitboard see_occupancy(const Position& pos, const Move& move)
+{
+    Bitboard occupied = pos.occupied();
+    occupied.clear_bit(move.from_square());
+    occupied.set_bit(move.to_square());
+    if (move.move_type() == MoveType::EnPassant)
+    {
+        int behind = (pos.side_to_move() == Color::White) ? -8 : 8;
+        occupied.clear_bit(static_cast<Square>(static_cast<int>(move.to_square()) + behind));
+    }
+    return occupied;
+}
+
+// Remove the least valuable attacker of a side from the occupancy, add any
+// slider it uncovers to the attackers and return its type
+PieceType MoveGenerator::pop_least_valuable_attacker(const Position& pos, Square square, Bitboard side_attackers,
+                                                    Bitboard& occupied, Bitboard& attackers)
+{
+    Bitboard diagonal = pos.pieces(Color::White, PieceType::Bishop) | pos.pieces(Color::Black, PieceType::Bishop) |
+                        pos.pieces(Color::White, PieceType::Queen) | pos.pieces(Color::Black, PieceType::Queen);
+    Bitboard straight = pos.pieces(Color::White, PieceType::Rook) | pos.pieces(Color::Black, PieceType::Rook) |
+                        pos.pieces(Color::White, PieceType::Queen) | pos.pieces(Color::Black, PieceType::Queen);
+    
+    for (int pt = static_cast<int>(PieceType::Pawn); pt <= static_cast<int>(PieceType::King); pt++)
+    {
+        PieceType type = static_cast<PieceType>(pt);
+        Bitboard candidates = side_attackers & (pos.pieces(Color::White, type) | pos.pieces(Color::Black, type));
+        if (candidates.empty())
+            continue;
+        
+        occupied.clear_bit(static_cast<Square>(candidates.get_lsb_index()));
+        
+        // X-rays: a slider behind the captured-from square now reaches the target
+        if (type == PieceType::Pawn || type == PieceType::Bishop || type == PieceType::Queen)
+            attackers |= Bitboard::bishop_attacks(square, occupied) & diagonal;
+        if (type == PieceType::Rook || type == PieceType::Queen)
+            attackers |= Bitboard::rook_attacks(square, occupied) & straight;
+        
+        attackers &= occupied;
+        return type;
+    }
+    
+    return PieceType::NB;
+}
+
+int MoveGenerator::see(const Position& pos, const Move& move)
+{
+    if (move.move_type() == MoveType::Castle)
+        return 0;
+    
+    Square to = move.to_square();
+    Bitboard occupied = see_occupancy(pos, move);
+    Bitboard attackers = (attackers_to(pos, to, Color::White, occupied) | 
+                          attackers_to(pos, to, Color::Black, occupied)) & occupied;
+    
+    // gain[d] is the balance for the side making capture d if the
+    // sequence stops after it
+    int gain[32];
+    int d = 0;
+    gain[0] = see_move_gain(pos, move);
+    int on_square = see_moved_value(pos, move);
+    Color side = (pos.side_to_move() == Color::White) ? Color::Black : Color::White;
+    
+    while (d < 31)
+    {
+        Bitboard side_attackers = attackers & pos.occupied_by_color(side);
+        if (side_attackers.empty())
+            break;
+        
+        d++;
+        gain[d] = on_square - gain[d - 1];
+        on_square = SEE_VALUES[static_cast<int>(pop_least_valuable_attacker(pos, to, side_attackers, occupied, attackers))];
+        side = (side == Color::White) ? Color::Black : Color::White;
+    }
+    
+    // Either side may stop capturing when continuing would lose material
+    while (d > 0)
+    {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+    
+    return gain[0];
+}
+
+// Swap algorithm on a running balance: after each capture, check whether
+// the side to move can already stop at a result on its side of the threshold
+bool MoveGenerator::see_ge(const Position& pos, const Move& move, int threshold)
+{
+    if (move.move_type() == MoveType::Castle)
+        return threshold <= 0;
+    
+    // Even if the moved piece is lost for nothing, the gain must reach the threshold
+    int swap = see_move_gain(pos, move) - threshold;
+    if (swap < 0)
+        return false;
+    
+    // If it is not lost, the threshold is met
+    swap = see_moved_value(pos, move) - swap;
+    if (swap <= 0)
+        return true;
+    
+    Square to = move.to_square();
+    Bitboard occupied = see_occupancy(pos, move);
+    Bitboard attackers = (attackers_to(pos, to, Color::White, occupied) | 
+                          attackers_to(pos, to, Color::Black, occupied)) & occupied;
+    
+    Color side = pos.side_to_move();
+    bool result = true;
+    
+    while (true)
+    {
+        side = (side == Color::White) ? Color::Black : Color::White;
+        Bitboard side_attackers = attackers & pos.occupied_by_color(side);
+        if (side_attackers.empty())
+            break;
+        
+        result = !result;
+        
+        PieceType type = pop_least_valuable_attacker(pos, to, side_attackers, occupied, attackers);
+        
+        // A king may only capture if the square is no longer defended
+        if (type == PieceType::King)
+        {
+            Color other = (side == Color::White) ? Color::Black : Color::White;
+            return (attackers & pos.occupied_by_color(other)).any() ? !result : result;
+        }
+        
+        swap = SEE_VALUES[static_cast<int>(type)] - swap;
+        if (swap < static_cast<int>(result))
+            break;
+    }
+    
+    return result;
+}
+
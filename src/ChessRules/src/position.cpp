@@ -10,7 +10,10 @@
 #include "bitboard.h"
 #include "movegen.h"
 #include "position.h"
+#include "ChessEngine/include/psqt.h"
 #include "ChessEngine/include/zobrist.h"
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <sstream>
 
@@ -24,6 +27,9 @@ Position::Position()
     
     // Initialize Zobrist hash tables
     ZobristHash::initialize();
+    
+    // Initialize the material and piece-square tables
+    PieceSquareTable::initialize();
 
     // Initialize to empty
     for (int c = 0; c < static_cast<int>(Color::NB); ++c)
@@ -42,11 +48,54 @@ Position::Position()
     }
     
     hash_key_ = 0;
+    pawn_key_ = 0;
+    psq_score_ = Score();
+    game_phase_ = 0;
+    state_count_ = 0;
     
     // Load starting position
     load_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
 }
 
+// Copy constructor; copies only the used part of the undo stack
+Position::Position(const Position& other)
+{
+    *this = other;
+}
+
+// Copy assignment; copies only the used part of the undo stack
+Position& Position::operator=(const Position& other)
+{
+    if (this == &other) return *this;
+    
+    std::copy(&other.pieces_[0][0], &other.pieces_[0][0] + static_cast<int>(Color::NB) * static_cast<int>(PieceType::NB), &pieces_[0][0]);
+    std::copy(other.occupied_by_color_, other.occupied_by_color_ + static_cast<int>(Color::NB), occupied_by_color_);
+    occupied_ = other.occupied_;
+    std::copy(other.board_, other.board_ + static_cast<int>(Square::NB), board_);
+    
+    side_to_move_ = other.side_to_move_;
+    castling_rights_ = other.castling_rights_;
+    en_passant_square_ = other.en_passant_square_;
+    halfmove_clock_ = other.halfmove_clock_;
+    fullmove_number_ = other.fullmove_number_;
+    
+    state_count_ = other.state_count_;
+    std::copy(other.states_, other.states_ + other.state_count_, states_);
+    
+    hash_key_ = other.hash_key_;
+    pawn_key_ = other.pawn_key_;
+    psq_score_ = other.psq_score_;
+    game_phase_ = other.game_phase_;
+    
+    return *this;
+}
+
+// Delegate to MoveGenerator
+void Position::generate_legal_moves(MoveList& moves) const
+{
+    MoveGenerator::generate_legal_moves(*this, moves);
+}
+
 // Delegate to MoveGenerator
 std::vector<Move> Position::generate_legal_moves() const
 {
@@ -84,7 +133,7 @@ bool Position::load_fen(const std::string& fen)
     }
     
     // Clear move history when loading a new position
-    move_history_.clear();
+    state_count_ = 0;
     
     // Parse board
     int rank = 7;  // Start from rank 8
@@ -150,8 +199,11 @@ bool Position::load_fen(const std::string& fen)
     // Update aggregate bitboards
     update_bitboards();
     
-    // Compute hash key for the loaded position
+    // Compute hash key and evaluation terms for the loaded position
     hash_key_ = ZobristHash::hash_position(*this);
+    pawn_key_ = ZobristHash::hash_pawns(*this);
+    psq_score_ = PieceSquareTable::compute_score(*this);
+    game_phase_ = PieceSquareTable::compute_phase(*this);
     
     return true;
 }
@@ -300,7 +352,7 @@ void Position::print_board() const
     
     std::cout << "    a   b   c   d   e   f   g   h\n\n";
     std::cout << "Side to move: " << (side_to_move_ == Color::White ? "White" : "Black") << "\n";
-    std::cout << "Move history: " << move_history_.size() << " moves\n";
+    std::cout << "Move history: " << state_count_ << " moves\n";
 }
 
 // Get king square
@@ -321,27 +373,43 @@ bool Position::is_in_check() const
 // Make a move (handles all move types)
 void Position::make_move(const Move& move)
 {
-    // Create a copy of the move that we'll store in history
-    Move move_with_state = move;
+    // A full stack drops its oldest entry; only undo that far back is lost
+    if (state_count_ == MAX_GAME_PLY)
+    {
+        std::copy(states_ + 1, states_ + MAX_GAME_PLY, states_);
+        state_count_--;
+    }
     
     // Store previous state for undoing
-    move_with_state.previous_castling_rights = castling_rights_;
-    move_with_state.previous_en_passant_square = en_passant_square_;
-    move_with_state.previous_halfmove_clock = halfmove_clock_;
-    
-    Piece moving_piece = piece_on(move.from_square);
-    Piece captured_piece = piece_on(move.to_square);
-    move_with_state.captured_piece = captured_piece;
+    StateInfo& st = states_[state_count_];
+    st.move = move;
+    st.castling_rights = castling_rights_;
+    st.en_passant_square = en_passant_square_;
+    st.halfmove_clock = halfmove_clock_;
+    st.hash_key = hash_key_;
+    st.pawn_key = pawn_key_;
+    st.psq_score = psq_score_;
+    st.game_phase = game_phase_;
+    st.dirty_count = 0;
+    
+    uint8_t previous_castling_rights = castling_rights_;
+    
+    Piece moving_piece = piece_on(move.from_square());
+    Piece captured_piece = piece_on(move.to_square());
+    st.captured_piece = captured_piece;
     
     Color color = color_of(moving_piece);
     PieceType type = type_of(moving_piece);
     
     // Remove piece from source square
-    pieces_[static_cast<int>(color)][static_cast<int>(type)].clear_bit(move.from_square);
-    board_[static_cast<int>(move.from_square)] = Piece::None;
+    pieces_[static_cast<int>(color)][static_cast<int>(type)].clear_bit(move.from_square());
+    board_[static_cast<int>(move.from_square())] = Piece::None;
+    hash_key_ ^= ZobristHash::piece_hash(moving_piece, move.from_square());
+    psq_score_ -= PieceSquareTable::value(moving_piece, move.from_square());
+    if (type == PieceType::Pawn) pawn_key_ ^= ZobristHash::piece_hash(moving_piece, move.from_square());
     
     // Handle different move types
-    switch (move.move_type)
+    switch (move.move_type())
     {
         case MoveType::Normal:
         case MoveType::Capture:
@@ -350,7 +418,12 @@ void Position::make_move(const Move& move)
             {
                 Color cap_color = color_of(captured_piece);
                 PieceType cap_type = type_of(captured_piece);
-                pieces_[static_cast<int>(cap_color)][static_cast<int>(cap_type)].clear_bit(move.to_square);
+                pieces_[static_cast<int>(cap_color)][static_cast<int>(cap_type)].clear_bit(move.to_square());
+                hash_key_ ^= ZobristHash::piece_hash(captured_piece, move.to_square());
+                psq_score_ -= PieceSquareTable::value(captured_piece, move.to_square());
+                game_phase_ -= PieceSquareTable::phase(captured_piece);
+                if (cap_type == PieceType::Pawn) pawn_key_ ^= ZobristHash::piece_hash(captured_piece, move.to_square());
+                add_dirty_piece(st, captured_piece, move.to_square(), Square::None);
                 halfmove_clock_ = 0;  // Reset on capture
             }
             else if (type != PieceType::Pawn)
@@ -363,29 +436,36 @@ void Position::make_move(const Move& move)
             }
             
             // Place piece on destination square
-            pieces_[static_cast<int>(color)][static_cast<int>(type)].set_bit(move.to_square);
-            board_[static_cast<int>(move.to_square)] = moving_piece;
+            pieces_[static_cast<int>(color)][static_cast<int>(type)].set_bit(move.to_square());
+            board_[static_cast<int>(move.to_square())] = moving_piece;
+            hash_key_ ^= ZobristHash::piece_hash(moving_piece, move.to_square());
+            psq_score_ += PieceSquareTable::value(moving_piece, move.to_square());
+            if (type == PieceType::Pawn) pawn_key_ ^= ZobristHash::piece_hash(moving_piece, move.to_square());
+            add_dirty_piece(st, moving_piece, move.from_square(), move.to_square());
             break;
             
         case MoveType::Castle:
         {
             // Move king
-            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::King)].set_bit(move.to_square);
-            board_[static_cast<int>(move.to_square)] = moving_piece;
+            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::King)].set_bit(move.to_square());
+            board_[static_cast<int>(move.to_square())] = moving_piece;
+            hash_key_ ^= ZobristHash::piece_hash(moving_piece, move.to_square());
+            psq_score_ += PieceSquareTable::value(moving_piece, move.to_square());
+            add_dirty_piece(st, moving_piece, move.from_square(), move.to_square());
             
             // Move rook
             Square rook_from, rook_to;
-            if (move.to_square == Square::G1)  // White kingside
+            if (move.to_square() == Square::G1)  // White kingside
             {
                 rook_from = Square::H1;
                 rook_to = Square::F1;
             }
-            else if (move.to_square == Square::C1)  // White queenside
+            else if (move.to_square() == Square::C1)  // White queenside
             {
                 rook_from = Square::A1;
                 rook_to = Square::D1;
             }
-            else if (move.to_square == Square::G8)  // Black kingside
+            else if (move.to_square() == Square::G8)  // Black kingside
             {
                 rook_from = Square::H8;
                 rook_to = Square::F8;
@@ -402,6 +482,10 @@ void Position::make_move(const Move& move)
             pieces_[static_cast<int>(color)][static_cast<int>(PieceType::Rook)].set_bit(rook_to);
             board_[static_cast<int>(rook_from)] = Piece::None;
             board_[static_cast<int>(rook_to)] = rook;
+            hash_key_ ^= ZobristHash::piece_hash(rook, rook_from) ^ ZobristHash::piece_hash(rook, rook_to);
+            add_dirty_piece(st, rook, rook_from, rook_to);
+            psq_score_ -= PieceSquareTable::value(rook, rook_from);
+            psq_score_ += PieceSquareTable::value(rook, rook_to);
             
             halfmove_clock_++;
             break;
@@ -410,26 +494,34 @@ void Position::make_move(const Move& move)
         case MoveType::EnPassant:
         {
             // Place pawn on destination
-            pieces_[static_cast<int>(color)][static_cast<int>(type)].set_bit(move.to_square);
-            board_[static_cast<int>(move.to_square)] = moving_piece;
+            pieces_[static_cast<int>(color)][static_cast<int>(type)].set_bit(move.to_square());
+            board_[static_cast<int>(move.to_square())] = moving_piece;
+            hash_key_ ^= ZobristHash::piece_hash(moving_piece, move.to_square());
+            psq_score_ += PieceSquareTable::value(moving_piece, move.to_square());
+            pawn_key_ ^= ZobristHash::piece_hash(moving_piece, move.to_square());
+            add_dirty_piece(st, moving_piece, move.from_square(), move.to_square());
             
             // Remove captured pawn (it's not on the destination square)
             Square captured_pawn_sq;
             if (color == Color::White)
             {
-                captured_pawn_sq = static_cast<Square>(static_cast<int>(move.to_square) - 8);
+                captured_pawn_sq = static_cast<Square>(static_cast<int>(move.to_square()) - 8);
             }
             else
             {
-                captured_pawn_sq = static_cast<Square>(static_cast<int>(move.to_square) + 8);
+                captured_pawn_sq = static_cast<Square>(static_cast<int>(move.to_square()) + 8);
             }
             
             // Store the captured pawn for undo
             Color enemy_color = opposite_color(color);
-            move_with_state.captured_piece = make_piece(enemy_color, PieceType::Pawn);
+            st.captured_piece = make_piece(enemy_color, PieceType::Pawn);
             
             pieces_[static_cast<int>(enemy_color)][static_cast<int>(PieceType::Pawn)].clear_bit(captured_pawn_sq);
             board_[static_cast<int>(captured_pawn_sq)] = Piece::None;
+            hash_key_ ^= ZobristHash::piece_hash(st.captured_piece, captured_pawn_sq);
+            psq_score_ -= PieceSquareTable::value(st.captured_piece, captured_pawn_sq);
+            pawn_key_ ^= ZobristHash::piece_hash(st.captured_piece, captured_pawn_sq);
+            add_dirty_piece(st, st.captured_piece, captured_pawn_sq, Square::None);
             
             halfmove_clock_ = 0;  // Reset on pawn move
             break;
@@ -441,13 +533,22 @@ void Position::make_move(const Move& move)
             {
                 Color cap_color = color_of(captured_piece);
                 PieceType cap_type = type_of(captured_piece);
-                pieces_[static_cast<int>(cap_color)][static_cast<int>(cap_type)].clear_bit(move.to_square);
+                pieces_[static_cast<int>(cap_color)][static_cast<int>(cap_type)].clear_bit(move.to_square());
+                hash_key_ ^= ZobristHash::piece_hash(captured_piece, move.to_square());
+                psq_score_ -= PieceSquareTable::value(captured_piece, move.to_square());
+                game_phase_ -= PieceSquareTable::phase(captured_piece);
+                add_dirty_piece(st, captured_piece, move.to_square(), Square::None);
             }
             
             // Place promoted piece
-            PieceType promo_type = type_of(move.promotion_piece);
-            pieces_[static_cast<int>(color)][static_cast<int>(promo_type)].set_bit(move.to_square);
-            board_[static_cast<int>(move.to_square)] = move.promotion_piece;
+            PieceType promo_type = type_of(move.promotion_piece());
+            pieces_[static_cast<int>(color)][static_cast<int>(promo_type)].set_bit(move.to_square());
+            board_[static_cast<int>(move.to_square())] = move.promotion_piece();
+            hash_key_ ^= ZobristHash::piece_hash(move.promotion_piece(), move.to_square());
+            psq_score_ += PieceSquareTable::value(move.promotion_piece(), move.to_square());
+            game_phase_ += PieceSquareTable::phase(move.promotion_piece());
+            add_dirty_piece(st, moving_piece, move.from_square(), Square::None);
+            add_dirty_piece(st, move.promotion_piece(), Square::None, move.to_square());
             
             halfmove_clock_ = 0;  // Reset on pawn move
             break;
@@ -470,53 +571,60 @@ void Position::make_move(const Move& move)
     }
     
     // Remove castling rights if rook moves from original square
-    if (move.from_square == Square::A1)
+    if (move.from_square() == Square::A1)
         castling_rights_ &= ~(1 << static_cast<int>(CastlingRights::White_OOO));
-    if (move.from_square == Square::H1)
+    if (move.from_square() == Square::H1)
         castling_rights_ &= ~(1 << static_cast<int>(CastlingRights::White_OO));
-    if (move.from_square == Square::A8)
+    if (move.from_square() == Square::A8)
         castling_rights_ &= ~(1 << static_cast<int>(CastlingRights::Black_OOO));
-    if (move.from_square == Square::H8)
+    if (move.from_square() == Square::H8)
         castling_rights_ &= ~(1 << static_cast<int>(CastlingRights::Black_OO));
     
     // Remove castling rights if rook is captured on original square
-    if (move.to_square == Square::A1)
+    if (move.to_square() == Square::A1)
         castling_rights_ &= ~(1 << static_cast<int>(CastlingRights::White_OOO));
-    if (move.to_square == Square::H1)
+    if (move.to_square() == Square::H1)
         castling_rights_ &= ~(1 << static_cast<int>(CastlingRights::White_OO));
-    if (move.to_square == Square::A8)
+    if (move.to_square() == Square::A8)
         castling_rights_ &= ~(1 << static_cast<int>(CastlingRights::Black_OOO));
-    if (move.to_square == Square::H8)
+    if (move.to_square() == Square::H8)
         castling_rights_ &= ~(1 << static_cast<int>(CastlingRights::Black_OO));
     
+    // Hash out the old castling rights and in the new ones
+    hash_key_ ^= ZobristHash::castling_hash(previous_castling_rights) ^ ZobristHash::castling_hash(castling_rights_);
+    
     // Update en passant square
+    hash_key_ ^= ZobristHash::en_passant_hash(en_passant_square_);
     en_passant_square_ = Square::None;
     
     // Set en passant square if pawn double push
     if (type == PieceType::Pawn)
     {
-        int from_rank = static_cast<int>(rank_of(move.from_square));
-        int to_rank = static_cast<int>(rank_of(move.to_square));
+        int from_rank = static_cast<int>(rank_of(move.from_square()));
+        int to_rank = static_cast<int>(rank_of(move.to_square()));
         
         if (abs(to_rank - from_rank) == 2)
         {
             // Set en passant square to the square behind the pawn
             if (color == Color::White)
             {
-                en_passant_square_ = static_cast<Square>(static_cast<int>(move.to_square) - 8);
+                en_passant_square_ = static_cast<Square>(static_cast<int>(move.to_square()) - 8);
             }
             else
             {
-                en_passant_square_ = static_cast<Square>(static_cast<int>(move.to_square) + 8);
+                en_passant_square_ = static_cast<Square>(static_cast<int>(move.to_square()) + 8);
             }
         }
     }
     
+    hash_key_ ^= ZobristHash::en_passant_hash(en_passant_square_);
+    
     // Update aggregate bitboards
     update_bitboards();
     
     // Switch side to move
     side_to_move_ = opposite_color(side_to_move_);
+    hash_key_ ^= ZobristHash::side_to_move_hash();
     
     // Increment fullmove number after black's move
     if (side_to_move_ == Color::White)
@@ -524,25 +632,29 @@ void Position::make_move(const Move& move)
         fullmove_number_++;
     }
     
-    // Add the move to history
-    move_history_.push_back(move_with_state);
+    // Push the state onto the undo stack
+    state_count_++;
     
-    // Update hash key (recompute from current position after move is made)
-    hash_key_ = ZobristHash::hash_position(*this);
+    // The incremental hash and evaluation terms must always match a full recomputation
+    assert(hash_key_ == ZobristHash::hash_position(*this));
+    assert(pawn_key_ == ZobristHash::hash_pawns(*this));
+    assert(psq_score_ == PieceSquareTable::compute_score(*this));
+    assert(game_phase_ == PieceSquareTable::compute_phase(*this));
 }
 
 // Undo the last move
 void Position::undo_move()
 {
     // Check if there's a move to undo
-    if (move_history_.empty())
+    if (state_count_ == 0)
     {
         std::cerr << "Warning: No moves to undo!\n";
         return;
     }
     
     // Get the last move from history
-    const Move& move = move_history_.back();
+    const StateInfo& st = states_[state_count_ - 1];
+    const Move move = st.move;
     
     // Switch side to move back
     side_to_move_ = opposite_color(side_to_move_);
@@ -554,13 +666,13 @@ void Position::undo_move()
     }
     
     // Restore previous state
-    castling_rights_ = move.previous_castling_rights;
-    en_passant_square_ = move.previous_en_passant_square;
-    halfmove_clock_ = move.previous_halfmove_clock;
+    castling_rights_ = st.castling_rights;
+    en_passant_square_ = st.en_passant_square;
+    halfmove_clock_ = st.halfmove_clock;
     
     // Get the piece that was moved
     Piece moving_piece;
-    if (move.move_type == MoveType::Promotion)
+    if (move.move_type() == MoveType::Promotion)
     {
         // For promotions, the original piece was a pawn
         moving_piece = make_piece(side_to_move_, PieceType::Pawn);
@@ -568,56 +680,56 @@ void Position::undo_move()
     else
     {
         // For other moves, get the piece from the destination square
-        moving_piece = piece_on(move.to_square);
+        moving_piece = piece_on(move.to_square());
     }
     
     Color color = color_of(moving_piece);
     PieceType type = type_of(moving_piece);
     
     // Handle different move types
-    switch (move.move_type)
+    switch (move.move_type())
     {
         case MoveType::Normal:
         case MoveType::Capture:
             // Remove piece from destination square
-            pieces_[static_cast<int>(color)][static_cast<int>(type)].clear_bit(move.to_square);
-            board_[static_cast<int>(move.to_square)] = Piece::None;
+            pieces_[static_cast<int>(color)][static_cast<int>(type)].clear_bit(move.to_square());
+            board_[static_cast<int>(move.to_square())] = Piece::None;
             
             // Place piece back on source square
-            pieces_[static_cast<int>(color)][static_cast<int>(type)].set_bit(move.from_square);
-            board_[static_cast<int>(move.from_square)] = moving_piece;
+            pieces_[static_cast<int>(color)][static_cast<int>(type)].set_bit(move.from_square());
+            board_[static_cast<int>(move.from_square())] = moving_piece;
             
             // Restore captured piece if any
-            if (move.captured_piece != Piece::None)
+            if (st.captured_piece != Piece::None)
             {
-                Color cap_color = color_of(move.captured_piece);
-                PieceType cap_type = type_of(move.captured_piece);
-                pieces_[static_cast<int>(cap_color)][static_cast<int>(cap_type)].set_bit(move.to_square);
-                board_[static_cast<int>(move.to_square)] = move.captured_piece;
+                Color cap_color = color_of(st.captured_piece);
+                PieceType cap_type = type_of(st.captured_piece);
+                pieces_[static_cast<int>(cap_color)][static_cast<int>(cap_type)].set_bit(move.to_square());
+                board_[static_cast<int>(move.to_square())] = st.captured_piece;
             }
             break;
             
         case MoveType::Castle:
         {
             // Move king back
-            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::King)].clear_bit(move.to_square);
-            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::King)].set_bit(move.from_square);
-            board_[static_cast<int>(move.to_square)] = Piece::None;
-            board_[static_cast<int>(move.from_square)] = moving_piece;
+            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::King)].clear_bit(move.to_square());
+            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::King)].set_bit(move.from_square());
+            board_[static_cast<int>(move.to_square())] = Piece::None;
+            board_[static_cast<int>(move.from_square())] = moving_piece;
             
             // Move rook back
             Square rook_from, rook_to;
-            if (move.to_square == Square::G1)  // White kingside
+            if (move.to_square() == Square::G1)  // White kingside
             {
                 rook_from = Square::F1;
                 rook_to = Square::H1;
             }
-            else if (move.to_square == Square::C1)  // White queenside
+            else if (move.to_square() == Square::C1)  // White queenside
             {
                 rook_from = Square::D1;
                 rook_to = Square::A1;
             }
-            else if (move.to_square == Square::G8)  // Black kingside
+            else if (move.to_square() == Square::G8)  // Black kingside
             {
                 rook_from = Square::F8;
                 rook_to = Square::H8;
@@ -640,47 +752,47 @@ void Position::undo_move()
         case MoveType::EnPassant:
         {
             // Remove pawn from destination square
-            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::Pawn)].clear_bit(move.to_square);
-            board_[static_cast<int>(move.to_square)] = Piece::None;
+            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::Pawn)].clear_bit(move.to_square());
+            board_[static_cast<int>(move.to_square())] = Piece::None;
             
             // Place pawn back on source square
-            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::Pawn)].set_bit(move.from_square);
-            board_[static_cast<int>(move.from_square)] = moving_piece;
+            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::Pawn)].set_bit(move.from_square());
+            board_[static_cast<int>(move.from_square())] = moving_piece;
             
             // Restore captured pawn
             Square captured_pawn_sq;
             if (color == Color::White)
             {
-                captured_pawn_sq = static_cast<Square>(static_cast<int>(move.to_square) - 8);
+                captured_pawn_sq = static_cast<Square>(static_cast<int>(move.to_square()) - 8);
             }
             else
             {
-                captured_pawn_sq = static_cast<Square>(static_cast<int>(move.to_square) + 8);
+                captured_pawn_sq = static_cast<Square>(static_cast<int>(move.to_square()) + 8);
             }
             
             Color enemy_color = opposite_color(color);
             pieces_[static_cast<int>(enemy_color)][static_cast<int>(PieceType::Pawn)].set_bit(captured_pawn_sq);
-            board_[static_cast<int>(captured_pawn_sq)] = move.captured_piece;
+            board_[static_cast<int>(captured_pawn_sq)] = st.captured_piece;
             break;
         }
             
         case MoveType::Promotion:
             // Remove promoted piece from destination square
-            PieceType promo_type = type_of(move.promotion_piece);
-            pieces_[static_cast<int>(color)][static_cast<int>(promo_type)].clear_bit(move.to_square);
-            board_[static_cast<int>(move.to_square)] = Piece::None;
+            PieceType promo_type = type_of(move.promotion_piece());
+            pieces_[static_cast<int>(color)][static_cast<int>(promo_type)].clear_bit(move.to_square());
+            board_[static_cast<int>(move.to_square())] = Piece::None;
             
             // Place pawn back on source square
-            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::Pawn)].set_bit(move.from_square);
-            board_[static_cast<int>(move.from_square)] = make_piece(color, PieceType::Pawn);
+            pieces_[static_cast<int>(color)][static_cast<int>(PieceType::Pawn)].set_bit(move.from_square());
+            board_[static_cast<int>(move.from_square())] = make_piece(color, PieceType::Pawn);
             
             // Restore captured piece if any
-            if (move.captured_piece != Piece::None)
+            if (st.captured_piece != Piece::None)
             {
-                Color cap_color = color_of(move.captured_piece);
-                PieceType cap_type = type_of(move.captured_piece);
-                pieces_[static_cast<int>(cap_color)][static_cast<int>(cap_type)].set_bit(move.to_square);
-                board_[static_cast<int>(move.to_square)] = move.captured_piece;
+                Color cap_color = color_of(st.captured_piece);
+                PieceType cap_type = type_of(st.captured_piece);
+                pieces_[static_cast<int>(cap_color)][static_cast<int>(cap_type)].set_bit(move.to_square());
+                board_[static_cast<int>(move.to_square())] = st.captured_piece;
             }
             break;
     }
@@ -688,17 +800,107 @@ void Position::undo_move()
     // Update aggregate bitboards
     update_bitboards();
     
-    // Remove the move from history
-    move_history_.pop_back();
+    // Restore the hash key and evaluation terms saved before the move
+    hash_key_ = st.hash_key;
+    pawn_key_ = st.pawn_key;
+    psq_score_ = st.psq_score;
+    game_phase_ = st.game_phase;
     
-    // Update hash key (recompute from current position)
-    hash_key_ = ZobristHash::hash_position(*this);
+    // Pop the state off the undo stack
+    state_count_--;
+    
+    assert(hash_key_ == ZobristHash::hash_position(*this));
+    assert(psq_score_ == PieceSquareTable::compute_score(*this));
+}
+
+// Pass the turn
+void Position::make_null_move()
+{
+    assert(!is_in_check());
+    
+    // A full stack drops its oldest entry, as in make_move
+    if (state_count_ == MAX_GAME_PLY)
+    {
+        std::copy(states_ + 1, states_ + MAX_GAME_PLY, states_);
+        state_count_--;
+    }
+    
+    // A null move is recorded as Move() so last_move() reports no move
+    StateInfo& st = states_[state_count_];
+    st.move = Move();
+    st.captured_piece = Piece::None;
+    st.castling_rights = castling_rights_;
+    st.en_passant_square = en_passant_square_;
+    st.halfmove_clock = halfmove_clock_;
+    st.hash_key = hash_key_;
+    st.dirty_count = 0;
+    
+    hash_key_ ^= ZobristHash::en_passant_hash(en_passant_square_);
+    en_passant_square_ = Square::None;
+    halfmove_clock_++;
+    
+    side_to_move_ = opposite_color(side_to_move_);
+    hash_key_ ^= ZobristHash::side_to_move_hash();
+    
+    if (side_to_move_ == Color::White)
+    {
+        fullmove_number_++;
+    }
+    
+    state_count_++;
+    
+    assert(hash_key_ == ZobristHash::hash_position(*this));
+}
+
+// Undo a null move
+void Position::undo_null_move()
+{
+    assert(state_count_ > 0 && states_[state_count_ - 1].move.is_none());
+    
+    const StateInfo& st = states_[state_count_ - 1];
+    
+    side_to_move_ = opposite_color(side_to_move_);
+    if (side_to_move_ == Color::Black)
+    {
+        fullmove_number_--;
+    }
+    
+    en_passant_square_ = st.en_passant_square;
+    halfmove_clock_ = st.halfmove_clock;
+    hash_key_ = st.hash_key;
+    
+    state_count_--;
+    
+    assert(hash_key_ == ZobristHash::hash_position(*this));
+}
+
+uint64_t Position::key_after(const Move& move) const
+{
+    Square from = move.from_square();
+    Square to = move.to_square();
+    Piece moving_piece = piece_on(from);
+    
+    uint64_t key = hash_key_ ^ ZobristHash::side_to_move_hash() ^ ZobristHash::en_passant_hash(en_passant_square_);
+    key ^= ZobristHash::piece_hash(moving_piece, from);
+    
+    if (move.move_type() == MoveType::EnPassant)
+    {
+        Square captured_sq = static_cast<Square>(static_cast<int>(to) + (side_to_move_ == Color::White ? -8 : 8));
+        key ^= ZobristHash::piece_hash(piece_on(captured_sq), captured_sq);
+    }
+    else
+    {
+        key ^= ZobristHash::piece_hash(piece_on(to), to);
+    }
+    
+    Piece placed = (move.move_type() == MoveType::Promotion) ? move.promotion_piece() : moving_piece;
+    return key ^ ZobristHash::piece_hash(placed, to);
 }
 
 // Undo multiple moves
 void Position::undo_moves(int count)
 {
-    for (int i = 0; i < count && !move_history_.empty(); ++i)
+    for (int i = 0; i < count && state_count_ > 0; ++i)
     {
         undo_move();
     }
@@ -86,7 +86,7 @@ bool MoveHandler::is_legal_move(Square from, Square to) const
     // Check if the move is in our pre-generated list
     for (const auto& move : legal_moves_) 
     {
-        if (move.from_square == from && move.to_square == to) 
+        if (move.from_square() == from && move.to_square() == to) 
         {
             return true;
         }
@@ -101,7 +101,7 @@ bool MoveHandler::execute_move(Square from, Square to, Color player_color)
     Move* found_move = nullptr;
     for (auto& move : legal_moves_) 
     {
-        if (move.from_square == from && move.to_square == to) 
+        if (move.from_square() == from && move.to_square() == to) 
         {
             found_move = &move;
             break;
@@ -177,14 +177,15 @@ void MoveHandler::complete_promotion(PieceType promotion_piece_type)
     }
     
     // Get the player color from the pending move
-    Piece moving_piece = chess_position_->piece_on(pending_promotion_move_.from_square);
+    Piece moving_piece = chess_position_->piece_on(pending_promotion_move_.from_square());
     Color player_color = color_of(moving_piece);
     
     // Set the promotion piece
-    pending_promotion_move_.promotion_piece = make_piece(player_color, promotion_piece_type);
+    pending_promotion_move_ = Move(pending_promotion_move_.from_square(), pending_promotion_move_.to_square(),
+                                  MoveType::Promotion, make_piece(player_color, promotion_piece_type));
     
     // Check if this is a capture move before making it
-    bool is_capture = chess_position_->piece_on(pending_promotion_move_.to_square) != Piece::None;
+    bool is_capture = chess_position_->piece_on(pending_promotion_move_.to_square()) != Piece::None;
     
     // Execute the promotion move
     if (variant_position_) 
@@ -355,14 +356,15 @@ void MoveHandler::make_computer_move(Color player_color)
     }
     
     // For computer promotion, promote to queen by default
-    if (is_promotion_move(best_move.from_square, best_move.to_square))
+    if (is_promotion_move(best_move.from_square(), best_move.to_square()))
     {
         Color computer_color = (player_color == Color::White) ? Color::Black : Color::White;
-        best_move.promotion_piece = make_piece(computer_color, PieceType::Queen);
+        best_move = Move(best_move.from_square(), best_move.to_square(), MoveType::Promotion, 
+                         make_piece(computer_color, PieceType::Queen));
     }
     
     // Check if this is a capture move before making it
-    bool is_capture = chess_position_->piece_on(best_move.to_square) != Piece::None;
+    bool is_capture = chess_position_->piece_on(best_move.to_square()) != Piece::None;
     
     // Make the move
     if (variant_position_) 
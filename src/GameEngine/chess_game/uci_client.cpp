@@ -402,12 +402,12 @@ Move UCIClient::parse_move_string(const std::string& move_str, const Position& p
     
     for (const Move& move : legal_moves) 
     {
-        if (move.from_square == from && move.to_square == to) 
+        if (move.from_square() == from && move.to_square() == to) 
         {
             // Check promotion piece if it's a promotion move
-            if (move.move_type == MoveType::Promotion) 
+            if (move.move_type() == MoveType::Promotion) 
             {
-                if (move.promotion_piece == promotion_piece) 
+                if (move.promotion_piece() == promotion_piece) 
                 {
                     return move;
                 }